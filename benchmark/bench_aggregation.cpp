@@ -0,0 +1,102 @@
+#include "benchmark_util.hpp"
+#include "compressed_network.hpp"
+#include "directed_network.hpp"
+#include "neighbour_aggregation.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <string>
+#include <vector>
+
+// Compares the weighted neighbour sum y[i] = sum_j w_ij * x[j] written as a
+// loop over the rows with aggregate_neighbours, for incoming edges (Gather),
+// outgoing edges (Scatter) and for several vectors at once
+// Usage: Bench_Aggregation [n_agents] [n_neighbours] [n_vectors]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t n_neighbours = argc > 2 ? std::stoul(argv[2]) : 16;
+  const size_t n_vectors = argc > 3 ? std::stoul(argv[3]) : 8;
+
+  const auto outgoing = generate_random_directed(n_agents, n_neighbours);
+  auto incoming = outgoing;
+  incoming.toggle_incoming_outgoing();
+  const auto compressed = CompressedNetwork<double>(incoming);
+  fmt::print("Weighted neighbour sum: {} agents, {} edges\n",
+             incoming.n_agents(), incoming.n_edges());
+
+  auto x = std::vector<double>(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    x[i_agent] = double(i_agent % 100) / 100;
+  }
+  std::vector<double> y(n_agents);
+
+  const double loop_time = report("loop over the rows (incoming)", [&]() {
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      const auto neighbours = incoming.get_neighbours(i_agent);
+      const auto weights = incoming.get_weights(i_agent);
+      double sum = 0;
+      for (size_t k = 0; k < neighbours.size(); k++) {
+        sum += weights[k] * x[neighbours[k]];
+      }
+      y[i_agent] = sum;
+    }
+  });
+  report(
+      "loop over the rows (outgoing)",
+      [&]() {
+        std::fill(y.begin(), y.end(), 0.0);
+        for (size_t j_agent = 0; j_agent < n_agents; j_agent++) {
+          const auto neighbours = outgoing.get_neighbours(j_agent);
+          const auto weights = outgoing.get_weights(j_agent);
+          for (size_t k = 0; k < neighbours.size(); k++) {
+            y[neighbours[k]] += weights[k] * x[j_agent];
+          }
+        }
+      },
+      loop_time);
+
+  for (size_t n_threads : thread_counts()) {
+    report(
+        fmt::format("Gather, DirectedNetwork ({} threads)", n_threads),
+        [&]() { aggregate_neighbours(incoming, x, y, n_threads); }, loop_time);
+    report(
+        fmt::format("Gather, CompressedNetwork ({} threads)", n_threads),
+        [&]() {
+          aggregate_neighbours(compressed, AggregationMode::Gather, x, y,
+                               n_threads);
+        },
+        loop_time);
+    report(
+        fmt::format("Scatter, DirectedNetwork ({} threads)", n_threads),
+        [&]() { aggregate_neighbours(outgoing, x, y, n_threads); }, loop_time);
+  }
+
+  fmt::print("{} vectors at once\n", n_vectors);
+  auto x_batch = std::vector<double>(n_agents * n_vectors);
+  for (size_t i = 0; i < x_batch.size(); i++) {
+    x_batch[i] = double(i % 101) / 101;
+  }
+  std::vector<double> y_batch(n_agents * n_vectors);
+  const double single_time = report(
+      fmt::format("{} x Gather, CompressedNetwork", n_vectors), [&]() {
+        for (size_t i_vector = 0; i_vector < n_vectors; i_vector++) {
+          aggregate_neighbours(compressed, AggregationMode::Gather, x, y);
+        }
+      });
+  report(
+      "Gather batch, CompressedNetwork",
+      [&]() {
+        aggregate_neighbours_batch(compressed, AggregationMode::Gather,
+                                   x_batch, y_batch, n_vectors);
+      },
+      single_time);
+  report(
+      "Scatter batch, DirectedNetwork",
+      [&]() {
+        aggregate_neighbours_batch(outgoing, x_batch, y_batch, n_vectors);
+      },
+      single_time);
+}
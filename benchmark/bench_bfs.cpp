@@ -0,0 +1,75 @@
+#include "benchmark_util.hpp"
+#include "bfs_workspace.hpp"
+#include "network_operations.hpp"
+#include <cstddef>
+#include <fmt/format.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares BFS from many sources, one source at a time and in batches, and
+// depth-limited BFS queries with fresh buffers and with a BfsWorkspace
+// Usage: Bench_BFS [n_agents] [n_neighbours] [n_sources]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 100000;
+  const size_t n_neighbours = argc > 2 ? std::stoul(argv[2]) : 8;
+  const size_t n_sources = argc > 3 ? std::stoul(argv[3]) : 256;
+
+  const auto network = generate_random_directed(n_agents, n_neighbours);
+  fmt::print("BFS from {} sources: {} agents, {} edges\n", n_sources,
+             network.n_agents(), network.n_edges());
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  std::vector<size_t> sources{};
+  for (size_t i_source = 0; i_source < n_sources; i_source++) {
+    sources.push_back(dist_agent(gen));
+  }
+
+  const double bfs_time = report(
+      "bfs for each source",
+      [&]() {
+        for (size_t source : sources) {
+          auto depth_level =
+              std::vector<size_t>(n_agents, invalid_index<size_t>);
+          auto parent = std::vector<std::vector<size_t>>(n_agents);
+          bfs(network, parent, depth_level, source, std::nullopt);
+        }
+      },
+      0, 1);
+
+  report(
+      "bfs_multi_source (64 sources per batch)",
+      [&]() { bfs_multi_source<1>(network, sources, std::nullopt); },
+      bfs_time);
+  report(
+      "bfs_multi_source (256 sources per batch)",
+      [&]() { bfs_multi_source<4>(network, sources, std::nullopt); },
+      bfs_time);
+
+  const size_t max_depth = 2;
+  fmt::print("BFS up to depth {} from {} sources\n", max_depth, n_sources);
+  const double fresh_time = report(
+      "bfs with fresh buffers",
+      [&]() {
+        for (size_t source : sources) {
+          auto depth_level =
+              std::vector<size_t>(n_agents, invalid_index<size_t>);
+          auto parent = std::vector<std::vector<size_t>>(n_agents);
+          bfs(network, parent, depth_level, source, max_depth);
+        }
+      });
+
+  auto workspace = BfsWorkspace(n_agents);
+  report(
+      "BfsWorkspace",
+      [&]() {
+        for (size_t source : sources) {
+          workspace.bfs(network, source, max_depth);
+        }
+      },
+      fresh_time);
+}
@@ -0,0 +1,67 @@
+#include "benchmark_util.hpp"
+#include "directed_network.hpp"
+#include "edge_list_builder.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares building a network from an edge list with the EdgeListBuilder to
+// push_back per edge followed by remove_double_counting
+// Usage: Bench_Builder [n_agents] [n_edges]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+  using WeightT = double;
+  using IndexT = uint32_t;
+  using EdgeDirection = DirectedNetwork<WeightT, IndexT>::EdgeDirection;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t n_edges = argc > 2 ? std::stoul(argv[2]) : 20000000;
+
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<IndexT> dist_agent(0, n_agents - 1);
+  std::uniform_real_distribution<WeightT> dist_weight(0.0, 1.0);
+  std::vector<IndexT> sources(n_edges);
+  std::vector<IndexT> targets(n_edges);
+  std::vector<WeightT> weights(n_edges);
+  for (size_t i_edge = 0; i_edge < n_edges; i_edge++) {
+    sources[i_edge] = dist_agent(gen);
+    targets[i_edge] = dist_agent(gen);
+    weights[i_edge] = dist_weight(gen);
+  }
+  fmt::print("Building a network: {} agents, {} edges\n", n_agents, n_edges);
+
+  const double push_back_time = report(
+      "push_back + remove_double_counting",
+      [&]() {
+        auto network = DirectedNetwork<WeightT, IndexT>(n_agents);
+        for (size_t i_edge = 0; i_edge < n_edges; i_edge++) {
+          network.push_back_neighbour_and_weight(
+              sources[i_edge], targets[i_edge], weights[i_edge]);
+        }
+        network.remove_double_counting(1);
+      },
+      0, 3);
+
+  auto builder = EdgeListBuilder<WeightT, IndexT>(n_agents);
+  builder.add_edges(sources, targets, weights);
+  for (size_t n_threads : thread_counts()) {
+    report(
+        fmt::format("build_directed ({} threads)", n_threads),
+        [&]() {
+          auto network = builder.build_directed(
+              WeightMerge::Sum, EdgeDirection::Outgoing, n_threads);
+        },
+        push_back_time, 3);
+    report(
+        fmt::format("build_compressed_directed ({} threads)", n_threads),
+        [&]() {
+          auto network = builder.build_compressed_directed(
+              WeightMerge::Sum, EdgeDirection::Outgoing, n_threads);
+        },
+        push_back_time, 3);
+  }
+}
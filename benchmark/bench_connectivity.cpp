@@ -0,0 +1,30 @@
+#include "benchmark_util.hpp"
+#include "connectivity.hpp"
+#include "directed_network.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <string>
+
+// Compares the multi-threaded SCC algorithm with Tarjan's algorithm
+// Usage: Bench_Connectivity [n_agents] [n_neighbours]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t n_neighbours = argc > 2 ? std::stoul(argv[2]) : 4;
+
+  const auto network = generate_random_directed(n_agents, n_neighbours);
+  fmt::print("Strongly connected components: {} agents, {} edges\n",
+             network.n_agents(), network.n_edges());
+
+  const double tarjan_time = report(
+      "TarjanConnectivityAlgo", [&]() { TarjanConnectivityAlgo{network}; });
+
+  for (size_t n_threads : thread_counts()) {
+    report(
+        fmt::format("ParallelConnectivityAlgo ({} threads)", n_threads),
+        [&]() { ParallelConnectivityAlgo(network, n_threads); }, tarjan_time);
+  }
+}
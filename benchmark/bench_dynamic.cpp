@@ -0,0 +1,88 @@
+#include "benchmark_util.hpp"
+#include "directed_network.hpp"
+#include "dynamic_network.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares the time per step of a model which changes n_changes edges in
+// every step: inserting them into a DirectedNetwork followed by
+// remove_double_counting, with batches of changes to a DynamicNetwork
+// (including the compactions they trigger), for networks of several sizes
+// Usage: Bench_Dynamic [n_changes] [n_neighbours] [n_steps]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+  using Edge = DynamicNetwork<double>::Edge;
+
+  const size_t n_changes = argc > 1 ? std::stoul(argv[1]) : 1000;
+  const size_t n_neighbours = argc > 2 ? std::stoul(argv[2]) : 16;
+  const size_t n_steps = argc > 3 ? std::stoul(argv[3]) : 100;
+
+  for (size_t n_agents : {100000, 1000000}) {
+    const auto initial = generate_random_directed(n_agents, n_neighbours);
+    fmt::print("{} agents, {} edges, {} changes per step\n", n_agents,
+               initial.n_edges(), n_changes);
+
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+    auto random_batch = [&]() {
+      std::vector<Edge> batch(n_changes);
+      for (auto &edge : batch) {
+        edge = {dist_agent(gen), dist_agent(gen), 1.0};
+      }
+      return batch;
+    };
+
+    // Only a few steps, as every step goes through the whole network
+    auto directed = initial;
+    auto batch = random_batch();
+    const double directed_time = report(
+        "  DirectedNetwork: insert + dedup",
+        [&]() {
+          for (const auto &edge : batch) {
+            directed.push_back_neighbour_and_weight(edge.source, edge.target,
+                                                    edge.weight);
+          }
+          directed.remove_double_counting(1);
+        },
+        0, 3);
+
+    auto dynamic = DynamicNetwork<double>(initial, 1);
+    std::vector<std::vector<Edge>> batches(n_steps);
+    for (auto &step_batch : batches) {
+      step_batch = random_batch();
+    }
+    const double insert_time =
+        median(time_function(
+            [&]() {
+              for (const auto &step_batch : batches) {
+                dynamic.insert_edges(step_batch, 1);
+              }
+            },
+            1)) /
+        n_steps;
+    fmt::print("{:<40} {:>10.6f} s   speedup {:>6.0f}x\n",
+               "  DynamicNetwork: insert", insert_time,
+               directed_time / insert_time);
+
+    // Rewiring: the inserted edges of a step are removed again later
+    const double rewire_time =
+        median(time_function(
+            [&]() {
+              for (size_t step = 0; step < n_steps; step++) {
+                dynamic.remove_edges(batches[step], 1);
+                dynamic.insert_edges(batches[(step + 1) % n_steps], 1);
+              }
+            },
+            1)) /
+        n_steps;
+    fmt::print("{:<40} {:>10.6f} s\n", "  DynamicNetwork: remove + insert",
+               rewire_time);
+
+    report("  DynamicNetwork: compact", [&]() { dynamic.compact(1); }, 0, 1);
+  }
+}
@@ -0,0 +1,75 @@
+#include "benchmark_util.hpp"
+#include "generators.hpp"
+#include <cstddef>
+#include <fmt/format.h>
+#include <string>
+#include <vector>
+
+// Throughput of the random network generators, compared to building a random
+// directed network row by row with std::mt19937 (generate_random_directed)
+// Usage: Bench_Generators [n_agents] [mean_degree]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+  using WeightT = double;
+  using IndexT = uint32_t;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t mean_degree = argc > 2 ? std::stoul(argv[2]) : 16;
+  const double p = double(mean_degree) / (n_agents - 1);
+  fmt::print("Generating networks: {} agents, mean degree {}\n", n_agents,
+             mean_degree);
+
+  // Prints the median time and the number of generated edges per second
+  auto report_rate = [&](const std::string &name, auto &&generate) {
+    size_t n_edges = 0;
+    const double time = median(
+        time_function([&]() { n_edges = generate().n_edges(); }, 3));
+    fmt::print("{:<40} {:>10.4f} s {:>12.3e} edges/s\n", name, time,
+               n_edges / time);
+  };
+
+  report_rate("generate_random_directed (mt19937)", [&]() {
+    return generate_random_directed<WeightT>(n_agents, mean_degree);
+  });
+
+  const std::vector<size_t> block_sizes(8, n_agents / 8);
+  std::vector<std::vector<double>> probabilities(
+      8, std::vector<double>(8, 0.2 * p));
+  for (size_t a = 0; a < 8; a++) {
+    probabilities[a][a] = 6.0 * p;
+  }
+
+  for (size_t n_threads : thread_counts()) {
+    report_rate(
+        fmt::format("Erdos-Renyi directed ({} threads)", n_threads),
+        [&]() {
+          return generate_erdos_renyi_directed<WeightT, IndexT>(
+              n_agents, p, 1, 1.0, n_threads);
+        });
+    report_rate(
+        fmt::format("Erdos-Renyi undirected ({} threads)", n_threads),
+        [&]() {
+          return generate_erdos_renyi_undirected<WeightT, IndexT>(
+              n_agents, p, 1, 1.0, n_threads);
+        });
+    report_rate(
+        fmt::format("stochastic block model ({} threads)", n_threads),
+        [&]() {
+          return generate_stochastic_block_model<WeightT, IndexT>(
+              block_sizes, probabilities, 1, 1.0, n_threads);
+        });
+    report_rate(
+        fmt::format("Barabasi-Albert ({} threads)", n_threads),
+        [&]() {
+          return generate_barabasi_albert<WeightT, IndexT>(
+              n_agents, mean_degree / 2, 1, 1.0, n_threads);
+        });
+    report_rate(
+        fmt::format("Watts-Strogatz ({} threads)", n_threads),
+        [&]() {
+          return generate_watts_strogatz<WeightT, IndexT>(
+              n_agents, mean_degree, 0.1, 1, 1.0, n_threads);
+        });
+  }
+}
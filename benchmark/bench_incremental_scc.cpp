@@ -0,0 +1,86 @@
+#include "benchmark_util.hpp"
+#include "connectivity.hpp"
+#include "directed_network.hpp"
+#include "incremental_scc.hpp"
+#include <cstddef>
+#include <fmt/format.h>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares the time per step of a pipeline which inserts n_changes edges and
+// then queries the SCCs: running Tarjan's algorithm on the whole network
+// after every step, with keeping the SCCs up to date in an IncrementalSCC.
+// Removing the edges of a step again is timed as well
+// Usage: Bench_Incremental_SCC [n_changes] [n_neighbours] [n_steps]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+  using Edge = IncrementalSCC<size_t>::Edge;
+
+  const size_t n_changes = argc > 1 ? std::stoul(argv[1]) : 100;
+  const size_t n_neighbours = argc > 2 ? std::stoul(argv[2]) : 1;
+  const size_t n_steps = argc > 3 ? std::stoul(argv[3]) : 100;
+
+  for (size_t n_agents : {100000, 1000000}) {
+    const auto initial = generate_random_directed(n_agents, n_neighbours);
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+    std::vector<std::vector<Edge>> batches(n_steps);
+    for (auto &batch : batches) {
+      batch.resize(n_changes);
+      for (auto &edge : batch) {
+        edge = {dist_agent(gen), dist_agent(gen)};
+      }
+    }
+
+    // Only a few steps, as every step goes through the whole network
+    auto directed = initial;
+    size_t n_components = 0;
+    const double tarjan_time = report(
+        "  Tarjan after every step",
+        [&]() {
+          for (const auto &edge : batches[0]) {
+            directed.push_back_neighbour_and_weight(edge.source, edge.target,
+                                                    1.0);
+          }
+          n_components = TarjanConnectivityAlgo(directed).scc_list.size();
+        },
+        0, 3);
+    fmt::print("{} agents, {} edges, {} components, {} changes per step\n",
+               n_agents, initial.n_edges(), n_components, n_changes);
+
+    auto scc = IncrementalSCC<size_t>(1);
+    report("  IncrementalSCC: build", [&]() { scc = IncrementalSCC(initial); },
+           0, 1);
+    const double insert_time =
+        median(time_function(
+            [&]() {
+              for (const auto &batch : batches) {
+                scc.insert_edges(batch);
+              }
+            },
+            1)) /
+        n_steps;
+    fmt::print("{:<40} {:>10.6f} s   speedup {:>6.0f}x\n",
+               "  IncrementalSCC: insert", insert_time,
+               tarjan_time / insert_time);
+    fmt::print("  {} components after {} steps\n", scc.n_components(),
+               n_steps);
+
+    const double remove_time =
+        median(time_function(
+            [&]() {
+              for (size_t step = n_steps; step-- > 0;) {
+                scc.remove_edges(batches[step]);
+              }
+            },
+            1)) /
+        n_steps;
+    fmt::print("{:<40} {:>10.6f} s   speedup {:>6.0f}x\n",
+               "  IncrementalSCC: remove", remove_time,
+               tarjan_time / remove_time);
+    fmt::print("  {} components after removing them again\n",
+               scc.n_components());
+  }
+}
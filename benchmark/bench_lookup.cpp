@@ -0,0 +1,64 @@
+#include "benchmark_util.hpp"
+#include "directed_network.hpp"
+#include <cstddef>
+#include <fmt/format.h>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Lookup throughput of connection_exists against hub agents, with a linear
+// scan, in sorted adjacency mode, and with a hash index on the hubs
+// Usage: Bench_Lookup [n_agents] [hub_degree] [n_hubs]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+  using WeightT = double;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t hub_degree = argc > 2 ? std::stoul(argv[2]) : 100000;
+  const size_t n_hubs = argc > 3 ? std::stoul(argv[3]) : 10;
+
+  // Agents with 8 random neighbours, and hubs connected to hub_degree agents
+  auto network = generate_random_directed<WeightT>(n_agents, 8);
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  for (size_t i_hub = 0; i_hub < n_hubs; i_hub++) {
+    for (size_t i_edge = 0; i_edge < hub_degree; i_edge++) {
+      network.push_back_neighbour_and_weight(i_hub, dist_agent(gen), 1.0);
+    }
+  }
+  fmt::print("connection_exists: {} agents, {} edges, {} hubs of degree {}\n",
+             network.n_agents(), network.n_edges(), n_hubs, hub_degree);
+
+  // Queries from a hub (every other query) or a random agent
+  auto make_queries = [&](size_t n_queries) {
+    std::vector<std::pair<size_t, size_t>> queries{};
+    for (size_t i_query = 0; i_query < n_queries; i_query++) {
+      const size_t i = i_query % 2 == 0 ? i_query % n_hubs : dist_agent(gen);
+      queries.push_back({i, dist_agent(gen)});
+    }
+    return queries;
+  };
+
+  size_t n_found = 0;
+  auto report_throughput = [&](const std::string &name, size_t n_queries) {
+    const auto queries = make_queries(n_queries);
+    const double time = median(time_function([&]() {
+      for (const auto &[i, j] : queries) {
+        n_found += network.connection_exists(i, j) ? 1 : 0;
+      }
+    }));
+    fmt::print("{:<40} {:>12.3e} lookups/s\n", name, n_queries / time);
+  };
+
+  report_throughput("linear scan", 20000);
+
+  network.set_sorted_adjacency(true);
+  report_throughput("sorted adjacency (binary search)", 2000000);
+
+  network.set_hash_index(1024);
+  report_throughput("sorted adjacency + hash index on hubs", 2000000);
+
+  fmt::print("({} lookups found an edge)\n", n_found);
+}
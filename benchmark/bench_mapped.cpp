@@ -0,0 +1,81 @@
+#include "benchmark_util.hpp"
+#include "directed_network.hpp"
+#include "mapped_network.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <string>
+
+// Startup cost of a network: reading a text edge list, compared to mapping a
+// binary network file (with and without checking the rows, and with touching
+// every row afterwards)
+// Usage: Bench_Mapped [n_agents] [n_neighbours]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+  using WeightT = double;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t n_neighbours = argc > 2 ? std::stoul(argv[2]) : 8;
+
+  auto network = generate_random_directed<WeightT>(n_agents, n_neighbours);
+  const auto directory = std::filesystem::temp_directory_path();
+  const std::string text_path = (directory / "graph_lib_bench.txt").string();
+  const std::string binary_path = (directory / "graph_lib_bench.bin").string();
+  {
+    std::ofstream text_file(text_path);
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      const auto neighbours = network.get_neighbours(i_agent);
+      const auto weights = network.get_weights(i_agent);
+      for (size_t i_edge = 0; i_edge < neighbours.size(); i_edge++) {
+        text_file << i_agent << ' ' << neighbours[i_edge] << ' '
+                  << weights[i_edge] << '\n';
+      }
+    }
+  }
+  fmt::print("Network startup: {} agents, {} edges\n", network.n_agents(),
+             network.n_edges());
+
+  const double text_time = report(
+      "read text edge list",
+      [&]() {
+        auto read_network = DirectedNetwork<WeightT>(n_agents);
+        std::ifstream text_file(text_path);
+        size_t i = 0;
+        size_t j = 0;
+        WeightT w = 0;
+        while (text_file >> i >> j >> w) {
+          read_network.push_back_neighbour_and_weight(i, j, w);
+        }
+      },
+      0, 3);
+
+  report("write_binary_network",
+         [&]() { write_binary_network(network, binary_path); });
+
+  report(
+      "MappedNetwork (open)",
+      [&]() { auto mapped = MappedNetwork<WeightT>(binary_path); }, text_time);
+  report(
+      "MappedNetwork (open without checking rows)",
+      [&]() { auto mapped = MappedNetwork<WeightT>(binary_path, false); },
+      text_time);
+
+  WeightT total_weight = 0;
+  report(
+      "MappedNetwork (open + read every row)",
+      [&]() {
+        auto mapped = MappedNetwork<WeightT>(binary_path);
+        for (size_t i_agent = 0; i_agent < mapped.n_agents(); i_agent++) {
+          for (WeightT w : mapped.get_weights(i_agent)) {
+            total_weight += w;
+          }
+        }
+      },
+      text_time);
+  fmt::print("(total weight {:.3f})\n", total_weight);
+
+  std::filesystem::remove(text_path);
+  std::filesystem::remove(binary_path);
+}
@@ -0,0 +1,79 @@
+#include "benchmark_util.hpp"
+#include "directed_network.hpp"
+#include "edge_list_reader.hpp"
+#include <cstddef>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <string>
+
+// Loading a text edge list with iostreams and push_back, compared to the
+// chunked EdgeListReader (with and without remapping the node IDs)
+// Usage: Bench_Reader [n_agents] [n_neighbours]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+  using WeightT = double;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t n_neighbours = argc > 2 ? std::stoul(argv[2]) : 8;
+
+  auto network = generate_random_directed<WeightT>(n_agents, n_neighbours);
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "graph_lib_bench_reader.txt")
+          .string();
+  {
+    std::ofstream text_file(path);
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      const auto neighbours = network.get_neighbours(i_agent);
+      const auto weights = network.get_weights(i_agent);
+      for (size_t i_edge = 0; i_edge < neighbours.size(); i_edge++) {
+        text_file << i_agent << ' ' << neighbours[i_edge] << ' '
+                  << weights[i_edge] << '\n';
+      }
+    }
+  }
+  fmt::print("Reading an edge list: {} agents, {} edges, {:.1f} MB\n",
+             network.n_agents(), network.n_edges(),
+             std::filesystem::file_size(path) / 1e6);
+
+  const double iostream_time = report(
+      "iostream + push_back + rdc",
+      [&]() {
+        auto read_network = DirectedNetwork<WeightT>(n_agents);
+        std::ifstream text_file(path);
+        size_t i = 0;
+        size_t j = 0;
+        WeightT w = 0;
+        while (text_file >> i >> j >> w) {
+          read_network.push_back_neighbour_and_weight(i, j, w);
+        }
+        read_network.remove_double_counting(1);
+      },
+      0, 3);
+
+  for (size_t n_threads : thread_counts()) {
+    auto options = EdgeListReadOptions<WeightT>{};
+    options.n_threads = n_threads;
+    report(
+        fmt::format("EdgeListReader ({} threads)", n_threads),
+        [&]() {
+          auto reader = EdgeListReader<WeightT>(options);
+          reader.read(path);
+          auto read_network = reader.build_directed();
+        },
+        iostream_time, 3);
+
+    options.remap_ids = true;
+    report(
+        fmt::format("EdgeListReader, remapped ({} threads)", n_threads),
+        [&]() {
+          auto reader = EdgeListReader<WeightT>(options);
+          reader.read(path);
+          auto read_network = reader.build_directed();
+        },
+        iostream_time, 3);
+  }
+
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,83 @@
+#include "benchmark_util.hpp"
+#include "generators.hpp"
+#include "neighbour_aggregation.hpp"
+#include "network_operations.hpp"
+#include "reordering.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fmt/format.h>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// Compares the weighted neighbour sum (aggregate_neighbours) and a BFS on
+// networks whose agents are numbered at random (as they come from an
+// upstream database) with the same networks after reordering them
+// Usage: Bench_Reordering [n_agents] [n_links]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+  using NetworkT = CompressedNetwork<double, uint32_t>;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t n_links = argc > 2 ? std::stoul(argv[2]) : 8;
+  const size_t n_edge = std::sqrt(double(n_agents));
+
+  auto bench_family = [&](const std::string &family, const NetworkT &network) {
+    std::vector<size_t> order(network.n_agents());
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 gen(42);
+    std::shuffle(order.begin(), order.end(), gen);
+    const auto shuffled =
+        permute_agents(network, permutation_from_order(std::move(order)));
+    fmt::print("{}: {} agents, {} stored edges, shuffled\n", family,
+               shuffled.n_agents(), shuffled.n_edges());
+
+    auto x = std::vector<double>(shuffled.n_agents());
+    for (size_t i_agent = 0; i_agent < x.size(); i_agent++) {
+      x[i_agent] = double(i_agent % 100) / 100;
+    }
+    std::vector<double> y{};
+    std::vector<uint32_t> depth_level(shuffled.n_agents());
+    auto run_bfs = [&](const NetworkT &reordered, size_t source) {
+      std::fill(depth_level.begin(), depth_level.end(),
+                invalid_index<uint32_t>);
+      bfs_parallel(reordered, depth_level, source, std::nullopt, 1);
+    };
+
+    const double spmv_time = report("  SpMV, shuffled", [&]() {
+      aggregate_neighbours(shuffled, AggregationMode::Gather, x, y, 1);
+    });
+    const double bfs_time =
+        report("  BFS, shuffled", [&]() { run_bfs(shuffled, 0); });
+
+    auto bench_order = [&](const std::string &name, auto &&compute_order) {
+      Permutation permutation{};
+      report(fmt::format("  {} order", name),
+             [&]() { permutation = compute_order(); }, 0, 1);
+      const auto reordered = permute_agents(shuffled, permutation);
+      const auto x_reordered = permute_values(x, permutation);
+      report(
+          fmt::format("  SpMV, {} order", name),
+          [&]() {
+            aggregate_neighbours(reordered, AggregationMode::Gather,
+                                 x_reordered, y, 1);
+          },
+          spmv_time);
+      report(
+          fmt::format("  BFS, {} order", name),
+          [&]() { run_bfs(reordered, permutation.forward[0]); }, bfs_time);
+    };
+    bench_order("degree", [&]() { return degree_order(shuffled); });
+    bench_order("RCM", [&]() { return reverse_cuthill_mckee_order(shuffled); });
+    bench_order("community", [&]() { return community_order(shuffled); });
+  };
+
+  bench_family("Barabasi-Albert",
+               generate_barabasi_albert<double, uint32_t>(n_agents, n_links));
+  bench_family("Periodic lattice",
+               generate_periodic_lattice<double, uint32_t>(n_edge));
+}
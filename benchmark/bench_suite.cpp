@@ -0,0 +1,334 @@
+#include "benchmark_util.hpp"
+#include "directed_network.hpp"
+#include "generators.hpp"
+#include "network_generation.hpp"
+#include "network_operations.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <fmt/format.h>
+#include <functional>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Runs the hot paths of the library (bfs, strongly_connected_components,
+// toggle_incoming_outgoing, remove_double_counting and connection_exists) on
+// several network families and sizes. For every operation, it prints the
+// throughput, the latency distribution over the runs and the peak memory
+// while it ran (with the network it runs on). If json_path is given ("-" for
+// the standard output, in which case the table goes to the standard error),
+// the results are also written as JSON, to compare the runs of two releases
+// Usage: Bench_Suite [json_path] [max_edges] [n_threads]
+
+using namespace Graph;
+using namespace Graph::Benchmark;
+using NetworkT = DirectedNetwork<double>;
+
+// A family of networks, generate gives a network with about n_edges edges
+struct NetworkFamily {
+  std::string name;
+  std::function<NetworkT(size_t)> generate;
+};
+
+// The measured runs of one operation on one network
+struct SuiteResult {
+  std::string family;
+  size_t n_agents = 0;
+  size_t n_edges = 0;
+  std::string operation;
+  // The number of items one run processes, and what they are (e.g. edges)
+  double n_items = 0;
+  std::string item_unit;
+  LatencySummary latency{};
+  // Peak memory of the process while the operation ran, see reset_peak_rss
+  size_t peak_rss_bytes = 0;
+
+  double throughput() const { return n_items / latency.p50; }
+};
+
+// Runs func (after setup, which is not timed) at least min_runs times, and
+// more often until the runs took min_seconds in total or max_runs is reached
+template <typename SetupFunc, typename Func>
+std::vector<double> time_adaptive(SetupFunc &&setup, Func &&func,
+                                  size_t min_runs = 3, size_t max_runs = 100,
+                                  double min_seconds = 0.5) {
+  std::vector<double> times{};
+  double total_time = 0;
+  while (times.size() < min_runs ||
+         (times.size() < max_runs && total_time < min_seconds)) {
+    times.push_back(time_function_with_setup(setup, func, 1).front());
+    total_time += times.back();
+  }
+  return times;
+}
+
+// Barabasi-Albert network with 4 links per new agent. Both halves of every
+// edge are stored, so every agent has at least 4 edges
+NetworkT generate_scale_free(size_t n_edges) {
+  const size_t n_links = 4;
+  const auto compressed = generate_barabasi_albert<double>(
+      std::max(n_edges / (2 * n_links), n_links + 1), n_links, 42);
+
+  std::vector<std::vector<size_t>> neighbour_list(compressed.n_agents());
+  std::vector<std::vector<double>> weight_list(compressed.n_agents());
+  for (size_t i_agent = 0; i_agent < compressed.n_agents(); i_agent++) {
+    const auto neighbours = compressed.get_neighbours(i_agent);
+    const auto weights = compressed.get_weights(i_agent);
+    neighbour_list[i_agent].assign(neighbours.begin(), neighbours.end());
+    weight_list[i_agent].assign(weights.begin(), weights.end());
+  }
+  return NetworkT(std::move(neighbour_list), std::move(weight_list),
+                  NetworkT::EdgeDirection::Outgoing);
+}
+
+// Copy of the network in which every edge is stored twice
+NetworkT with_doubled_edges(const NetworkT &network) {
+  auto doubled = network;
+  for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+    const auto neighbours = network.get_neighbours(i_agent);
+    const auto weights = network.get_weights(i_agent);
+    for (size_t i_neighbour = 0; i_neighbour < neighbours.size();
+         i_neighbour++) {
+      doubled.push_back_neighbour_and_weight(i_agent, neighbours[i_neighbour],
+                                             weights[i_neighbour]);
+    }
+  }
+  return doubled;
+}
+
+std::string format_seconds(double time) {
+  if (time >= 1) {
+    return fmt::format("{:.3f} s", time);
+  } else if (time >= 1e-3) {
+    return fmt::format("{:.3f} ms", time * 1e3);
+  } else if (time >= 1e-6) {
+    return fmt::format("{:.3f} us", time * 1e6);
+  }
+  return fmt::format("{:.1f} ns", time * 1e9);
+}
+
+void print_result(std::FILE *log, const SuiteResult &result) {
+  fmt::print(log,
+             "  {:<42} {:>10.3e} {:<9} p50 {:>10}  p90 {:>10}  p99 {:>10}  "
+             "peak RSS {:>8.1f} MiB\n",
+             result.operation, result.throughput(), result.item_unit + "/s",
+             format_seconds(result.latency.p50),
+             format_seconds(result.latency.p90),
+             format_seconds(result.latency.p99),
+             result.peak_rss_bytes / (1024.0 * 1024.0));
+}
+
+// Runs every operation on a network of the family with about target_edges
+// edges, and prints the results to log. The peak memory is reset after every
+// operation, so that each result only has the peak of its own runs
+std::vector<SuiteResult> run_operations(const NetworkFamily &family,
+                                        size_t target_edges,
+                                        std::optional<size_t> n_threads,
+                                        std::FILE *log) {
+  auto network = family.generate(target_edges);
+  const size_t n_agents = network.n_agents();
+  const size_t n_edges = network.n_edges();
+  fmt::print(log, "{}: {} agents, {} edges\n", family.name, n_agents, n_edges);
+  reset_peak_rss();
+
+  std::vector<SuiteResult> results{};
+  auto add_result = [&](const std::string &operation, double n_items,
+                        const std::string &item_unit,
+                        const std::vector<double> &times) {
+    results.push_back({family.name, n_agents, n_edges, operation, n_items,
+                       item_unit, summarize(times), peak_rss_bytes()});
+    print_result(log, results.back());
+    reset_peak_rss();
+  };
+  auto no_setup = []() {};
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+
+  // Every run searches from another source, with fresh buffers
+  std::vector<std::vector<size_t>> parent{};
+  std::vector<size_t> depth_level{};
+  size_t source = 0;
+  add_result("bfs", n_edges, "edges",
+             time_adaptive(
+                 [&]() {
+                   parent.assign(n_agents, std::vector<size_t>{});
+                   depth_level.assign(n_agents, invalid_index<size_t>);
+                   source = dist_agent(gen);
+                 },
+                 [&]() {
+                   bfs(network, parent, depth_level, source, std::nullopt);
+                 }));
+  parent = {};
+  depth_level = {};
+
+  add_result("strongly_connected_components", n_edges, "edges",
+             time_adaptive(no_setup, [&]() {
+               (void)network.strongly_connected_components();
+             }));
+  add_result("strongly_connected_components (parallel)", n_edges, "edges",
+             time_adaptive(no_setup, [&]() {
+               (void)network.strongly_connected_components(
+                   n_threads.value_or(0));
+             }));
+
+  // Every run toggles the direction back
+  add_result("toggle_incoming_outgoing", n_edges, "edges",
+             time_adaptive(no_setup, [&]() {
+               network.toggle_incoming_outgoing(n_threads);
+             }));
+
+  // Every run merges the edges of a fresh copy
+  {
+    const auto doubled = with_doubled_edges(network);
+    auto merged = NetworkT{};
+    add_result(
+        "remove_double_counting", doubled.n_edges(), "edges",
+        time_adaptive([&]() { merged = doubled; },
+                      [&]() { merged.remove_double_counting(n_threads); }));
+  }
+
+  // The latency per query, from batches of queries of which half are edges
+  // of the network
+  const size_t n_queries = 4096;
+  std::vector<std::pair<size_t, size_t>> queries(n_queries);
+  size_t n_found = 0;
+  auto query_times = time_adaptive(
+      [&]() {
+        for (auto &[i_agent, j_agent] : queries) {
+          i_agent = dist_agent(gen);
+          j_agent = dist_agent(gen);
+          const auto neighbours = network.get_neighbours(i_agent);
+          if (gen() % 2 == 0 && !neighbours.empty()) {
+            j_agent = neighbours[gen() % neighbours.size()];
+          }
+        }
+      },
+      [&]() {
+        for (const auto &[i_agent, j_agent] : queries) {
+          n_found += network.connection_exists(i_agent, j_agent);
+        }
+      });
+  for (double &time : query_times) {
+    time /= n_queries;
+  }
+  add_result("connection_exists", 1, "queries", query_times);
+  // Keeps the queries from being optimized away
+  volatile size_t sink = n_found;
+  (void)sink;
+
+  return results;
+}
+
+// Gives the text as a JSON string, with quotes and escapes
+std::string json_string(const std::string &text) {
+  std::string quoted = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+// Gives the number in JSON with 6 significant digits, or null if JSON cannot
+// represent it
+std::string json_number(double value) {
+  return std::isfinite(value) ? fmt::format("{:.6g}", value) : "null";
+}
+
+// Writes the results with one line per result, so that the files of two runs
+// can be compared with diff
+void write_json(std::FILE *file, const std::vector<SuiteResult> &results,
+                size_t max_edges, size_t n_threads, bool rss_per_operation) {
+  fmt::print(file, "{{\n");
+  fmt::print(file, "  \"compiler\": {},\n", json_string(__VERSION__));
+  fmt::print(file, "  \"hardware_threads\": {},\n",
+             std::thread::hardware_concurrency());
+  fmt::print(file, "  \"n_threads\": {},\n", n_threads);
+  fmt::print(file, "  \"max_edges\": {},\n", max_edges);
+  // Otherwise peak_rss_bytes is the peak of the process up to that result
+  fmt::print(file, "  \"peak_rss_per_operation\": {},\n", rss_per_operation);
+  fmt::print(file, "  \"results\": [\n");
+  for (size_t i_result = 0; i_result < results.size(); i_result++) {
+    const auto &result = results[i_result];
+    const auto &latency = result.latency;
+    fmt::print(file,
+               "    {{\"family\": {}, \"n_agents\": {}, \"n_edges\": {}, "
+               "\"operation\": {}, \"throughput\": {}, "
+               "\"throughput_unit\": {}, \"latency_seconds\": {{\"n_runs\": "
+               "{}, \"min\": {}, \"p50\": {}, \"p90\": {}, \"p99\": {}, "
+               "\"max\": {}, \"mean\": {}}}, \"peak_rss_bytes\": {}}}{}\n",
+               json_string(result.family), result.n_agents, result.n_edges,
+               json_string(result.operation),
+               json_number(result.throughput()),
+               json_string(result.item_unit + "/s"), latency.n_runs,
+               json_number(latency.min), json_number(latency.p50),
+               json_number(latency.p90), json_number(latency.p99),
+               json_number(latency.max), json_number(latency.mean),
+               result.peak_rss_bytes,
+               i_result + 1 < results.size() ? "," : "");
+  }
+  fmt::print(file, "  ]\n}}\n");
+}
+
+int main(int argc, char *argv[]) {
+  const std::string json_path = argc > 1 ? argv[1] : "";
+  const size_t max_edges = argc > 2 ? std::stoul(argv[2]) : 1000000;
+  const auto n_threads = argc > 3
+                             ? std::optional<size_t>(std::stoul(argv[3]))
+                             : std::nullopt;
+
+  const std::vector<NetworkFamily> families = {
+      {"lattice",
+       [](size_t n_edges) {
+         const auto n_edge = size_t(std::lround(std::sqrt(n_edges / 4.0)));
+         return DirectedNetworkGeneration::generate_square_lattice<double>(
+             std::max<size_t>(n_edge, 3), 1.0);
+       }},
+      {"fully_connected",
+       [](size_t n_edges) {
+         const auto n_agents = size_t(std::lround(std::sqrt(double(n_edges))));
+         return DirectedNetworkGeneration::generate_fully_connected<double>(
+             std::max<size_t>(n_agents, 2), 1.0);
+       }},
+      {"scale_free", generate_scale_free}};
+
+  // The JSON must be the only output on the standard output
+  std::FILE *log = json_path == "-" ? stderr : stdout;
+  const bool rss_per_operation = reset_peak_rss();
+  std::vector<SuiteResult> results{};
+  for (size_t target_edges = 10000; target_edges <= max_edges;
+       target_edges *= 10) {
+    for (const auto &family : families) {
+      const auto family_results =
+          run_operations(family, target_edges, n_threads, log);
+      results.insert(results.end(), family_results.begin(),
+                     family_results.end());
+    }
+  }
+
+  if (!json_path.empty()) {
+    const size_t n_threads_used = n_threads.value_or(
+        std::max<size_t>(std::thread::hardware_concurrency(), 1));
+    if (json_path == "-") {
+      write_json(stdout, results, max_edges, n_threads_used,
+                 rss_per_operation);
+    } else {
+      std::FILE *file = std::fopen(json_path.c_str(), "w");
+      if (file == nullptr) {
+        throw std::runtime_error(
+            fmt::format("Bench_Suite: could not open {}!", json_path));
+      }
+      write_json(file, results, max_edges, n_threads_used, rss_per_operation);
+      std::fclose(file);
+      fmt::print("Results written to {}\n", json_path);
+    }
+  }
+}
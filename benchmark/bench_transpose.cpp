@@ -0,0 +1,67 @@
+#include "benchmark_util.hpp"
+#include "directed_network.hpp"
+#include <cstddef>
+#include <fmt/format.h>
+#include <string>
+#include <vector>
+
+// The previous toggle_incoming_outgoing, with a push_back per edge
+template <typename WeightT>
+void toggle_push_back(std::vector<std::vector<size_t>> &neighbour_list,
+                      std::vector<std::vector<WeightT>> &weight_list) {
+  const size_t n_agents = neighbour_list.size();
+  std::vector<std::vector<size_t>> neighbour_list_transpose(
+      n_agents, std::vector<size_t>(0));
+  std::vector<std::vector<WeightT>> weight_list_transpose(
+      n_agents, std::vector<WeightT>(0));
+
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    for (size_t i_neighbour = 0; i_neighbour < neighbour_list[i_agent].size();
+         i_neighbour++) {
+      const auto neighbour = neighbour_list[i_agent][i_neighbour];
+      const auto weight = weight_list[i_agent][i_neighbour];
+      neighbour_list_transpose[neighbour].push_back(i_agent);
+      weight_list_transpose[neighbour].push_back(weight);
+    }
+  }
+
+  neighbour_list = std::move(neighbour_list_transpose);
+  weight_list = std::move(weight_list_transpose);
+}
+
+// Compares the counting-sort transpose with the push_back implementation
+// Usage: Bench_Transpose [n_agents] [n_neighbours]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+  using WeightT = double;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t n_neighbours = argc > 2 ? std::stoul(argv[2]) : 16;
+
+  auto network = generate_random_directed<WeightT>(n_agents, n_neighbours);
+  fmt::print("toggle_incoming_outgoing: {} agents, {} edges\n",
+             network.n_agents(), network.n_edges());
+
+  std::vector<std::vector<size_t>> neighbour_list(n_agents);
+  std::vector<std::vector<WeightT>> weight_list(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    neighbour_list[i_agent].assign(network.get_neighbours(i_agent).begin(),
+                                   network.get_neighbours(i_agent).end());
+    weight_list[i_agent].assign(network.get_weights(i_agent).begin(),
+                                network.get_weights(i_agent).end());
+  }
+  const double push_back_time =
+      report("push_back per edge (previous)",
+             [&]() { toggle_push_back(neighbour_list, weight_list); });
+
+  for (size_t n_threads : thread_counts()) {
+    report(
+        fmt::format("counting sort ({} threads)", n_threads),
+        [&]() { network.toggle_incoming_outgoing(n_threads); }, push_back_time);
+    report(
+        fmt::format("counting sort, unordered ({} threads)", n_threads),
+        [&]() { network.toggle_incoming_outgoing(n_threads, false); },
+        push_back_time);
+  }
+}
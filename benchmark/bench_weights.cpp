@@ -0,0 +1,67 @@
+#include "benchmark_util.hpp"
+#include "directed_network.hpp"
+#include <cstddef>
+#include <fmt/format.h>
+#include <string>
+
+// Compares normalizing the weights with hand-written loops over get_weights
+// (and a transpose for the columns) with the weight operations of NetworkBase
+// Usage: Bench_Weights [n_agents] [n_neighbours]
+int main(int argc, char *argv[]) {
+  using namespace Graph;
+  using namespace Graph::Benchmark;
+
+  const size_t n_agents = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  const size_t n_neighbours = argc > 2 ? std::stoul(argv[2]) : 16;
+
+  auto network = generate_random_directed(n_agents, n_neighbours);
+  const auto original = network;
+  fmt::print("Weight operations: {} agents, {} edges\n", network.n_agents(),
+             network.n_edges());
+
+  auto normalize_by_hand = [&]() {
+    for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+      double sum = 0;
+      for (auto w : network.get_weights(i_agent)) {
+        sum += w;
+      }
+      for (size_t k = 0; k < network.n_edges(i_agent); k++) {
+        network.set_edge_weight(i_agent, k,
+                                network.get_edge_weight(i_agent, k) / sum);
+      }
+    }
+  };
+
+  const double rows_time =
+      report("normalize rows, loop over get_weights", normalize_by_hand);
+  const double columns_time =
+      report("normalize columns, transpose and loop", [&]() {
+        network.toggle_incoming_outgoing();
+        normalize_by_hand();
+        network.toggle_incoming_outgoing();
+      });
+  for (size_t n_threads : thread_counts()) {
+    report(
+        fmt::format("normalize_rows ({} threads)", n_threads),
+        [&]() { network.normalize_rows(n_threads); }, rows_time);
+    report(
+        fmt::format("normalize_columns ({} threads)", n_threads),
+        [&]() { network.normalize_columns(n_threads); }, columns_time);
+    report(fmt::format("scale_weights ({} threads)", n_threads),
+           [&]() { network.scale_weights(1.0, n_threads); });
+    report(fmt::format("transform_weights ({} threads)", n_threads), [&]() {
+      network.transform_weights([](double w) { return 0.5 * w + 0.25; },
+                                n_threads);
+    });
+  }
+
+  // Every run removes the edges below the median weight (the weights are
+  // uniform in [0, 1)) of a fresh copy
+  for (size_t n_threads : thread_counts()) {
+    const double time = median(time_function_with_setup(
+        [&]() { network = original; },
+        [&]() { network.threshold_weights(0.5, n_threads); }));
+    fmt::print("{:<40} {:>10.4f} s\n",
+               fmt::format("threshold_weights ({} threads)", n_threads), time);
+  }
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include "directed_network.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <fmt/format.h>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+// Small helpers shared by the benchmark executables
+
+namespace Graph::Benchmark {
+
+// Runs func n_repetitions times and gives the wall time of each run in seconds
+template <typename Func>
+std::vector<double> time_function(Func &&func, size_t n_repetitions = 5) {
+  std::vector<double> times{};
+  for (size_t i_rep = 0; i_rep < n_repetitions; i_rep++) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double>(end - start).count());
+  }
+  return times;
+}
+
+// Same as time_function, but calls setup before every run of func, outside of
+// the timed region (e.g. to copy a network that func modifies)
+template <typename SetupFunc, typename Func>
+std::vector<double> time_function_with_setup(SetupFunc &&setup, Func &&func,
+                                             size_t n_repetitions = 5) {
+  std::vector<double> times{};
+  for (size_t i_rep = 0; i_rep < n_repetitions; i_rep++) {
+    setup();
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double>(end - start).count());
+  }
+  return times;
+}
+
+inline double median(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+// The value below which the given fraction of the values lies (nearest rank)
+inline double percentile(std::vector<double> values, double fraction) {
+  std::sort(values.begin(), values.end());
+  const auto rank = size_t(std::ceil(fraction * values.size()));
+  return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+// Distribution of the run times of an operation in seconds
+struct LatencySummary {
+  size_t n_runs = 0;
+  double min = 0;
+  double p50 = 0;
+  double p90 = 0;
+  double p99 = 0;
+  double max = 0;
+  double mean = 0;
+};
+
+inline LatencySummary summarize(const std::vector<double> &times) {
+  return {times.size(),
+          *std::min_element(times.begin(), times.end()),
+          percentile(times, 0.5),
+          percentile(times, 0.9),
+          percentile(times, 0.99),
+          *std::max_element(times.begin(), times.end()),
+          std::accumulate(times.begin(), times.end(), 0.0) / times.size()};
+}
+
+// Peak resident set size of the process in bytes, since the last
+// reset_peak_rss. Where that cannot be reset, this is the maximum over the
+// whole lifetime of the process, so it never decreases
+inline size_t peak_rss_bytes() {
+#ifdef __linux__
+  std::ifstream status("/proc/self/status");
+  std::string line{};
+  while (std::getline(status, line)) {
+    if (line.rfind("VmHWM:", 0) == 0) {
+      return std::stoul(line.substr(6)) * 1024;
+    }
+  }
+#endif
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return size_t(usage.ru_maxrss);
+#else
+  return size_t(usage.ru_maxrss) * 1024;
+#endif
+}
+
+// Sets the peak resident set size back to the current one, so that
+// peak_rss_bytes measures only what runs afterwards. Gives false if the system
+// does not support this (Linux only, since 4.0)
+inline bool reset_peak_rss() {
+#ifdef __linux__
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5" << std::flush;
+  return bool(clear_refs);
+#else
+  return false;
+#endif
+}
+
+// Prints a line with the median time of func and its speedup compared to
+// reference_time (if that is positive)
+template <typename Func>
+double report(const std::string &name, Func &&func, double reference_time = 0,
+              size_t n_repetitions = 5) {
+  const double time = median(time_function(func, n_repetitions));
+  if (reference_time > 0) {
+    fmt::print("{:<40} {:>10.4f} s   speedup {:>6.2f}x\n", name, time,
+               reference_time / time);
+  } else {
+    fmt::print("{:<40} {:>10.4f} s\n", name, time);
+  }
+  return time;
+}
+
+// Thread counts 1, 2, 4, ... up to the number of hardware threads
+inline std::vector<size_t> thread_counts() {
+  const size_t n_hardware =
+      std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  std::vector<size_t> counts{};
+  for (size_t n = 1; n < n_hardware; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(n_hardware);
+  return counts;
+}
+
+// Random directed network where each agent has n_neighbours outgoing edges to
+// uniformly chosen agents
+template <typename WeightT = double>
+DirectedNetwork<WeightT> generate_random_directed(size_t n_agents,
+                                                  size_t n_neighbours,
+                                                  unsigned int seed = 42) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  std::uniform_real_distribution<WeightT> dist_weight(0.0, 1.0);
+
+  std::vector<std::vector<size_t>> neighbour_list(n_agents);
+  std::vector<std::vector<WeightT>> weight_list(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    for (size_t i_neighbour = 0; i_neighbour < n_neighbours; i_neighbour++) {
+      neighbour_list[i_agent].push_back(dist_agent(gen));
+      weight_list[i_agent].push_back(dist_weight(gen));
+    }
+  }
+  return DirectedNetwork<WeightT>(
+      std::move(neighbour_list), std::move(weight_list),
+      DirectedNetwork<WeightT>::EdgeDirection::Outgoing);
+}
+
+} // namespace Graph::Benchmark
@@ -0,0 +1,171 @@
+#pragma once
+#include "network_view.hpp"
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    Breadth-first search with buffers that are allocated once and reused for
+    every query. Gives the same depth levels and parents as bfs, but only the
+    entries touched by a query are reset before the next one, so that queries
+    which only reach a small part of a large network (e.g. with a small
+    max_depth) do not pay for the size of the network.
+
+    The parents of all reached nodes are stored in one flat array, in
+    compressed sparse row format: the parents of the i-th reached node are
+    parents[parent_offsets[i]] ... parents[parent_offsets[i+1]-1].
+    Depth levels and parents are stored as IndexType.
+*/
+template <std::unsigned_integral IndexType = size_t> class BfsWorkspace {
+public:
+  using IndexT = IndexType;
+
+private:
+  // Depth level of each node, invalid_index if it was not reached
+  std::vector<IndexT> depth_level{};
+  // Position of each reached node in reached
+  std::vector<size_t> slot{};
+  // Reached nodes, in BFS order
+  std::vector<size_t> reached{};
+  // (slot, parent) pairs in the order in which they were found
+  std::vector<std::pair<size_t, IndexT>> found{};
+  // Parents of all reached nodes, in CSR format
+  std::vector<size_t> parent_offsets{0};
+  std::vector<IndexT> parents{};
+
+  // Sorts the (slot, parent) pairs found by the search into the flat parent
+  // array, keeping the order in which the parents were found
+  void compress_parents() {
+    parent_offsets.assign(reached.size() + 1, 0);
+    for (const auto &[i_slot, parent] : found) {
+      parent_offsets[i_slot + 1] += 1;
+    }
+    for (size_t i_slot = 0; i_slot < reached.size(); i_slot++) {
+      parent_offsets[i_slot + 1] += parent_offsets[i_slot];
+    }
+    parents.resize(found.size());
+    // Use the slot array of the reached nodes as cursors
+    for (size_t i_slot = 0; i_slot < reached.size(); i_slot++) {
+      slot[reached[i_slot]] = parent_offsets[i_slot];
+    }
+    for (const auto &[i_slot, parent] : found) {
+      parents[slot[reached[i_slot]]++] = parent;
+    }
+    for (size_t i_slot = 0; i_slot < reached.size(); i_slot++) {
+      slot[reached[i_slot]] = i_slot;
+    }
+  }
+
+  void collect_paths(std::vector<std::vector<IndexT>> &result_paths,
+                     std::vector<IndexT> &path, IndexT v) const {
+    if (v == invalid_index<IndexT>) {
+      result_paths.push_back(path);
+      return;
+    }
+    for (IndexT par : get_parents(v)) {
+      path.push_back(v);
+      collect_paths(result_paths, path, par);
+      path.pop_back();
+    }
+  }
+
+public:
+  BfsWorkspace() = default;
+
+  explicit BfsWorkspace(size_t n_agents)
+      : depth_level(std::vector<IndexT>(n_agents, invalid_index<IndexT>)),
+        slot(std::vector<size_t>(n_agents, 0)) {}
+
+  /*
+  Breadth-first search from a source node, up to an optional user-defined
+  max_depth. The results of the previous search are discarded
+  */
+  template <NetworkView NetworkT>
+  void bfs(const NetworkT &network, size_t source,
+           std::optional<size_t> max_depth) {
+    // Reset the entries of the previous search only
+    for (size_t v : reached) {
+      depth_level[v] = invalid_index<IndexT>;
+    }
+    reached.clear();
+    found.clear();
+    if (depth_level.size() < network.n_agents()) {
+      depth_level.resize(network.n_agents(), invalid_index<IndexT>);
+      slot.resize(network.n_agents(), 0);
+    }
+
+    depth_level[source] = 0;
+    slot[source] = 0;
+    reached.push_back(source);
+    found.push_back({0, invalid_index<IndexT>});
+
+    // The reached nodes are also the queue of nodes to visit
+    for (size_t i_next = 0; i_next < reached.size(); i_next++) {
+      const size_t v = reached[i_next];
+      if (max_depth.has_value() && depth_level[v] >= max_depth.value()) {
+        break; // Stop BFS if the maximum search depth has been reached
+      }
+
+      for (size_t w : network.get_neighbours(v)) {
+        if (depth_level[w] == invalid_index<IndexT>) {
+          depth_level[w] = depth_level[v] + 1;
+          slot[w] = reached.size();
+          reached.push_back(w);
+        }
+        // Every node at the previous depth with an edge to w is a parent
+        if (depth_level[w] == depth_level[v] + 1) {
+          found.push_back({slot[w], static_cast<IndexT>(v)});
+        }
+      }
+    }
+
+    compress_parents();
+  }
+
+  /*
+  Gives the depth level of v in the last search (invalid_index if it was not
+  reached)
+  */
+  [[nodiscard]] IndexT get_depth(size_t v) const { return depth_level[v]; }
+
+  [[nodiscard]] bool is_reached(size_t v) const {
+    return depth_level[v] != invalid_index<IndexT>;
+  }
+
+  /*
+  Gives the nodes reached by the last search, ordered by their depth level
+  */
+  [[nodiscard]] std::span<const size_t> get_reached() const { return reached; }
+
+  /*
+  Gives a view into the parents of v in the last search: invalid_index for the
+  source, and nothing if v was not reached
+  */
+  [[nodiscard]] std::span<const IndexT> get_parents(size_t v) const {
+    if (!is_reached(v)) {
+      return {};
+    }
+    const size_t i_slot = slot[v];
+    return std::span<const IndexT>(parents.data() + parent_offsets[i_slot],
+                                   parent_offsets[i_slot + 1] -
+                                       parent_offsets[i_slot]);
+  }
+
+  /*
+  Gives all the shortest paths from the source to v, in the format of
+  reconstruct_paths (starting at v)
+  */
+  [[nodiscard]] std::vector<std::vector<IndexT>> get_paths(size_t v) const {
+    std::vector<std::vector<IndexT>> result_paths{};
+    std::vector<IndexT> path{};
+    collect_paths(result_paths, path, static_cast<IndexT>(v));
+    return result_paths;
+  }
+};
+
+} // namespace Graph
@@ -0,0 +1,375 @@
+#pragma once
+#include "directed_network.hpp"
+#include "duplicate_edges.hpp"
+#include "network_base.hpp"
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    A class that represents a directed graph, storing both the incoming and the
+    outgoing edges of every agent, so that algorithms needing both (e.g.
+    backward reachability or bottom-up BFS) never have to toggle the
+    representation. Every edge is stored twice, and each copy knows the
+    position of the other one (the cross-index), so that updates of an edge
+    reach both copies in O(1).
+
+    The NetworkBase neighbour list and weight list hold the outgoing edges,
+    i.e. get_neighbours(i) gives the agents j with an edge i -> j.
+*/
+template <typename WeightType = double, typename IndexType = size_t>
+class BidirectionalNetwork : public NetworkBase<WeightType, IndexType> {
+public:
+  using WeightT = WeightType;
+  using IndexT = IndexType;
+  using EdgeDirection =
+      typename DirectedNetwork<WeightT, IndexT>::EdgeDirection;
+
+  /*
+  A view of the edges in one direction, which can be passed to the algorithms
+  working on a NetworkView
+  */
+  class DirectionView {
+  public:
+    using WeightT = WeightType;
+
+    DirectionView(const std::vector<std::vector<IndexT>> &neighbour_list,
+                  const std::vector<std::vector<WeightT>> &weight_list)
+        : neighbour_list(&neighbour_list), weight_list(&weight_list) {}
+
+    [[nodiscard]] std::size_t n_agents() const {
+      return neighbour_list->size();
+    }
+
+    [[nodiscard]] std::span<const IndexT>
+    get_neighbours(std::size_t agent_idx) const {
+      return (*neighbour_list)[agent_idx];
+    }
+
+    [[nodiscard]] std::span<const WeightT>
+    get_weights(std::size_t agent_idx) const {
+      return (*weight_list)[agent_idx];
+    }
+
+  private:
+    const std::vector<std::vector<IndexT>> *neighbour_list;
+    const std::vector<std::vector<WeightT>> *weight_list;
+  };
+
+  BidirectionalNetwork() = default;
+
+  BidirectionalNetwork(size_t n_agents)
+      : NetworkBase<WeightT, IndexT>(n_agents),
+        in_neighbour_list(std::vector<std::vector<IndexT>>(n_agents)),
+        in_weight_list(std::vector<std::vector<WeightT>>(n_agents)),
+        out_cross_index(std::vector<std::vector<size_t>>(n_agents)),
+        in_cross_index(std::vector<std::vector<size_t>>(n_agents)) {}
+
+  /*
+  Builds both directions from a DirectedNetwork, whichever direction it stores
+  */
+  explicit BidirectionalNetwork(const DirectedNetwork<WeightT, IndexT> &network)
+      : BidirectionalNetwork(network.n_agents()) {
+    auto &stored_neighbours =
+        network.direction() == EdgeDirection::Outgoing ? this->neighbour_list
+                                                       : in_neighbour_list;
+    auto &stored_weights = network.direction() == EdgeDirection::Outgoing
+                               ? this->weight_list
+                               : in_weight_list;
+    for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+      stored_neighbours[i_agent].assign(
+          network.get_neighbours(i_agent).begin(),
+          network.get_neighbours(i_agent).end());
+      stored_weights[i_agent].assign(network.get_weights(i_agent).begin(),
+                                     network.get_weights(i_agent).end());
+    }
+
+    if (network.direction() == EdgeDirection::Outgoing) {
+      link_directions(this->neighbour_list, this->weight_list, out_cross_index,
+                      in_neighbour_list, in_weight_list, in_cross_index);
+    } else {
+      link_directions(in_neighbour_list, in_weight_list, in_cross_index,
+                      this->neighbour_list, this->weight_list,
+                      out_cross_index);
+    }
+  }
+
+  /*
+  Gives the number of edges going out of agent_idx
+  If agent_idx is nullopt, gives the total number of edges
+  */
+  [[nodiscard]] std::size_t
+  n_edges(std::optional<std::size_t> agent_idx = std::nullopt) const override {
+    if (agent_idx.has_value()) {
+      return this->neighbour_list[agent_idx.value()].size();
+    } else {
+      return std::transform_reduce(
+          this->neighbour_list.cbegin(), this->neighbour_list.cend(), 0,
+          std::plus{},
+          [](const auto &neigh_list) { return neigh_list.size(); });
+    }
+  }
+
+  /*
+  Gives the number of edges coming in at agent_idx
+  */
+  [[nodiscard]] std::size_t n_in_edges(std::size_t agent_idx) const {
+    return in_neighbour_list[agent_idx].size();
+  }
+
+  /*
+  Gives views into the agents j with an edge agent_idx -> j, and the weights
+  of these edges
+  */
+  [[nodiscard]] std::span<const IndexT>
+  get_out_neighbours(std::size_t agent_idx) const {
+    return this->get_neighbours(agent_idx);
+  }
+
+  [[nodiscard]] std::span<const WeightT>
+  get_out_weights(std::size_t agent_idx) const {
+    return this->get_weights(agent_idx);
+  }
+
+  /*
+  Gives views into the agents j with an edge j -> agent_idx, and the weights
+  of these edges
+  */
+  [[nodiscard]] std::span<const IndexT>
+  get_in_neighbours(std::size_t agent_idx) const {
+    return in_neighbour_list[agent_idx];
+  }
+
+  [[nodiscard]] std::span<const WeightT>
+  get_in_weights(std::size_t agent_idx) const {
+    return in_weight_list[agent_idx];
+  }
+
+  /*
+  Gives the position of the outgoing edge (agent_idx, index_neighbour) in the
+  incoming list of its target, and the other way round
+  */
+  [[nodiscard]] std::size_t
+  get_out_cross_index(std::size_t agent_idx,
+                      std::size_t index_neighbour) const {
+    return out_cross_index[agent_idx][index_neighbour];
+  }
+
+  [[nodiscard]] std::size_t
+  get_in_cross_index(std::size_t agent_idx,
+                     std::size_t index_neighbour) const {
+    return in_cross_index[agent_idx][index_neighbour];
+  }
+
+  /*
+  Gives views of the outgoing or incoming edges, usable as a NetworkView
+  */
+  [[nodiscard]] DirectionView out_view() const {
+    return DirectionView(this->neighbour_list, this->weight_list);
+  }
+
+  [[nodiscard]] DirectionView in_view() const {
+    return DirectionView(in_neighbour_list, in_weight_list);
+  }
+
+  /*
+  Sets the weight of the index_neighbour-th outgoing edge of agent_idx (and of
+  its incoming copy)
+  */
+  void set_edge_weight(std::size_t agent_idx, std::size_t index_neighbour,
+                       WeightT weight) override {
+    this->weight_list[agent_idx][index_neighbour] = weight;
+    const auto agent_jdx = this->neighbour_list[agent_idx][index_neighbour];
+    in_weight_list[agent_jdx][out_cross_index[agent_idx][index_neighbour]] =
+        weight;
+  }
+
+  /*
+  Sets the weight of the index_neighbour-th incoming edge of agent_idx (and of
+  its outgoing copy)
+  */
+  void set_in_edge_weight(std::size_t agent_idx, std::size_t index_neighbour,
+                          WeightT weight) {
+    in_weight_list[agent_idx][index_neighbour] = weight;
+    const auto agent_jdx = in_neighbour_list[agent_idx][index_neighbour];
+    this->weight_list[agent_jdx][in_cross_index[agent_idx][index_neighbour]] =
+        weight;
+  }
+
+  /*
+  Adds an edge agent_idx_i -> agent_idx_j with weight w. In sorted adjacency
+  mode, the outgoing edge is inserted at its sorted position (the incoming one
+  is always appended)
+  */
+  void push_back_neighbour_and_weight(size_t agent_idx_i, size_t agent_idx_j,
+                                      WeightT w) override {
+    const size_t position =
+        this->insert_neighbour(agent_idx_i, agent_idx_j, w);
+    auto &cross_index = out_cross_index[agent_idx_i];
+    cross_index.insert(cross_index.begin() + position,
+                       in_neighbour_list[agent_idx_j].size());
+    // The outgoing edges behind the new one have moved up by one
+    const auto &neighbours = this->neighbour_list[agent_idx_i];
+    for (size_t i = position + 1; i < neighbours.size(); i++) {
+      in_cross_index[neighbours[i]][cross_index[i]] += 1;
+    }
+
+    in_cross_index[agent_idx_j].push_back(position);
+    in_neighbour_list[agent_idx_j].push_back(agent_idx_i);
+    in_weight_list[agent_idx_j].push_back(w);
+  }
+
+  /*
+  Sorts the neighbours by index and removes doubly counted edges by summing the
+  weights. Both directions end up sorted, and the cross-index is rebuilt.
+  The outgoing rows are merged on n_threads threads (one per core if not set)
+  */
+  void remove_double_counting(
+      std::optional<size_t> n_threads = std::nullopt) override {
+    merge_duplicate_edges(this->neighbour_list, this->weight_list, n_threads);
+    this->rows_changed(n_threads);
+
+    // The incoming side is rebuilt from the outgoing one, which makes its
+    // rows sorted as well
+    link_directions(this->neighbour_list, this->weight_list, out_cross_index,
+                    in_neighbour_list, in_weight_list, in_cross_index);
+  }
+
+  /*
+  Switches the sorted adjacency mode of the outgoing edges on or off, see
+  NetworkBase::set_sorted_adjacency. The cross-index is rebuilt
+  */
+  void set_sorted_adjacency(
+      bool sorted, std::optional<size_t> n_threads = std::nullopt) override {
+    NetworkBase<WeightT, IndexT>::set_sorted_adjacency(sorted, n_threads);
+    link_directions(this->neighbour_list, this->weight_list, out_cross_index,
+                    in_neighbour_list, in_weight_list, in_cross_index);
+  }
+
+  /*
+  Renumbers the agents, see NetworkBase::permute_agents. The incoming side and
+  the cross-index are rebuilt from the permuted outgoing rows
+  */
+  void permute_agents(
+      const Permutation &permutation,
+      std::optional<size_t> n_threads = std::nullopt) override {
+    NetworkBase<WeightT, IndexT>::permute_agents(permutation, n_threads);
+    link_directions(this->neighbour_list, this->weight_list, out_cross_index,
+                    in_neighbour_list, in_weight_list, in_cross_index);
+  }
+
+  /*
+  Gives a DirectedNetwork storing the edges in the requested direction
+  */
+  [[nodiscard]] DirectedNetwork<WeightT, IndexT>
+  to_directed_network(EdgeDirection direction) const {
+    auto neighbour_list = direction == EdgeDirection::Outgoing
+                              ? this->neighbour_list
+                              : in_neighbour_list;
+    auto weight_list = direction == EdgeDirection::Outgoing ? this->weight_list
+                                                            : in_weight_list;
+    return DirectedNetwork<WeightT, IndexT>(std::move(neighbour_list),
+                                            std::move(weight_list), direction);
+  }
+
+  /*
+  Clears the network
+  */
+  void clear() override {
+    NetworkBase<WeightT, IndexT>::clear();
+    for (auto &n : in_neighbour_list)
+      n.clear();
+    for (auto &w : in_weight_list)
+      w.clear();
+    for (auto &c : out_cross_index)
+      c.clear();
+    for (auto &c : in_cross_index)
+      c.clear();
+  }
+
+protected:
+  /*
+  Brings the incoming side up to date after the weight operations changed the
+  outgoing rows: the incoming rows are rebuilt if edges were removed, otherwise
+  only the weights are copied over
+  */
+  void weights_changed(bool edges_removed,
+                       std::optional<size_t> n_threads) override {
+    NetworkBase<WeightT, IndexT>::weights_changed(edges_removed, n_threads);
+    if (edges_removed) {
+      link_directions(this->neighbour_list, this->weight_list,
+                      out_cross_index, in_neighbour_list, in_weight_list,
+                      in_cross_index);
+      return;
+    }
+    // Every incoming entry is the copy of exactly one outgoing edge, so the
+    // threads never write to the same entry
+    parallel_for(0, this->n_agents(), resolve_n_threads(n_threads),
+                 [&](size_t i_agent) {
+                   const auto &neighbours = this->neighbour_list[i_agent];
+                   const auto &weights = this->weight_list[i_agent];
+                   const auto &cross_index = out_cross_index[i_agent];
+                   for (size_t k = 0; k < neighbours.size(); k++) {
+                     in_weight_list[neighbours[k]][cross_index[k]] =
+                         weights[k];
+                   }
+                 });
+  }
+
+private:
+  std::vector<std::vector<IndexT>>
+      in_neighbour_list{}; // Agents with an edge to each agent
+  std::vector<std::vector<WeightT>>
+      in_weight_list{}; // Weights of the incoming edges
+  std::vector<std::vector<size_t>>
+      out_cross_index{}; // Position of each outgoing edge in the incoming list
+                         // of its target
+  std::vector<std::vector<size_t>>
+      in_cross_index{}; // Position of each incoming edge in the outgoing list
+                        // of its source
+
+  // Rebuilds the rows of the other direction from the rows of one direction
+  // (counting the entries per row first), together with the cross-index
+  static void link_directions(
+      const std::vector<std::vector<IndexT>> &from_neighbours,
+      const std::vector<std::vector<WeightT>> &from_weights,
+      std::vector<std::vector<size_t>> &from_cross_index,
+      std::vector<std::vector<IndexT>> &to_neighbours,
+      std::vector<std::vector<WeightT>> &to_weights,
+      std::vector<std::vector<size_t>> &to_cross_index) {
+    const size_t n_agents = from_neighbours.size();
+    std::vector<size_t> n_entries(n_agents, 0);
+    for (const auto &neighbours : from_neighbours) {
+      for (size_t neighbour : neighbours) {
+        n_entries[neighbour] += 1;
+      }
+    }
+
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      to_neighbours[i_agent].resize(n_entries[i_agent]);
+      to_weights[i_agent].resize(n_entries[i_agent]);
+      to_cross_index[i_agent].resize(n_entries[i_agent]);
+      from_cross_index[i_agent].resize(from_neighbours[i_agent].size());
+      n_entries[i_agent] = 0;
+    }
+
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      for (size_t i_neighbour = 0;
+           i_neighbour < from_neighbours[i_agent].size(); i_neighbour++) {
+        const size_t neighbour = from_neighbours[i_agent][i_neighbour];
+        const size_t position = n_entries[neighbour]++;
+        to_neighbours[neighbour][position] = static_cast<IndexT>(i_agent);
+        to_weights[neighbour][position] = from_weights[i_agent][i_neighbour];
+        to_cross_index[neighbour][position] = i_neighbour;
+        from_cross_index[i_agent][i_neighbour] = position;
+      }
+    }
+  }
+};
+
+} // namespace Graph
@@ -0,0 +1,176 @@
+#pragma once
+#include "connectivity.hpp"
+#include "network_base.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    An immutable snapshot of a network in compressed sparse row (CSR) format.
+    The neighbour indices and weights of all agents are stored in two flat
+    contiguous arrays. The neighbours of agent i are found in
+    neighbours[offsets[i]] ... neighbours[offsets[i+1]-1], and the
+    corresponding weights at the same positions of the weights array.
+
+    The snapshot stores exactly what get_neighbours() of the original network
+    gives, so for a DirectedNetwork the direction (incoming/outgoing) is that of
+    the original network, and for an UndirectedNetwork every edge appears
+    twice (once for each agent). The neighbour indices are stored as
+    IndexType, like in the original network.
+*/
+template <typename WeightType = double, typename IndexType = size_t>
+class CompressedNetwork {
+public:
+  using WeightT = WeightType;
+  using IndexT = IndexType;
+
+private:
+  std::vector<size_t> offsets{0}; // Start of the row of each agent (+ the end)
+  std::vector<IndexT> neighbours{}; // Neighbour indices of all agents
+  std::vector<WeightT> weights{};   // Weights of all the connections
+
+public:
+  CompressedNetwork() = default;
+
+  /*
+  Builds the snapshot from any network, by copying the neighbours and weights
+  of each agent
+  */
+  explicit CompressedNetwork(const NetworkBase<WeightT, IndexT> &network)
+      : offsets(std::vector<size_t>(network.n_agents() + 1, 0)) {
+    for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+      offsets[i_agent + 1] =
+          offsets[i_agent] + network.get_neighbours(i_agent).size();
+    }
+
+    neighbours.resize(offsets.back());
+    weights.resize(offsets.back());
+
+    for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+      const auto neighbours_i = network.get_neighbours(i_agent);
+      const auto weights_i = network.get_weights(i_agent);
+      std::copy(neighbours_i.begin(), neighbours_i.end(),
+                neighbours.begin() + offsets[i_agent]);
+      std::copy(weights_i.begin(), weights_i.end(),
+                weights.begin() + offsets[i_agent]);
+    }
+  }
+
+  /*
+  Takes ownership of already compressed arrays. offsets needs n_agents+1
+  entries, starting at 0 and ending at the number of stored edges
+  */
+  CompressedNetwork(std::vector<size_t> &&offsets,
+                    std::vector<IndexT> &&neighbours,
+                    std::vector<WeightT> &&weights)
+      : offsets(std::move(offsets)), neighbours(std::move(neighbours)),
+        weights(std::move(weights)) {
+    if (this->offsets.empty() || this->offsets.front() != 0 ||
+        this->offsets.back() != this->neighbours.size() ||
+        !std::is_sorted(this->offsets.begin(), this->offsets.end())) {
+      throw std::runtime_error("CompressedNetwork: the offsets do not "
+                               "describe the neighbour array!");
+    }
+    if (this->neighbours.size() != this->weights.size()) {
+      throw std::runtime_error("CompressedNetwork: neighbours and weights "
+                               "need to have the same length!");
+    }
+  }
+
+  /*
+  Gives the total number of nodes in the network
+  */
+  [[nodiscard]] std::size_t n_agents() const { return offsets.size() - 1; }
+
+  /*
+  Gives the number of edges stored for agent_idx
+  If agent_idx is nullopt, gives the total number of stored edges
+  */
+  [[nodiscard]] std::size_t
+  n_edges(std::optional<std::size_t> agent_idx = std::nullopt) const {
+    if (agent_idx.has_value()) {
+      return offsets[agent_idx.value() + 1] - offsets[agent_idx.value()];
+    } else {
+      return neighbours.size();
+    }
+  }
+
+  /*
+  Gives a view into the neighbour indices connected to agent_idx
+  */
+  [[nodiscard]] std::span<const IndexT>
+  get_neighbours(std::size_t agent_idx) const {
+    return std::span<const IndexT>(neighbours.data() + offsets[agent_idx],
+                                   n_edges(agent_idx));
+  }
+
+  /*
+  Gives a view into the edge weights corresponding to edges connected to
+  agent_idx
+  */
+  [[nodiscard]] std::span<const WeightT>
+  get_weights(std::size_t agent_idx) const {
+    return std::span<const WeightT>(weights.data() + offsets[agent_idx],
+                                    n_edges(agent_idx));
+  }
+
+  /*
+  Gets the weight for agent_idx, for a neighbour index
+  */
+  const WeightT get_edge_weight(std::size_t agent_idx,
+                                std::size_t index_neighbour) const {
+    return weights[offsets[agent_idx] + index_neighbour];
+  }
+
+  /*
+  Checks if a connection exists between two agents i_idx and j_idx
+  */
+  bool connection_exists(size_t i_idx, size_t j_idx) const {
+    auto i_neighbours = get_neighbours(i_idx);
+    return std::find(i_neighbours.begin(), i_neighbours.end(), j_idx) !=
+           std::end(i_neighbours);
+  }
+
+  /*
+  Gives the strongly connected components in the graph, in one flat buffer
+  (preferred for large networks: no allocation per component)
+  If n_threads is set, the multi-threaded ParallelConnectivityAlgo is used
+  */
+  [[nodiscard]] ComponentList<IndexT> strongly_connected_component_list(
+      std::optional<size_t> n_threads = std::nullopt) const {
+    if (n_threads.has_value()) {
+      return std::move(ParallelConnectivityAlgo(*this, n_threads).scc_list);
+    }
+    return std::move(TarjanConnectivityAlgo(*this).scc_list);
+  }
+
+  /*
+  Gives the strongly connected components in the graph, as a vector of vectors
+  If n_threads is set, the multi-threaded ParallelConnectivityAlgo is used
+  */
+  [[nodiscard]] std::vector<std::vector<IndexT>> strongly_connected_components(
+      std::optional<size_t> n_threads = std::nullopt) const {
+    return strongly_connected_component_list(n_threads).to_nested();
+  }
+
+  /*
+  Views into the flat arrays
+  */
+  [[nodiscard]] std::span<const size_t> get_offsets() const { return offsets; }
+
+  [[nodiscard]] std::span<const IndexT> get_all_neighbours() const {
+    return neighbours;
+  }
+
+  [[nodiscard]] std::span<const WeightT> get_all_weights() const {
+    return weights;
+  }
+};
+
+} // namespace Graph
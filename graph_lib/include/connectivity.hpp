@@ -1,113 +1,616 @@
 #pragma once
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
-#include <tuple>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
 #include <vector>
 
 namespace Graph {
 
-class TarjanConnectivityAlgo {
+/*
+    A list of components (sets of vertex indices), all stored in one flat
+    buffer. The vertices of component i are found in
+    vertices[offsets[i]] ... vertices[offsets[i+1]-1].
+*/
+template <typename IndexType = size_t> class ComponentList {
 public:
-  TarjanConnectivityAlgo(
-      const std::vector<std::vector<size_t>> &adjacency_list_arg)
-      : scc_list(std::vector<std::vector<size_t>>(0)),
-        adjacency_list(adjacency_list_arg), num_nodes(adjacency_list.size()),
-        num(std::vector<size_t>(num_nodes)),
-        lowest(std::vector<size_t>(num_nodes)),
-        visited(std::vector<bool>(num_nodes, false)),
-        processed(std::vector<bool>(num_nodes, false)),
-        stack(std::vector<size_t>(0)), index_counter(0) {
-    run(); // Tarjan's algorithm
+  using IndexT = IndexType;
+
+  ComponentList() = default;
+
+  /*
+  Gives the number of components
+  */
+  [[nodiscard]] std::size_t size() const { return offsets.size() - 1; }
+
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  /*
+  Gives a view into the vertex indices of component i
+  */
+  [[nodiscard]] std::span<const IndexT> operator[](std::size_t i) const {
+    return std::span<const IndexT>(vertices.data() + offsets[i],
+                                   offsets[i + 1] - offsets[i]);
   }
 
-  std::vector<std::vector<size_t>>
-      scc_list; // Each element is a vector of indices corresponding to a
-                // strongly connected component (SCC)
+  /*
+  Adds a vertex to the last component, which is still open
+  */
+  void push_back_vertex(std::size_t v) {
+    vertices.push_back(static_cast<IndexT>(v));
+  }
 
-private:
-  std::vector<std::vector<size_t>> adjacency_list;
-  size_t num_nodes;
-  std::vector<size_t> num; // holding vertex numbers
-  std::vector<size_t>
-      lowest; // lowest[v] : minimum number of a vertex reachable from v
-  std::vector<bool> visited;   // visited so DFS has seen these vertices (not
-                               // necessarily processed)
-  std::vector<bool> processed; // vertices which have been processed by DFS
-  std::vector<size_t>
-      stack; // stack of vertices to keep a working set of vertices. Holds all
-             // vertices reachable from the starting vertex
-  size_t index_counter; // depth-first search node number counter
-
-  // Depth-first search
-  // v: Current vertex
-  void depth_first_search(std::size_t v) {
-    std::vector<size_t> scc;
-
-    // Set things for the current vertex v
-    num[v] = index_counter;
-    lowest[v] = num[v];
-    index_counter += 1;
-    visited[v] = true;
-    stack.push_back(v);
-
-    // Loop through neighbours of v
-    // u is the neighbouring vertex
-    for (auto &u : adjacency_list[v]) {
-      // Skip for the element itself
-      if (u == v) {
-        continue;
+  /*
+  Closes the last component: all vertices pushed back since the previous
+  component was closed form a new component
+  */
+  void close_component() { offsets.push_back(vertices.size()); }
+
+  /*
+  Gives the components as a vector of vectors
+  */
+  [[nodiscard]] std::vector<std::vector<IndexT>> to_nested() const & {
+    std::vector<std::vector<IndexT>> nested(size());
+    for (size_t i = 0; i < size(); i++) {
+      nested[i].assign((*this)[i].begin(), (*this)[i].end());
+    }
+    return nested;
+  }
+
+  /*
+  Gives the components as a vector of vectors, giving back the memory of the
+  flat buffer while the components are copied out of it (from the last one),
+  so that the flat and the nested form are never both held in full
+  */
+  [[nodiscard]] std::vector<std::vector<IndexT>> to_nested() && {
+    std::vector<std::vector<IndexT>> nested(size());
+    size_t capacity = vertices.size();
+    for (size_t i = size(); i-- > 0;) {
+      nested[i].assign(vertices.begin() + offsets[i], vertices.end());
+      vertices.resize(offsets[i]);
+      // Shrinking whenever half of the buffer is copied out moves at most
+      // as many vertices as the buffer holds, in total
+      if (vertices.size() < capacity / 2) {
+        vertices.shrink_to_fit();
+        capacity = vertices.size();
       }
+    }
+    vertices = std::vector<IndexT>{};
+    offsets = std::vector<size_t>{0};
+    return nested;
+  }
+
+  /*
+  Views into the flat buffers
+  */
+  [[nodiscard]] std::span<const IndexT> get_vertices() const {
+    return vertices;
+  }
+
+  [[nodiscard]] std::span<const size_t> get_offsets() const { return offsets; }
+
+private:
+  std::vector<IndexT> vertices{}; // Vertices of all the components
+  std::vector<size_t> offsets{0}; // Start of each component (+ the end)
+};
+
+/*
+    Tarjan's algorithm for the strongly connected components (SCCs).
+    The depth-first search is iterative, with an explicit stack, so that
+    arbitrarily long paths do not overflow the call stack. The network is only
+    viewed (never copied), and the SCCs are written into one flat buffer.
+    The working arrays and the SCCs use IndexType, which is deduced from the
+    neighbour indices of the network.
+*/
+template <typename IndexType = size_t> class TarjanConnectivityAlgo {
+public:
+  using IndexT = IndexType;
+
+  template <NetworkView NetworkT>
+  TarjanConnectivityAlgo(const NetworkT &network) {
+    // Tarjan's algorithm
+    run(network.n_agents(),
+        [&](size_t v) { return network.get_neighbours(v); });
+  }
 
-      // If u hasn't been visited do a DFS
-      if (!visited[u]) {
-        // recursive call to DFS
-        depth_first_search(u);
-        lowest[v] = std::min(lowest[v], lowest[u]);
-      } // u not visited
-      else {
-        // If u has been processed, then it is a cross-edge and should be
-        // ignored. If u has been visited but not processed:
-        if (!processed[u]) {
-          lowest[v] = std::min(lowest[v], num[u]);
-        } // u not processed
-      } // u has been visited
-    }
-
-    // Now v has been processed
-    processed[v] = true;
-
-    // Handle SCC if found
-    if (lowest[v] == num[v]) {
-      scc.resize(0);
-      size_t scc_vertex = 0;
-      // Pop the stack
-      scc_vertex = stack.back();
-      stack.pop_back();
-      while (scc_vertex != v) {
-        scc.push_back(scc_vertex); // Add to the SCC
-        // Pop the stack
-        scc_vertex = stack.back();
-        stack.pop_back();
-      } // unravelling stack
-      // Add the last vertex
-      scc.push_back(scc_vertex);
-      // Now that we have found the SCC, add it
-      // to the SCC list
-      scc_list.push_back(scc);
-    } // SCC found
+  TarjanConnectivityAlgo(
+      const std::vector<std::vector<IndexT>> &adjacency_list) {
+    // Tarjan's algorithm
+    run(adjacency_list.size(), [&](size_t v) {
+      return std::span<const IndexT>(adjacency_list[v]);
+    });
   }
 
+  ComponentList<IndexT>
+      scc_list; // Each element is a view into the indices
+                // corresponding to a strongly connected component
+
+private:
+  // Marks vertices which have not been seen by the DFS yet
+  static constexpr IndexT unvisited = invalid_index<IndexT>;
+
+  // A vertex whose neighbours are being looped through by the DFS, together
+  // with the position of the next neighbour to look at
+  struct Frame {
+    IndexT vertex;
+    size_t next_neighbour;
+  };
+
   // Actually run Tarjan's algorithm
   // for finding strongly connected components (SCCs)
-  void run() {
+  template <typename NeighboursFunc>
+  void run(size_t num_nodes, NeighboursFunc neighbours_of) {
+    std::vector<IndexT> num(num_nodes, unvisited); // holding vertex numbers
+    std::vector<IndexT> lowest(
+        num_nodes); // lowest[v] : minimum number of a vertex reachable from v
+    std::vector<bool> on_stack(num_nodes, false); // vertices in stack
+    std::vector<IndexT>
+        stack{}; // stack of vertices to keep a working set of vertices. Holds
+                 // all vertices reachable from the starting vertex
+    std::vector<Frame> call_stack{}; // replaces the recursive DFS calls
+    IndexT index_counter = 0; // depth-first search node number counter
+
+    // Set things for a vertex v seen for the first time
+    auto visit = [&](size_t v) {
+      num[v] = index_counter;
+      lowest[v] = num[v];
+      index_counter += 1;
+      stack.push_back(static_cast<IndexT>(v));
+      on_stack[v] = true;
+      call_stack.push_back(Frame{static_cast<IndexT>(v), 0});
+    };
+
     // Tarjan's algorithm takes the form of a series of DFS invocations
     for (size_t i_node = 0; i_node < num_nodes; ++i_node) {
       // Start from a node that has not been visited
-      if (!visited[i_node]) {
-        // Call the depth first search
-        depth_first_search(i_node);
+      if (num[i_node] != unvisited) {
+        continue;
+      }
+      visit(i_node);
+
+      while (!call_stack.empty()) {
+        const size_t v = call_stack.back().vertex;
+        const auto neighbours = neighbours_of(v);
+
+        // Loop through neighbours of v, one at a time
+        // u is the neighbouring vertex
+        if (call_stack.back().next_neighbour < neighbours.size()) {
+          const size_t u = neighbours[call_stack.back().next_neighbour];
+          call_stack.back().next_neighbour += 1;
+
+          // Skip for the element itself
+          if (u == v) {
+            continue;
+          }
+
+          if (num[u] == unvisited) {
+            // Descend into u; v is continued once u is finished
+            visit(u);
+          } else if (on_stack[u]) {
+            // u is in the SCC currently being built
+            lowest[v] = std::min(lowest[v], num[u]);
+          } // else: u is in an SCC which was already found
+          continue;
+        }
+
+        // Now v has been processed; hand its lowest number up to the parent
+        call_stack.pop_back();
+        if (!call_stack.empty()) {
+          const size_t parent = call_stack.back().vertex;
+          lowest[parent] = std::min(lowest[parent], lowest[v]);
+        }
+
+        // Handle SCC if found
+        if (lowest[v] == num[v]) {
+          IndexT scc_vertex = 0;
+          // Unravel the stack down to v, adding each vertex to the SCC
+          do {
+            scc_vertex = stack.back();
+            stack.pop_back();
+            on_stack[scc_vertex] = false;
+            scc_list.push_back_vertex(scc_vertex);
+          } while (scc_vertex != v);
+          scc_list.close_component();
+        } // SCC found
       }
     }
   }
 };
 
-} // namespace Graph
\ No newline at end of file
+template <NetworkView NetworkT>
+TarjanConnectivityAlgo(const NetworkT &)
+    -> TarjanConnectivityAlgo<network_index_t<NetworkT>>;
+
+/*
+    Multi-threaded algorithm for the strongly connected components (SCCs),
+    which gives the same partition as TarjanConnectivityAlgo. It works in
+    phases, each of which is parallel over the vertices:
+      1. Trimming: vertices without (remaining) incoming or outgoing edges are
+         trivial SCCs and are removed, repeatedly.
+      2. Forward-backward: the SCC of a high-degree pivot is the intersection
+         of the vertices reachable from it and the vertices reaching it. On
+         social networks this removes the giant SCC.
+      3. Colouring: the largest vertex index reaching each vertex is
+         propagated forward; the vertices of each colour which reach the
+         vertex giving the colour form an SCC. Repeated until few vertices
+         remain or the rounds stop making progress.
+      4. The remaining vertices are handed to Tarjan's algorithm.
+    Needs the incoming edges as well, so a transposed copy of the adjacency is
+    built first. The components are ordered by their smallest vertex, and
+    the vertices within each component are sorted. The transposed copy and the
+    SCCs use IndexType, which is deduced from the neighbour indices of the
+    network.
+*/
+template <typename IndexType = size_t> class ParallelConnectivityAlgo {
+public:
+  using IndexT = IndexType;
+
+  template <NetworkView NetworkT>
+  ParallelConnectivityAlgo(const NetworkT &network,
+                           std::optional<size_t> n_threads = std::nullopt)
+      : n_threads(resolve_n_threads(n_threads)),
+        num_nodes(network.n_agents()),
+        component(std::vector<std::atomic<size_t>>(num_nodes)) {
+    for (auto &c : component) {
+      c.store(unassigned, std::memory_order_relaxed);
+    }
+    build_reverse(network);
+
+    std::vector<size_t> live(num_nodes);
+    for (size_t v = 0; v < num_nodes; v++) {
+      live[v] = v;
+    }
+
+    trim(network, live);
+    forward_backward(network, live);
+    colour(network, live);
+    finish_sequentially(network, live);
+    collect_components();
+  }
+
+  ComponentList<IndexT>
+      scc_list; // Each element is a view into the indices
+                // corresponding to a strongly connected component
+
+private:
+  // Marks vertices which are not yet in an SCC
+  static constexpr size_t unassigned = std::numeric_limits<size_t>::max();
+  // Below this number of remaining vertices, Tarjan's algorithm takes over
+  static constexpr size_t sequential_threshold = 4096;
+
+  size_t n_threads;
+  size_t num_nodes;
+  std::vector<size_t> reverse_offsets{};    // Offsets of the incoming edges
+  std::vector<IndexT> reverse_neighbours{}; // Incoming edges of each vertex
+  std::vector<std::atomic<size_t>>
+      component;                       // SCC of each vertex (or unassigned)
+  std::atomic<size_t> n_components{0}; // Number of SCCs found so far
+
+  [[nodiscard]] bool is_live(size_t v) const {
+    return component[v].load(std::memory_order_relaxed) == unassigned;
+  }
+
+  [[nodiscard]] std::span<const IndexT> get_reverse_neighbours(size_t v) const {
+    return std::span<const IndexT>(reverse_neighbours.data() +
+                                       reverse_offsets[v],
+                                   reverse_offsets[v + 1] - reverse_offsets[v]);
+  }
+
+  // Keeps only the vertices which are not yet in an SCC
+  void remove_assigned(std::vector<size_t> &live) const {
+    std::erase_if(live, [&](size_t v) { return !is_live(v); });
+  }
+
+  // Counts the incoming edges of each vertex, and scatters them into the
+  // reverse adjacency. Self-loops are irrelevant for the SCCs and are dropped
+  template <NetworkView NetworkT> void build_reverse(const NetworkT &network) {
+    std::vector<std::atomic<size_t>> cursor(num_nodes);
+    parallel_for(0, num_nodes, n_threads, [&](size_t v) {
+      for (size_t u : network.get_neighbours(v)) {
+        if (u != v) {
+          cursor[u].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+
+    reverse_offsets.resize(num_nodes + 1);
+    reverse_offsets[0] = 0;
+    for (size_t v = 0; v < num_nodes; v++) {
+      reverse_offsets[v + 1] = reverse_offsets[v] + cursor[v].load();
+      cursor[v].store(reverse_offsets[v], std::memory_order_relaxed);
+    }
+    reverse_neighbours.resize(reverse_offsets.back());
+
+    parallel_for(0, num_nodes, n_threads, [&](size_t v) {
+      for (size_t u : network.get_neighbours(v)) {
+        if (u != v) {
+          reverse_neighbours[cursor[u].fetch_add(
+              1, std::memory_order_relaxed)] = static_cast<IndexT>(v);
+        }
+      }
+    });
+  }
+
+  // Repeatedly removes vertices which have no remaining incoming or no
+  // remaining outgoing edges; each of them is an SCC on its own
+  template <NetworkView NetworkT>
+  void trim(const NetworkT &network, std::vector<size_t> &live) {
+    std::vector<std::atomic<size_t>> in_degree(num_nodes);
+    std::vector<std::atomic<size_t>> out_degree(num_nodes);
+    std::vector<std::vector<size_t>> next_buffers(n_threads);
+    std::vector<size_t> frontier{};
+
+    parallel_for(0, live.size(), n_threads, [&](size_t i, size_t i_thread) {
+      const size_t v = live[i];
+      size_t n_out = 0;
+      for (size_t u : network.get_neighbours(v)) {
+        n_out += (u != v) ? 1 : 0;
+      }
+      out_degree[v].store(n_out, std::memory_order_relaxed);
+      in_degree[v].store(get_reverse_neighbours(v).size(),
+                         std::memory_order_relaxed);
+      if (n_out == 0 || get_reverse_neighbours(v).empty()) {
+        next_buffers[i_thread].push_back(v);
+      }
+    });
+    merge_thread_buffers(next_buffers, frontier);
+
+    while (!frontier.empty()) {
+      parallel_for(
+          0, frontier.size(), n_threads, [&](size_t i, size_t i_thread) {
+            const size_t v = frontier[i];
+            if (!claim(v)) {
+              return; // Already trimmed
+            }
+            for (size_t u : network.get_neighbours(v)) {
+              if (u != v && in_degree[u].fetch_sub(1) == 1) {
+                next_buffers[i_thread].push_back(u);
+              }
+            }
+            for (size_t u : get_reverse_neighbours(v)) {
+              if (out_degree[u].fetch_sub(1) == 1) {
+                next_buffers[i_thread].push_back(u);
+              }
+            }
+          });
+      frontier.clear();
+      merge_thread_buffers(next_buffers, frontier);
+    }
+
+    remove_assigned(live);
+  }
+
+  // Puts v into a new SCC of its own, unless it already is in one
+  // (ids of failed claims are skipped, the SCCs are relabelled at the end)
+  bool claim(size_t v) {
+    if (!is_live(v)) {
+      return false;
+    }
+    size_t expected = unassigned;
+    return component[v].compare_exchange_strong(expected,
+                                                n_components.fetch_add(1));
+  }
+
+  // Marks (with bit) every live vertex reachable from source, following
+  // neighbours_of. Level-synchronous, in parallel over each level
+  template <typename NeighboursFunc>
+  void reach(size_t source, uint8_t bit,
+             std::vector<std::atomic<uint8_t>> &marks,
+             NeighboursFunc neighbours_of) {
+    std::vector<std::vector<size_t>> next_buffers(n_threads);
+    std::vector<size_t> frontier{source};
+    marks[source].fetch_or(bit);
+
+    while (!frontier.empty()) {
+      parallel_for(
+          0, frontier.size(), n_threads, [&](size_t i, size_t i_thread) {
+            for (size_t u : neighbours_of(frontier[i])) {
+              if (is_live(u) && !(marks[u].fetch_or(bit) & bit)) {
+                next_buffers[i_thread].push_back(u);
+              }
+            }
+          });
+      frontier.clear();
+      merge_thread_buffers(next_buffers, frontier);
+    }
+  }
+
+  // Removes the SCC of the vertex with the largest product of in- and
+  // out-degree, which on most real networks is in the giant SCC
+  template <NetworkView NetworkT>
+  void forward_backward(const NetworkT &network, std::vector<size_t> &live) {
+    if (live.empty()) {
+      return;
+    }
+
+    size_t pivot = live[0];
+    size_t pivot_score = 0;
+    for (size_t v : live) {
+      const size_t score = network.get_neighbours(v).size() *
+                           get_reverse_neighbours(v).size();
+      if (score > pivot_score) {
+        pivot = v;
+        pivot_score = score;
+      }
+    }
+
+    const uint8_t forward_bit = 1;
+    const uint8_t backward_bit = 2;
+    std::vector<std::atomic<uint8_t>> marks(num_nodes);
+    reach(pivot, forward_bit, marks,
+          [&](size_t v) { return network.get_neighbours(v); });
+    reach(pivot, backward_bit, marks,
+          [&](size_t v) { return get_reverse_neighbours(v); });
+
+    // The SCC of the pivot: reachable in both directions
+    const size_t id = n_components.fetch_add(1);
+    parallel_for(0, live.size(), n_threads, [&](size_t i) {
+      const size_t v = live[i];
+      if (marks[v].load(std::memory_order_relaxed) ==
+          (forward_bit | backward_bit)) {
+        component[v].store(id, std::memory_order_relaxed);
+      }
+    });
+
+    remove_assigned(live);
+  }
+
+  // Colour propagation rounds, while they make enough progress
+  template <NetworkView NetworkT>
+  void colour(const NetworkT &network, std::vector<size_t> &live) {
+    std::vector<std::atomic<size_t>> colours(num_nodes);
+    std::vector<std::atomic<uint8_t>> queued(num_nodes);
+    std::vector<std::vector<size_t>> next_buffers(n_threads);
+    std::vector<std::vector<size_t>> bfs_buffers(n_threads);
+    std::vector<size_t> active{};
+    std::vector<size_t> roots{};
+
+    while (live.size() > sequential_threshold) {
+      const size_t n_live_before = live.size();
+
+      // Every vertex starts with its own colour
+      parallel_for(0, live.size(), n_threads, [&](size_t i) {
+        colours[live[i]].store(live[i], std::memory_order_relaxed);
+        queued[live[i]].store(0, std::memory_order_relaxed);
+      });
+
+      // Propagate the largest colour forward, until nothing changes
+      active = live;
+      while (!active.empty()) {
+        parallel_for(
+            0, active.size(), n_threads, [&](size_t i, size_t i_thread) {
+              const size_t v = active[i];
+              // The reset has to be a read-modify-write: a plain store could
+              // be ordered after the load of the colour, and a larger colour
+              // written meanwhile would then neither be read here nor cause
+              // v to be queued again
+              queued[v].exchange(0, std::memory_order_acq_rel);
+              const size_t c = colours[v].load(std::memory_order_relaxed);
+              for (size_t u : network.get_neighbours(v)) {
+                if (u == v || !is_live(u)) {
+                  continue;
+                }
+                size_t old_c = colours[u].load(std::memory_order_relaxed);
+                while (old_c < c &&
+                       !colours[u].compare_exchange_weak(old_c, c)) {
+                }
+                if (old_c < c && queued[u].exchange(1) == 0) {
+                  next_buffers[i_thread].push_back(u);
+                }
+              }
+            });
+        active.clear();
+        merge_thread_buffers(next_buffers, active);
+      }
+
+      // Each colour is started by a root; the vertices of that colour which
+      // reach the root form its SCC
+      roots.clear();
+      for (size_t v : live) {
+        if (colours[v].load(std::memory_order_relaxed) == v) {
+          roots.push_back(v);
+        }
+      }
+      parallel_for(
+          0, roots.size(), n_threads,
+          [&](size_t i, size_t i_thread) {
+            const size_t root = roots[i];
+            const size_t id = n_components.fetch_add(1);
+            auto &queue = bfs_buffers[i_thread];
+            queue.assign(1, root);
+            component[root].store(id, std::memory_order_relaxed);
+            for (size_t front = 0; front < queue.size(); front++) {
+              for (size_t u : get_reverse_neighbours(queue[front])) {
+                if (is_live(u) &&
+                    colours[u].load(std::memory_order_relaxed) == root) {
+                  component[u].store(id, std::memory_order_relaxed);
+                  queue.push_back(u);
+                }
+              }
+            }
+          },
+          1);
+
+      remove_assigned(live);
+      // Chains of small SCCs need many rounds; leave those to Tarjan
+      if ((n_live_before - live.size()) * 64 < n_live_before) {
+        break;
+      }
+    }
+  }
+
+  // Runs Tarjan's algorithm on the subnetwork of the remaining vertices
+  template <NetworkView NetworkT>
+  void finish_sequentially(const NetworkT &network,
+                           const std::vector<size_t> &live) {
+    if (live.empty()) {
+      return;
+    }
+
+    std::vector<size_t> local_index(num_nodes, unassigned);
+    for (size_t i = 0; i < live.size(); i++) {
+      local_index[live[i]] = i;
+    }
+    std::vector<std::vector<size_t>> adjacency_list(live.size());
+    for (size_t i = 0; i < live.size(); i++) {
+      for (size_t u : network.get_neighbours(live[i])) {
+        if (local_index[u] != unassigned) {
+          adjacency_list[i].push_back(local_index[u]);
+        }
+      }
+    }
+
+    auto tarjan_scc = TarjanConnectivityAlgo<size_t>(adjacency_list);
+    for (size_t i_scc = 0; i_scc < tarjan_scc.scc_list.size(); i_scc++) {
+      const size_t id = n_components.fetch_add(1);
+      for (size_t i : tarjan_scc.scc_list[i_scc]) {
+        component[live[i]].store(id, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Relabels the SCCs in the order of their smallest vertex, and writes them
+  // into the flat buffer
+  void collect_components() {
+    std::vector<size_t> relabel(n_components.load(), unassigned);
+    std::vector<size_t> sizes{};
+    std::vector<size_t> labels(num_nodes);
+    for (size_t v = 0; v < num_nodes; v++) {
+      const size_t c = component[v].load(std::memory_order_relaxed);
+      if (relabel[c] == unassigned) {
+        relabel[c] = sizes.size();
+        sizes.push_back(0);
+      }
+      labels[v] = relabel[c];
+      sizes[labels[v]] += 1;
+    }
+
+    std::vector<size_t> cursor(sizes.size() + 1, 0);
+    for (size_t i_scc = 0; i_scc < sizes.size(); i_scc++) {
+      cursor[i_scc + 1] = cursor[i_scc] + sizes[i_scc];
+    }
+    std::vector<size_t> vertices(num_nodes);
+    for (size_t v = 0; v < num_nodes; v++) {
+      vertices[cursor[labels[v]]++] = v;
+    }
+
+    size_t position = 0;
+    for (size_t i_scc = 0; i_scc < sizes.size(); i_scc++) {
+      for (size_t i = 0; i < sizes[i_scc]; i++) {
+        scc_list.push_back_vertex(vertices[position++]);
+      }
+      scc_list.close_component();
+    }
+  }
+};
+
+template <NetworkView NetworkT>
+ParallelConnectivityAlgo(const NetworkT &, std::optional<size_t> = std::nullopt)
+    -> ParallelConnectivityAlgo<network_index_t<NetworkT>>;
+
+} // namespace Graph
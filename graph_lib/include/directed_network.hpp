@@ -1,5 +1,7 @@
 #pragma once
+#include "duplicate_edges.hpp"
 #include "network_base.hpp"
+#include "transpose.hpp"
 #include <utility>
 
 namespace Graph {
@@ -19,21 +21,23 @@ namespace Graph {
 
     Note: switch is equivalent to toggle + transpose, but much cheaper!
 */
-template <typename WeightType = double>
-class DirectedNetwork : public NetworkBase<WeightType> {
+template <typename WeightType = double, typename IndexType = size_t>
+class DirectedNetwork : public NetworkBase<WeightType, IndexType> {
 public:
   enum class EdgeDirection { Incoming, Outgoing };
 
   using WeightT = WeightType;
+  using IndexT = IndexType;
 
   DirectedNetwork() = default;
 
-  DirectedNetwork(size_t n_agents) : NetworkBase<WeightT>(n_agents) {}
+  DirectedNetwork(size_t n_agents) : NetworkBase<WeightT, IndexT>(n_agents) {}
 
-  DirectedNetwork(std::vector<std::vector<size_t>> &&neighbour_list,
+  DirectedNetwork(std::vector<std::vector<IndexT>> &&neighbour_list,
                   std::vector<std::vector<WeightT>> &&weight_list,
                   EdgeDirection direction)
-      : NetworkBase<>(std::move(neighbour_list), std::move(weight_list)),
+      : NetworkBase<WeightT, IndexT>(std::move(neighbour_list),
+                                     std::move(weight_list)),
         _direction(direction) {}
 
   /*
@@ -71,11 +75,13 @@ public:
   }
 
   /*
-  Sets the neighbour indices
+  Sets the neighbour indices. In sorted adjacency mode, the row is sorted again
+  afterwards
   */
   void set_edge(std::size_t agent_idx, std::size_t index_neighbour,
                 std::size_t agent_jdx) {
     this->neighbour_list[agent_idx][index_neighbour] = agent_jdx;
+    this->row_changed(agent_idx);
   }
 
   /*
@@ -83,20 +89,21 @@ public:
   agent_idx
   */
   void set_neighbours_and_weights(std::size_t agent_idx,
-                                  std::span<const size_t> buffer_neighbours,
+                                  std::span<const IndexT> buffer_neighbours,
                                   const WeightT &weight) {
     this->neighbour_list[agent_idx].assign(buffer_neighbours.begin(),
                                            buffer_neighbours.end());
     this->weight_list[agent_idx].resize(buffer_neighbours.size());
     std::fill(this->weight_list[agent_idx].begin(),
               this->weight_list[agent_idx].end(), weight);
+    this->row_changed(agent_idx);
   }
 
   /*
   Sets the neighbour indices and weights at agent_idx
   */
   void set_neighbours_and_weights(std::size_t agent_idx,
-                                  std::span<const size_t> buffer_neighbours,
+                                  std::span<const IndexT> buffer_neighbours,
                                   std::span<const WeightT> buffer_weights) {
     if (buffer_neighbours.size() != buffer_weights.size()) {
       throw std::runtime_error("DirectedNetwork::set_neighbours_and_weights: "
@@ -107,6 +114,7 @@ public:
                                            buffer_neighbours.end());
     this->weight_list[agent_idx].assign(buffer_weights.begin(),
                                         buffer_weights.end());
+    this->row_changed(agent_idx);
   }
 
   /*
@@ -122,41 +130,39 @@ public:
   */
   void push_back_neighbour_and_weight(size_t agent_idx_i, size_t agent_idx_j,
                                       WeightT w) override {
-    this->neighbour_list[agent_idx_i].push_back(agent_idx_j);
-    this->weight_list[agent_idx_i].push_back(w);
+    this->insert_neighbour(agent_idx_i, agent_idx_j, w);
   }
 
   /*
   Transposes the network, without switching the direction flag (expensive).
   Example: N(inc) -> N(inc)^T
+  For n_threads and preserve_order, see toggle_incoming_outgoing
   */
-  void transpose() {
-    toggle_incoming_outgoing();
+  void transpose(std::optional<size_t> n_threads = std::nullopt,
+                 bool preserve_order = true) {
+    toggle_incoming_outgoing(n_threads, preserve_order);
     switch_direction_flag();
   }
 
   /*
   Switches the direction flag *without* transposing the network (expensive)
   Example: N(inc) -> N(out)
+  Runs on n_threads threads (one per core if not set). If preserve_order is
+  true, the neighbours of every agent end up sorted by index, exactly as with a
+  sequential loop; otherwise their order depends on the thread scheduling.
   */
-  void toggle_incoming_outgoing() {
-    std::vector<std::vector<size_t>> neighbour_list_transpose(
-        this->n_agents(), std::vector<size_t>(0));
-    std::vector<std::vector<WeightT>> weight_list_transpose(
-        this->n_agents(), std::vector<WeightT>(0));
-
-    for (size_t i_agent = 0; i_agent < this->n_agents(); i_agent++) {
-      for (size_t i_neighbour = 0;
-           i_neighbour < this->neighbour_list[i_agent].size(); i_neighbour++) {
-        const auto neighbour = this->neighbour_list[i_agent][i_neighbour];
-        const auto weight = this->weight_list[i_agent][i_neighbour];
-        neighbour_list_transpose[neighbour].push_back(i_agent);
-        weight_list_transpose[neighbour].push_back(weight);
-      }
-    }
+  void toggle_incoming_outgoing(std::optional<size_t> n_threads = std::nullopt,
+                                bool preserve_order = true) {
+    std::vector<std::vector<IndexT>> neighbour_list_transpose{};
+    std::vector<std::vector<WeightT>> weight_list_transpose{};
+
+    transpose_adjacency(this->neighbour_list, this->weight_list,
+                        neighbour_list_transpose, weight_list_transpose,
+                        n_threads, preserve_order);
 
     this->neighbour_list = std::move(neighbour_list_transpose);
     this->weight_list = std::move(weight_list_transpose);
+    this->rows_changed(n_threads);
 
     // Swap the edge direction
     switch_direction_flag();
@@ -177,48 +183,13 @@ public:
 
   /*
   Sorts the neighbours by index and removes doubly counted edges by summing the
-  weights
+  weights. The agents are processed on n_threads threads (one per core if not
+  set), see merge_duplicate_edges
   */
-  void remove_double_counting() override {
-    std::vector<size_t> sorting_indices{};
-
-    for (size_t idx_agent = 0; idx_agent < this->n_agents(); idx_agent++) {
-
-      auto &neighbours = this->neighbour_list[idx_agent];
-      auto &weights = this->weight_list[idx_agent];
-
-      std::vector<WeightT> weights_copy{};
-      std::vector<size_t> neighbours_copy{};
-
-      const auto n_neighbours = neighbours.size();
-
-      // First we will the sorting_indices array
-      sorting_indices.resize(n_neighbours);
-      std::iota(sorting_indices.begin(), sorting_indices.end(), 0);
-
-      // Then, we figure out how to sort the neighbour indices list
-      std::sort(
-          sorting_indices.begin(), sorting_indices.end(),
-          [&](auto i1, auto i2) { return neighbours[i1] < neighbours[i2]; });
-
-      std::optional<size_t> last_neighbour_index = std::nullopt;
-      for (size_t i = 0; i < n_neighbours; i++) {
-        const auto sort_idx = sorting_indices[i];
-        const auto current_neigbhour_idx = neighbours[sort_idx];
-        const auto current_weight = weights[sort_idx];
-
-        if (last_neighbour_index != current_neigbhour_idx) {
-          weights_copy.push_back(current_weight);
-          neighbours_copy.push_back(current_neigbhour_idx);
-          last_neighbour_index = current_neigbhour_idx;
-        } else {
-          weights_copy.back() += current_weight;
-        }
-      }
-
-      this->weight_list[idx_agent] = weights_copy;
-      this->neighbour_list[idx_agent] = neighbours_copy;
-    }
+  void remove_double_counting(
+      std::optional<size_t> n_threads = std::nullopt) override {
+    merge_duplicate_edges(this->neighbour_list, this->weight_list, n_threads);
+    this->rows_changed(n_threads);
   }
 
 private:
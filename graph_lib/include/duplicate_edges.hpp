@@ -0,0 +1,98 @@
+#pragma once
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+namespace Detail {
+
+// Sorts a row by neighbour index, keeping the weights with their neighbours.
+// entries is scratch space, which only grows
+template <typename WeightT, typename IndexT>
+void sort_row(std::vector<IndexT> &neighbours, std::vector<WeightT> &weights,
+              std::vector<std::pair<IndexT, WeightT>> &entries) {
+  if (std::is_sorted(neighbours.begin(), neighbours.end())) {
+    return;
+  }
+  entries.resize(neighbours.size());
+  for (size_t i = 0; i < neighbours.size(); i++) {
+    entries[i] = {neighbours[i], weights[i]};
+  }
+  std::sort(
+      entries.begin(), entries.end(),
+      [](const auto &e1, const auto &e2) { return e1.first < e2.first; });
+  for (size_t i = 0; i < neighbours.size(); i++) {
+    neighbours[i] = entries[i].first;
+    weights[i] = entries[i].second;
+  }
+}
+
+// Merges the repeated neighbours of a row that is already sorted, summing
+// their weights, and shrinks the row to the merged size
+template <typename WeightT, typename IndexT>
+void compact_sorted_row(std::vector<IndexT> &neighbours,
+                        std::vector<WeightT> &weights) {
+  size_t n_merged = 0;
+  for (size_t i = 0; i < neighbours.size(); i++) {
+    if (n_merged > 0 && neighbours[n_merged - 1] == neighbours[i]) {
+      weights[n_merged - 1] += weights[i];
+    } else {
+      neighbours[n_merged] = neighbours[i];
+      weights[n_merged] = weights[i];
+      n_merged++;
+    }
+  }
+  neighbours.resize(n_merged);
+  weights.resize(n_merged);
+}
+
+} // namespace Detail
+
+/*
+    Sorts every row of an adjacency list by neighbour index, keeping the
+    weights with their neighbours. The rows are processed in parallel and in
+    place; a row that is already sorted is left as it is, any other row is
+    sorted as (index, weight) pairs in a scratch buffer that is kept per thread.
+*/
+template <typename WeightT, typename IndexT>
+void sort_adjacency(std::vector<std::vector<IndexT>> &neighbour_list,
+                    std::vector<std::vector<WeightT>> &weight_list,
+                    std::optional<size_t> n_threads = std::nullopt) {
+  const size_t n_threads_used = resolve_n_threads(n_threads);
+  std::vector<std::vector<std::pair<IndexT, WeightT>>> scratch(n_threads_used);
+  parallel_for(0, neighbour_list.size(), n_threads_used,
+               [&](size_t i_agent, size_t i_thread) {
+                 Detail::sort_row(neighbour_list[i_agent],
+                                  weight_list[i_agent], scratch[i_thread]);
+               });
+}
+
+/*
+    Sorts every row of an adjacency list by neighbour index and merges repeated
+    neighbours into one edge, whose weight is the sum of their weights.
+
+    The rows are processed in parallel and in place, as in sort_adjacency, and
+    then compacted, so that no memory is allocated per row once the scratch
+    buffers have grown. The order in which the weights of repeated neighbours
+    are summed is unspecified.
+*/
+template <typename WeightT, typename IndexT>
+void merge_duplicate_edges(std::vector<std::vector<IndexT>> &neighbour_list,
+                           std::vector<std::vector<WeightT>> &weight_list,
+                           std::optional<size_t> n_threads = std::nullopt) {
+  const size_t n_threads_used = resolve_n_threads(n_threads);
+  std::vector<std::vector<std::pair<IndexT, WeightT>>> scratch(n_threads_used);
+  parallel_for(0, neighbour_list.size(), n_threads_used,
+               [&](size_t i_agent, size_t i_thread) {
+                 auto &neighbours = neighbour_list[i_agent];
+                 auto &weights = weight_list[i_agent];
+                 Detail::sort_row(neighbours, weights, scratch[i_thread]);
+                 Detail::compact_sorted_row(neighbours, weights);
+               });
+}
+
+} // namespace Graph
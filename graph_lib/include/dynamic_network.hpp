@@ -0,0 +1,632 @@
+#pragma once
+#include "compressed_network.hpp"
+#include "duplicate_edges.hpp"
+#include "neighbour_index.hpp"
+#include "network_base.hpp"
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <fmt/format.h>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    A network for models which change a small fraction of their edges in
+    every step (e.g. rewiring or activity-driven models). The edges are kept
+    in compacted rows, in the format of a CompressedNetwork, sorted and
+    without repeated edges, plus changes which are still pending:
+    - inserted edges go into a small delta buffer of their row, or into a
+      free slot of the compacted row if it has one,
+    - removed edges are taken out of their row; in a compacted row, the rest
+      of the row moves up, which leaves a free slot at its end.
+    Inserting or removing an edge therefore costs a binary search and a
+    shift within its row, and a batch of changes is applied row by row in
+    parallel (every row is shifted once per batch). The delta buffer is kept
+    as two sorted runs, the recent entries after the older ones, which are
+    merged once there are about sqrt(size) recent entries, so an insertion
+    only shifts those on average. get_neighbours and
+    get_weights give views of the compacted row followed by the delta buffer,
+    with constant-time random access, so reads see the pending changes right
+    away.
+    Once the pending changes exceed compaction_threshold times the size of
+    the compacted network (its edges, or its agents if there are more), the
+    storage is rebuilt in one parallel pass, so that the cost per change stays
+    constant on average instead of growing with the network.
+
+    Like a CompressedNetwork, every row stores the edges in one direction
+    (e.g. the outgoing ones), and there is at most one edge from an agent to
+    another: inserting an existing edge replaces its weight.
+*/
+template <typename WeightType = double,
+          std::unsigned_integral IndexType = size_t>
+class DynamicNetwork {
+public:
+  using WeightT = WeightType;
+  using IndexT = IndexType;
+
+  struct Edge {
+    IndexT source;
+    IndexT target;
+    WeightT weight;
+  };
+
+  /*
+  A view of one row (its neighbour indices or its weights) which merges in
+  the pending changes. Entries come in the order of the compacted row,
+  followed by the entries of the delta buffer (see above)
+  */
+  template <typename ValueT> class RowView {
+  private:
+    // What a view and its iterators need to know about the row
+    struct Row {
+      std::span<const ValueT> compacted{};
+      std::span<const ValueT> inserted{};
+
+      [[nodiscard]] const ValueT &entry(size_t position) const {
+        return position < compacted.size()
+                   ? compacted[position]
+                   : inserted[position - compacted.size()];
+      }
+    };
+
+    Row row{};
+
+  public:
+    class iterator {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = ValueT;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const ValueT *;
+      using reference = const ValueT &;
+
+      iterator() = default;
+
+      iterator(const Row &row, size_t position)
+          : row(row), position(position) {}
+
+      reference operator*() const { return row.entry(position); }
+
+      iterator &operator++() {
+        position++;
+        return *this;
+      }
+
+      iterator operator++(int) {
+        auto copy = *this;
+        ++(*this);
+        return copy;
+      }
+
+      bool operator==(const iterator &other) const {
+        return position == other.position;
+      }
+
+    private:
+      Row row{}; // A copy, so that the iterator outlives the view
+      size_t position = 0;
+    };
+
+    RowView() = default;
+
+    RowView(std::span<const ValueT> compacted,
+            std::span<const ValueT> inserted)
+        : row{compacted, inserted} {}
+
+    [[nodiscard]] iterator begin() const { return iterator(row, 0); }
+
+    [[nodiscard]] iterator end() const {
+      return iterator(row, row.compacted.size() + row.inserted.size());
+    }
+
+    [[nodiscard]] size_t size() const {
+      return row.compacted.size() + row.inserted.size();
+    }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    const ValueT &operator[](size_t k) const { return row.entry(k); }
+  };
+
+private:
+  // The compacted rows, in compressed sparse row format (see
+  // CompressedNetwork), sorted and without repeated edges. Row i uses the
+  // first row_sizes[i] entries of its slot, the rest are free
+  std::vector<size_t> offsets{0};
+  std::vector<IndexT> neighbours{};
+  std::vector<WeightT> weights{};
+  std::vector<size_t> row_sizes{};
+  // Compacted entries which a batch removes, until their row is shifted
+  std::vector<char> removed{};
+  std::vector<size_t> n_removed{};
+  std::vector<std::vector<IndexT>>
+      inserted_neighbours{}; // Delta buffer of the neighbours of each agent
+  std::vector<std::vector<WeightT>>
+      inserted_weights{};  // Delta buffer of the weights of each agent
+  std::vector<size_t> n_recent{}; // Recent entries of each delta buffer
+  size_t n_live_edges = 0; // Edges, with the pending changes
+  size_t n_pending = 0;    // Free slots and inserted entries
+  double threshold = 0.1;  // Pending changes (relative) which trigger compact
+
+  void init_pending() {
+    const size_t n_agents = this->n_agents();
+    row_sizes.resize(n_agents);
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      row_sizes[i_agent] = offsets[i_agent + 1] - offsets[i_agent];
+    }
+    removed.assign(neighbours.size(), 0);
+    n_removed.assign(n_agents, 0);
+    inserted_neighbours.assign(n_agents, std::vector<IndexT>{});
+    inserted_weights.assign(n_agents, std::vector<WeightT>{});
+    n_recent.assign(n_agents, 0);
+    n_live_edges = neighbours.size();
+    n_pending = 0;
+  }
+
+  [[nodiscard]] std::span<const IndexT> compacted_neighbours(size_t i) const {
+    return std::span<const IndexT>(neighbours.data() + offsets[i],
+                                   row_sizes[i]);
+  }
+
+  [[nodiscard]] std::span<const WeightT> compacted_weights(size_t i) const {
+    return std::span<const WeightT>(weights.data() + offsets[i], row_sizes[i]);
+  }
+
+  // Position of j_idx in the compacted row of i_idx (removed in the current
+  // batch or not)
+  [[nodiscard]] std::optional<size_t> find_compacted(size_t i_idx,
+                                                     size_t j_idx) const {
+    const auto row = compacted_neighbours(i_idx);
+    const size_t position = Detail::branchless_lower_bound(row, j_idx);
+    if (position == row.size() || row[position] != j_idx) {
+      return std::nullopt;
+    }
+    return offsets[i_idx] + position;
+  }
+
+  // Position of j_idx in the delta buffer of i_idx: a binary search in the
+  // older entries and one in the recent ones
+  [[nodiscard]] std::optional<size_t> find_inserted(size_t i_idx,
+                                                    size_t j_idx) const {
+    const auto row = std::span<const IndexT>(inserted_neighbours[i_idx]);
+    const size_t n_older = row.size() - n_recent[i_idx];
+    for (const auto &[begin, end] :
+         {std::pair{size_t(0), n_older}, std::pair{n_older, row.size()}}) {
+      const size_t position =
+          begin + Detail::branchless_lower_bound(
+                      row.subspan(begin, end - begin), j_idx);
+      if (position < end && row[position] == j_idx) {
+        return position;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Merges the recent entries of the delta buffer of i_idx into the older
+  // ones
+  void merge_recent(size_t i_idx) {
+    auto &row_neighbours = inserted_neighbours[i_idx];
+    auto &row_weights = inserted_weights[i_idx];
+    const size_t n_entries = row_neighbours.size();
+    const size_t n_older = n_entries - n_recent[i_idx];
+    std::vector<IndexT> merged_neighbours(n_entries);
+    std::vector<WeightT> merged_weights(n_entries);
+    size_t older = 0;
+    size_t recent = n_older;
+    for (size_t out = 0; out < n_entries; out++) {
+      const bool take_older =
+          recent == n_entries ||
+          (older < n_older && row_neighbours[older] < row_neighbours[recent]);
+      const size_t from = take_older ? older++ : recent++;
+      merged_neighbours[out] = row_neighbours[from];
+      merged_weights[out] = row_weights[from];
+    }
+    row_neighbours = std::move(merged_neighbours);
+    row_weights = std::move(merged_weights);
+    n_recent[i_idx] = 0;
+  }
+
+  // The changes of a single edge, without the compaction. Give the change
+  // of the number of edges and of the number of pending changes. Only touch
+  // the row of i_idx, so that rows can be changed in parallel
+  std::pair<long, long> insert_in_row(size_t i_idx, size_t j_idx, WeightT w) {
+    if (const auto position = find_compacted(i_idx, j_idx)) {
+      weights[position.value()] = w;
+      return {0, 0};
+    }
+    auto &row_neighbours = inserted_neighbours[i_idx];
+    auto &row_weights = inserted_weights[i_idx];
+    if (const auto position = find_inserted(i_idx, j_idx)) {
+      row_weights[position.value()] = w;
+      return {0, 0};
+    }
+    if (offsets[i_idx] + row_sizes[i_idx] < offsets[i_idx + 1]) {
+      // A free slot of the compacted row takes the edge, in sorted order
+      const auto begin = offsets[i_idx];
+      const auto end = begin + row_sizes[i_idx];
+      const auto at =
+          begin + Detail::branchless_lower_bound(compacted_neighbours(i_idx),
+                                                 j_idx);
+      std::copy_backward(neighbours.begin() + at, neighbours.begin() + end,
+                         neighbours.begin() + end + 1);
+      std::copy_backward(weights.begin() + at, weights.begin() + end,
+                         weights.begin() + end + 1);
+      neighbours[at] = static_cast<IndexT>(j_idx);
+      weights[at] = w;
+      row_sizes[i_idx] += 1;
+      return {1, -1};
+    }
+    const size_t n_older = row_neighbours.size() - n_recent[i_idx];
+    const size_t position =
+        n_older + Detail::branchless_lower_bound(
+                      std::span<const IndexT>(row_neighbours).subspan(n_older),
+                      j_idx);
+    row_neighbours.insert(row_neighbours.begin() + position,
+                          static_cast<IndexT>(j_idx));
+    row_weights.insert(row_weights.begin() + position, w);
+    n_recent[i_idx] += 1;
+    if (n_recent[i_idx] > 16 &&
+        n_recent[i_idx] * n_recent[i_idx] > row_neighbours.size()) {
+      merge_recent(i_idx);
+    }
+    return {1, 1};
+  }
+
+  // Only marks the entries of the compacted row, see shift_removed
+  std::pair<long, long> remove_from_row(size_t i_idx, size_t j_idx) {
+    if (const auto position = find_compacted(i_idx, j_idx)) {
+      if (removed[position.value()]) {
+        return {0, 0};
+      }
+      removed[position.value()] = 1;
+      n_removed[i_idx] += 1;
+      return {-1, 1};
+    }
+    if (const auto position = find_inserted(i_idx, j_idx)) {
+      auto &row_neighbours = inserted_neighbours[i_idx];
+      auto &row_weights = inserted_weights[i_idx];
+      if (position.value() >= row_neighbours.size() - n_recent[i_idx]) {
+        n_recent[i_idx] -= 1;
+      }
+      row_neighbours.erase(row_neighbours.begin() + position.value());
+      row_weights.erase(row_weights.begin() + position.value());
+      return {-1, -1};
+    }
+    return {0, 0};
+  }
+
+  // Takes the marked entries out of the compacted row of i_idx, in one pass,
+  // so that the views never see them
+  void shift_removed(size_t i_idx) {
+    if (n_removed[i_idx] == 0) {
+      return;
+    }
+    const size_t begin = offsets[i_idx];
+    const size_t end = begin + row_sizes[i_idx];
+    size_t out = begin;
+    for (size_t i = begin; i < end; i++) {
+      if (removed[i]) {
+        removed[i] = 0;
+        continue;
+      }
+      neighbours[out] = neighbours[i];
+      weights[out] = weights[i];
+      out++;
+    }
+    row_sizes[i_idx] = out - begin;
+    n_removed[i_idx] = 0;
+  }
+
+  void check_agents(size_t i_idx, size_t j_idx, const char *name) const {
+    if (i_idx >= n_agents() || j_idx >= n_agents()) {
+      throw std::runtime_error(fmt::format(
+          "DynamicNetwork::{}: the agent index is out of range!", name));
+    }
+  }
+
+  // Applies change(item) to every item of a batch, and then shift_removed to
+  // every changed row. The items are grouped by their source (keeping their
+  // order within a group, so that the last change of an edge wins), and the
+  // groups are changed in parallel. Gives the change of the number of edges
+  template <typename ItemT, typename ChangeFunc>
+  long apply_batch(std::span<const ItemT> items, const char *name,
+                   std::optional<size_t> n_threads, ChangeFunc &&change) {
+    for (const auto &item : items) {
+      check_agents(item.source, item.target, name);
+    }
+    std::vector<size_t> order(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return items[a].source < items[b].source;
+    });
+    std::vector<size_t> group_begin{};
+    for (size_t i = 0; i < order.size(); i++) {
+      if (i == 0 || items[order[i]].source != items[order[i - 1]].source) {
+        group_begin.push_back(i);
+      }
+    }
+    group_begin.push_back(order.size());
+
+    const size_t n_groups = group_begin.size() - 1;
+    const size_t n_threads_used = resolve_n_threads(n_threads);
+    std::vector<std::pair<long, long>> counts(n_threads_used, {0, 0});
+    parallel_for(
+        0, n_groups, n_threads_used,
+        [&](size_t i_group, size_t i_thread) {
+          for (size_t i = group_begin[i_group]; i < group_begin[i_group + 1];
+               i++) {
+            const auto [d_edges, d_pending] = change(items[order[i]]);
+            counts[i_thread].first += d_edges;
+            counts[i_thread].second += d_pending;
+          }
+          shift_removed(items[order[group_begin[i_group]]].source);
+        },
+        64);
+
+    long d_edges_total = 0;
+    for (const auto &[d_edges, d_pending] : counts) {
+      d_edges_total += d_edges;
+      n_pending += d_pending;
+    }
+    n_live_edges += d_edges_total;
+    compact_if_needed(n_threads);
+    return d_edges_total;
+  }
+
+  void compact_if_needed(std::optional<size_t> n_threads) {
+    const size_t size = std::max(neighbours.size(), n_agents());
+    if (n_pending > 0 && double(n_pending) > threshold * double(size)) {
+      compact(n_threads);
+    }
+  }
+
+public:
+  DynamicNetwork() = default;
+
+  DynamicNetwork(size_t n_agents)
+      : offsets(std::vector<size_t>(n_agents + 1, 0)) {
+    init_pending();
+  }
+
+  /*
+  Starts from the edges of a CompressedNetwork. The rows are sorted and
+  repeated edges are merged by summing their weights, as
+  remove_double_counting does, on n_threads threads
+  */
+  explicit DynamicNetwork(const CompressedNetwork<WeightT, IndexT> &network,
+                          std::optional<size_t> n_threads = std::nullopt) {
+    const size_t n_agents = network.n_agents();
+    std::vector<std::vector<IndexT>> neighbour_list(n_agents);
+    std::vector<std::vector<WeightT>> weight_list(n_agents);
+    parallel_for(0, n_agents, resolve_n_threads(n_threads),
+                 [&](size_t i_agent) {
+                   const auto neighbours = network.get_neighbours(i_agent);
+                   const auto weights = network.get_weights(i_agent);
+                   neighbour_list[i_agent].assign(neighbours.begin(),
+                                                  neighbours.end());
+                   weight_list[i_agent].assign(weights.begin(), weights.end());
+                 });
+    merge_duplicate_edges(neighbour_list, weight_list, n_threads);
+
+    offsets.assign(n_agents + 1, 0);
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      offsets[i_agent + 1] = offsets[i_agent] + neighbour_list[i_agent].size();
+    }
+    neighbours.resize(offsets.back());
+    weights.resize(offsets.back());
+    parallel_for(0, n_agents, resolve_n_threads(n_threads),
+                 [&](size_t i_agent) {
+                   std::copy(neighbour_list[i_agent].begin(),
+                             neighbour_list[i_agent].end(),
+                             neighbours.begin() + offsets[i_agent]);
+                   std::copy(weight_list[i_agent].begin(),
+                             weight_list[i_agent].end(),
+                             weights.begin() + offsets[i_agent]);
+                 });
+    init_pending();
+  }
+
+  /*
+  Starts from the rows of any network, see above
+  */
+  explicit DynamicNetwork(const NetworkBase<WeightT, IndexT> &network,
+                          std::optional<size_t> n_threads = std::nullopt)
+      : DynamicNetwork(CompressedNetwork<WeightT, IndexT>(network),
+                       n_threads) {}
+
+  /*
+  Gives the total number of nodes in the network
+  */
+  [[nodiscard]] std::size_t n_agents() const { return offsets.size() - 1; }
+
+  /*
+  Gives the number of edges stored for agent_idx, with the pending changes
+  If agent_idx is nullopt, gives the total number of edges
+  */
+  [[nodiscard]] std::size_t
+  n_edges(std::optional<std::size_t> agent_idx = std::nullopt) const {
+    if (agent_idx.has_value()) {
+      const size_t i_agent = agent_idx.value();
+      return row_sizes[i_agent] + inserted_neighbours[i_agent].size();
+    }
+    return n_live_edges;
+  }
+
+  /*
+  Gives a view into the neighbour indices of agent_idx, with the pending
+  changes (see RowView)
+  */
+  [[nodiscard]] RowView<IndexT> get_neighbours(std::size_t agent_idx) const {
+    return RowView<IndexT>(compacted_neighbours(agent_idx),
+                           inserted_neighbours[agent_idx]);
+  }
+
+  /*
+  Gives a view into the weights of agent_idx, in the order of get_neighbours
+  */
+  [[nodiscard]] RowView<WeightT> get_weights(std::size_t agent_idx) const {
+    return RowView<WeightT>(compacted_weights(agent_idx),
+                            inserted_weights[agent_idx]);
+  }
+
+  /*
+  Gives the weight of the edge from i_idx to j_idx, or nullopt if there is
+  none. A binary search in the compacted row, then one in the delta buffer
+  */
+  [[nodiscard]] std::optional<WeightT> find_edge_weight(size_t i_idx,
+                                                        size_t j_idx) const {
+    if (const auto position = find_compacted(i_idx, j_idx)) {
+      return weights[position.value()];
+    }
+    if (const auto position = find_inserted(i_idx, j_idx)) {
+      return inserted_weights[i_idx][position.value()];
+    }
+    return std::nullopt;
+  }
+
+  /*
+  Checks if there is an edge from i_idx to j_idx
+  */
+  bool connection_exists(size_t i_idx, size_t j_idx) const {
+    return find_edge_weight(i_idx, j_idx).has_value();
+  }
+
+  /*
+  Adds an edge from i_idx to j_idx with weight w, or replaces the weight if
+  the edge exists. Gives true if the edge is new
+  */
+  bool insert_edge(size_t i_idx, size_t j_idx, WeightT w) {
+    check_agents(i_idx, j_idx, "insert_edge");
+    const auto [d_edges, d_pending] = insert_in_row(i_idx, j_idx, w);
+    n_live_edges += d_edges;
+    n_pending += d_pending;
+    compact_if_needed(1);
+    return d_edges > 0;
+  }
+
+  /*
+  Removes the edge from i_idx to j_idx. Gives false if there is no such edge
+  */
+  bool remove_edge(size_t i_idx, size_t j_idx) {
+    check_agents(i_idx, j_idx, "remove_edge");
+    const auto [d_edges, d_pending] = remove_from_row(i_idx, j_idx);
+    shift_removed(i_idx);
+    n_live_edges += d_edges;
+    n_pending += d_pending;
+    compact_if_needed(1);
+    return d_edges < 0;
+  }
+
+  /*
+  Inserts a batch of edges (see insert_edge); if an edge appears several
+  times, the last weight wins. The rows are changed on n_threads threads
+  (one per core if not set). Gives the number of new edges
+  */
+  size_t insert_edges(std::span<const Edge> edges,
+                      std::optional<size_t> n_threads = std::nullopt) {
+    return apply_batch(edges, "insert_edges", n_threads, [&](const Edge &e) {
+      return insert_in_row(e.source, e.target, e.weight);
+    });
+  }
+
+  /*
+  Removes a batch of edges, given by their source and target (edges which do
+  not exist are ignored). The rows are changed on n_threads threads (one per
+  core if not set). Gives the number of removed edges
+  */
+  size_t remove_edges(std::span<const Edge> edges,
+                      std::optional<size_t> n_threads = std::nullopt) {
+    return -apply_batch(edges, "remove_edges", n_threads, [&](const Edge &e) {
+      return remove_from_row(e.source, e.target);
+    });
+  }
+
+  /*
+  Gives the number of pending changes: free slots of the compacted rows and
+  entries in the delta buffers
+  */
+  [[nodiscard]] size_t n_pending_changes() const { return n_pending; }
+
+  /*
+  Sets the pending changes, relative to the size of the compacted network,
+  above which the changes trigger compact. 0 compacts after every change
+  */
+  void set_compaction_threshold(double fraction) { threshold = fraction; }
+
+  [[nodiscard]] double compaction_threshold() const { return threshold; }
+
+  /*
+  Rebuilds the compacted network with the pending changes, on n_threads
+  threads (one per core if not set): every row is merged with its delta
+  buffer, without the free slots, and comes out sorted
+  */
+  void compact(std::optional<size_t> n_threads = std::nullopt) {
+    const size_t n_agents = this->n_agents();
+    std::vector<size_t> new_offsets(n_agents + 1, 0);
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      new_offsets[i_agent + 1] = new_offsets[i_agent] + n_edges(i_agent);
+    }
+    std::vector<IndexT> new_neighbours(new_offsets.back());
+    std::vector<WeightT> new_weights(new_offsets.back());
+
+    parallel_for(
+        0, n_agents, resolve_n_threads(n_threads), [&](size_t i_agent) {
+          // Both parts of the row are sorted, and an edge is never in both
+          merge_recent(i_agent);
+          const auto old_neighbours = compacted_neighbours(i_agent);
+          const auto old_weights = compacted_weights(i_agent);
+          const auto &delta_neighbours = inserted_neighbours[i_agent];
+          const auto &delta_weights = inserted_weights[i_agent];
+          auto out_neighbours = new_neighbours.begin() + new_offsets[i_agent];
+          auto out_weights = new_weights.begin() + new_offsets[i_agent];
+          size_t k = 0;
+          for (size_t i = 0; i < old_neighbours.size(); i++) {
+            for (; k < delta_neighbours.size() &&
+                   delta_neighbours[k] < old_neighbours[i];
+                 k++) {
+              *out_neighbours++ = delta_neighbours[k];
+              *out_weights++ = delta_weights[k];
+            }
+            *out_neighbours++ = old_neighbours[i];
+            *out_weights++ = old_weights[i];
+          }
+          std::copy(delta_neighbours.begin() + k, delta_neighbours.end(),
+                    out_neighbours);
+          std::copy(delta_weights.begin() + k, delta_weights.end(),
+                    out_weights);
+        });
+
+    offsets = std::move(new_offsets);
+    neighbours = std::move(new_neighbours);
+    weights = std::move(new_weights);
+    init_pending();
+  }
+
+  /*
+  Gives a CompressedNetwork with the edges of this network, including the
+  pending changes, with sorted rows. The algorithms which are faster on
+  contiguous rows (e.g. aggregate_neighbours) can be run on it. Compacts first,
+  if there are pending changes, on n_threads threads
+  */
+  [[nodiscard]] CompressedNetwork<WeightT, IndexT>
+  to_compressed_network(std::optional<size_t> n_threads = std::nullopt) {
+    if (n_pending > 0) {
+      compact(n_threads);
+    }
+    return CompressedNetwork<WeightT, IndexT>(
+        std::vector<size_t>(offsets), std::vector<IndexT>(neighbours),
+        std::vector<WeightT>(weights));
+  }
+};
+
+} // namespace Graph
@@ -0,0 +1,448 @@
+#pragma once
+#include "compressed_network.hpp"
+#include "directed_network.hpp"
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include "undirected_network.hpp"
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    How the weights of repeated edges (same source and target) are merged
+    into one edge: summed (as remove_double_counting does), the largest one,
+    or the one that was added last
+*/
+enum class WeightMerge { Sum, Max, Last };
+
+/*
+    Collects a batch of edges as (source, target, weight) triples, i.e. in
+    coordinate (COO) format, and turns them into a network in one go.
+
+    Building sorts the edges into rows with a parallel, cache-friendly counting
+    sort (one allocation per array instead of one per edge), sorts every row
+    by neighbour index and merges repeated edges with a WeightMerge policy. The
+    rows of the resulting networks are sorted by neighbour index. The number of
+    agents is the one given to the constructor, or one more than the largest
+    index of any edge, if that is larger.
+*/
+template <typename WeightType = double,
+          std::unsigned_integral IndexType = size_t>
+class EdgeListBuilder {
+public:
+  using WeightT = WeightType;
+  using IndexT = IndexType;
+  using EdgeDirection =
+      typename DirectedNetwork<WeightT, IndexT>::EdgeDirection;
+
+  struct Edge {
+    IndexT source;
+    IndexT target;
+    WeightT weight;
+  };
+
+private:
+  size_t n_agents_built = 0; // Number of agents of the built networks
+  std::vector<IndexT> sources{};
+  std::vector<IndexT> targets{};
+  std::vector<WeightT> weights{};
+
+  // Which rows an edge is stored in: the row of its source, of its target, or
+  // both (for undirected networks)
+  enum class RowLayout { Outgoing, Incoming, Symmetric };
+
+  // An edge in the row it is stored in
+  struct RowEntry {
+    IndexT row;
+    IndexT neighbour;
+    WeightT weight;
+  };
+
+  // An entry of a row while the row is sorted
+  struct SortEntry {
+    IndexT neighbour;
+    size_t position; // Orders repeated edges by the time they were added
+    WeightT weight;
+  };
+
+  static void merge_weight(WeightT &merged, WeightT weight, WeightMerge merge) {
+    switch (merge) {
+    case WeightMerge::Sum:
+      merged += weight;
+      break;
+    case WeightMerge::Max:
+      merged = std::max(merged, weight);
+      break;
+    case WeightMerge::Last:
+      merged = weight;
+      break;
+    }
+  }
+
+  /*
+  Sorts the edges into rows and merges the repeated edges of each row. The
+  i-th row starts at offsets[i] of row_neighbours and row_weights, and holds
+  row_sizes[i] merged edges (the rest of the space up to offsets[i+1] is
+  unused).
+
+  Scattering the edges straight into their rows would write to a random
+  place of the whole arrays for every edge, missing the cache almost every
+  time. Instead, the edges are first sorted into buckets of consecutive rows
+  (a few thousand buckets, so that every thread only writes to a few thousand
+  places at a time), and then each bucket is sorted into its rows, which only
+  touches the small part of the arrays that belongs to the bucket. Both
+  passes are stable, so that repeated edges keep the order in which they were
+  added.
+  */
+  void sort_into_rows(RowLayout layout, WeightMerge merge,
+                      size_t n_threads_used, std::vector<size_t> &offsets,
+                      std::vector<IndexT> &row_neighbours,
+                      std::vector<WeightT> &row_weights,
+                      std::vector<size_t> &row_sizes) const {
+    const size_t n_agents = n_agents_built;
+    const size_t n_input_edges = sources.size();
+
+    // Calls func(row, neighbour) for every row the i_edge-th edge is stored in
+    auto for_each_entry = [&](size_t i_edge, auto &&func) {
+      if (layout != RowLayout::Incoming) {
+        func(sources[i_edge], targets[i_edge]);
+      }
+      if (layout != RowLayout::Outgoing) {
+        func(targets[i_edge], sources[i_edge]);
+      }
+    };
+
+    // Every bucket holds 2^bucket_shift consecutive rows
+    const size_t bucket_shift =
+        std::max<int>(std::bit_width(n_agents) - 11, 0);
+    const size_t n_buckets = (n_agents >> bucket_shift) + 1;
+
+    // Count the entries of each bucket, per contiguous block of edges
+    const size_t n_blocks =
+        std::max<size_t>(std::min(n_threads_used, n_input_edges), 1);
+    std::vector<std::vector<size_t>> bucket_cursor(
+        n_blocks, std::vector<size_t>(n_buckets, 0));
+    parallel_run(n_blocks, [&](size_t i_block) {
+      const auto [block_begin, block_end] =
+          block_range(0, n_input_edges, n_blocks, i_block);
+      for (size_t i_edge = block_begin; i_edge < block_end; i_edge++) {
+        for_each_entry(i_edge, [&](size_t row, size_t) {
+          bucket_cursor[i_block][row >> bucket_shift] += 1;
+        });
+      }
+    });
+
+    // The entries of a bucket are ordered by block, and by edge within each
+    // block. The cursors become the positions where each block starts
+    std::vector<size_t> bucket_offsets(n_buckets + 1, 0);
+    size_t n_entries = 0;
+    for (size_t i_bucket = 0; i_bucket < n_buckets; i_bucket++) {
+      bucket_offsets[i_bucket] = n_entries;
+      for (size_t i_block = 0; i_block < n_blocks; i_block++) {
+        const size_t n_block_entries = bucket_cursor[i_block][i_bucket];
+        bucket_cursor[i_block][i_bucket] = n_entries;
+        n_entries += n_block_entries;
+      }
+    }
+    bucket_offsets[n_buckets] = n_entries;
+
+    std::vector<RowEntry> bucketed(n_entries);
+    parallel_run(n_blocks, [&](size_t i_block) {
+      const auto [block_begin, block_end] =
+          block_range(0, n_input_edges, n_blocks, i_block);
+      auto &cursor = bucket_cursor[i_block];
+      for (size_t i_edge = block_begin; i_edge < block_end; i_edge++) {
+        for_each_entry(i_edge, [&](size_t row, size_t neighbour) {
+          bucketed[cursor[row >> bucket_shift]++] = {
+              static_cast<IndexT>(row), static_cast<IndexT>(neighbour),
+              weights[i_edge]};
+        });
+      }
+    });
+
+    // Sort every bucket into its rows, with a counting sort
+    offsets.resize(n_agents + 1);
+    offsets[n_agents] = n_entries;
+    row_neighbours.resize(n_entries);
+    row_weights.resize(n_entries);
+    std::vector<std::vector<size_t>> row_cursor(n_threads_used);
+    parallel_for(
+        0, n_buckets, n_threads_used,
+        [&](size_t i_bucket, size_t i_thread) {
+          const size_t first_row = i_bucket << bucket_shift;
+          const size_t end_row =
+              std::min(first_row + (size_t(1) << bucket_shift), n_agents);
+          auto &cursor = row_cursor[i_thread];
+          cursor.assign(end_row - first_row, 0);
+          for (size_t i_entry = bucket_offsets[i_bucket];
+               i_entry < bucket_offsets[i_bucket + 1]; i_entry++) {
+            cursor[bucketed[i_entry].row - first_row] += 1;
+          }
+          size_t position = bucket_offsets[i_bucket];
+          for (size_t row = first_row; row < end_row; row++) {
+            offsets[row] = position;
+            position += cursor[row - first_row];
+            cursor[row - first_row] = offsets[row];
+          }
+          for (size_t i_entry = bucket_offsets[i_bucket];
+               i_entry < bucket_offsets[i_bucket + 1]; i_entry++) {
+            const auto &entry = bucketed[i_entry];
+            const size_t position = cursor[entry.row - first_row]++;
+            row_neighbours[position] = entry.neighbour;
+            row_weights[position] = entry.weight;
+          }
+        },
+        1);
+    bucketed = std::vector<RowEntry>{};
+
+    // Sort every row by neighbour (and, for repeated edges, by the order in
+    // which they were added) and merge the repeated edges at its start.
+    // Scratch space is kept per thread
+    row_sizes.resize(n_agents);
+    std::vector<std::vector<SortEntry>> scratch(n_threads_used);
+    parallel_for(
+        0, n_agents, n_threads_used, [&](size_t i_agent, size_t i_thread) {
+          const size_t begin = offsets[i_agent];
+          const size_t end = offsets[i_agent + 1];
+          size_t n_merged = 0;
+          auto append = [&](IndexT neighbour, WeightT weight) {
+            if (n_merged > 0 &&
+                row_neighbours[begin + n_merged - 1] == neighbour) {
+              merge_weight(row_weights[begin + n_merged - 1], weight, merge);
+            } else {
+              row_neighbours[begin + n_merged] = neighbour;
+              row_weights[begin + n_merged] = weight;
+              n_merged++;
+            }
+          };
+
+          if (std::is_sorted(row_neighbours.begin() + begin,
+                             row_neighbours.begin() + end)) {
+            for (size_t position = begin; position < end; position++) {
+              append(row_neighbours[position], row_weights[position]);
+            }
+          } else {
+            auto &entries = scratch[i_thread];
+            entries.clear();
+            for (size_t position = begin; position < end; position++) {
+              entries.push_back(
+                  {row_neighbours[position], position, row_weights[position]});
+            }
+            std::sort(entries.begin(), entries.end(),
+                      [](const SortEntry &e1, const SortEntry &e2) {
+                        return e1.neighbour < e2.neighbour ||
+                               (e1.neighbour == e2.neighbour &&
+                                e1.position < e2.position);
+                      });
+            for (const auto &entry : entries) {
+              append(entry.neighbour, entry.weight);
+            }
+          }
+          row_sizes[i_agent] = n_merged;
+        });
+  }
+
+  // Builds the nested neighbour and weight lists of the networks
+  std::pair<std::vector<std::vector<IndexT>>, std::vector<std::vector<WeightT>>>
+  build_lists(RowLayout layout, WeightMerge merge,
+              std::optional<size_t> n_threads) const {
+    const size_t n_threads_used = resolve_n_threads(n_threads);
+    std::vector<size_t> offsets{};
+    std::vector<IndexT> row_neighbours{};
+    std::vector<WeightT> row_weights{};
+    std::vector<size_t> row_sizes{};
+    sort_into_rows(layout, merge, n_threads_used, offsets, row_neighbours,
+                   row_weights, row_sizes);
+
+    std::vector<std::vector<IndexT>> neighbour_list(n_agents_built);
+    std::vector<std::vector<WeightT>> weight_list(n_agents_built);
+    parallel_for(0, n_agents_built, n_threads_used, [&](size_t i_agent) {
+      const size_t begin = offsets[i_agent];
+      const size_t end = begin + row_sizes[i_agent];
+      neighbour_list[i_agent].assign(row_neighbours.begin() + begin,
+                                     row_neighbours.begin() + end);
+      weight_list[i_agent].assign(row_weights.begin() + begin,
+                                  row_weights.begin() + end);
+    });
+    return {std::move(neighbour_list), std::move(weight_list)};
+  }
+
+  CompressedNetwork<WeightT, IndexT>
+  build_compressed(RowLayout layout, WeightMerge merge,
+                   std::optional<size_t> n_threads) const {
+    std::vector<size_t> offsets{};
+    std::vector<IndexT> row_neighbours{};
+    std::vector<WeightT> row_weights{};
+    std::vector<size_t> row_sizes{};
+    sort_into_rows(layout, merge, resolve_n_threads(n_threads), offsets,
+                   row_neighbours, row_weights, row_sizes);
+
+    // Close the gaps left by the merged edges. The rows only move towards the
+    // front, so they can be moved in place, in order
+    size_t n_stored = 0;
+    for (size_t i_agent = 0; i_agent < n_agents_built; i_agent++) {
+      const size_t begin = offsets[i_agent];
+      const size_t end = begin + row_sizes[i_agent];
+      std::copy(row_neighbours.begin() + begin, row_neighbours.begin() + end,
+                row_neighbours.begin() + n_stored);
+      std::copy(row_weights.begin() + begin, row_weights.begin() + end,
+                row_weights.begin() + n_stored);
+      offsets[i_agent] = n_stored;
+      n_stored += row_sizes[i_agent];
+    }
+    offsets.back() = n_stored;
+    row_neighbours.resize(n_stored);
+    row_weights.resize(n_stored);
+    return CompressedNetwork<WeightT, IndexT>(
+        std::move(offsets), std::move(row_neighbours), std::move(row_weights));
+  }
+
+public:
+  EdgeListBuilder() = default;
+
+  explicit EdgeListBuilder(size_t n_agents) : n_agents_built(n_agents) {}
+
+  /*
+  Gives the number of agents of the networks that are built
+  */
+  [[nodiscard]] size_t n_agents() const { return n_agents_built; }
+
+  /*
+  Gives the number of edges added so far (including repeated ones)
+  */
+  [[nodiscard]] size_t n_edges() const { return sources.size(); }
+
+  void reserve(size_t n_edges) {
+    sources.reserve(n_edges);
+    targets.reserve(n_edges);
+    weights.reserve(n_edges);
+  }
+
+  /*
+  Adds an edge source -> target with weight
+  */
+  void add_edge(size_t source, size_t target, WeightT weight) {
+    if (source >= invalid_index<IndexT> || target >= invalid_index<IndexT>) {
+      throw std::runtime_error("EdgeListBuilder::add_edge: the agent index "
+                               "does not fit into the index type!");
+    }
+    sources.push_back(static_cast<IndexT>(source));
+    targets.push_back(static_cast<IndexT>(target));
+    weights.push_back(weight);
+    n_agents_built = std::max(n_agents_built, std::max(source, target) + 1);
+  }
+
+  /*
+  Adds a batch of edges, given as triples
+  */
+  void add_edges(std::span<const Edge> edges) {
+    // Grows geometrically, so that many small batches do not copy the
+    // arrays every time
+    const size_t needed = n_edges() + edges.size();
+    if (needed > sources.capacity()) {
+      reserve(std::max(needed, 2 * sources.capacity()));
+    }
+    for (const auto &edge : edges) {
+      add_edge(edge.source, edge.target, edge.weight);
+    }
+  }
+
+  /*
+  Adds a batch of edges, given as three arrays of the same length
+  */
+  void add_edges(std::span<const IndexT> edge_sources,
+                 std::span<const IndexT> edge_targets,
+                 std::span<const WeightT> edge_weights) {
+    if (edge_sources.size() != edge_targets.size() ||
+        edge_sources.size() != edge_weights.size()) {
+      throw std::runtime_error("EdgeListBuilder::add_edges: sources, targets "
+                               "and weights need to have the same length!");
+    }
+    for (size_t i = 0; i < edge_sources.size(); i++) {
+      if (edge_sources[i] == invalid_index<IndexT> ||
+          edge_targets[i] == invalid_index<IndexT>) {
+        throw std::runtime_error("EdgeListBuilder::add_edges: the agent index "
+                                 "does not fit into the index type!");
+      }
+      const size_t largest_index = std::max(edge_sources[i], edge_targets[i]);
+      n_agents_built = std::max(n_agents_built, largest_index + 1);
+    }
+    sources.insert(sources.end(), edge_sources.begin(), edge_sources.end());
+    targets.insert(targets.end(), edge_targets.begin(), edge_targets.end());
+    weights.insert(weights.end(), edge_weights.begin(), edge_weights.end());
+  }
+
+  /*
+  Removes all edges. The number of agents is kept
+  */
+  void clear() {
+    sources.clear();
+    targets.clear();
+    weights.clear();
+  }
+
+  /*
+  Builds a DirectedNetwork storing the outgoing or the incoming edges, on
+  n_threads threads (one per core if not set)
+  */
+  [[nodiscard]] DirectedNetwork<WeightT, IndexT>
+  build_directed(WeightMerge merge = WeightMerge::Sum,
+                 EdgeDirection direction = EdgeDirection::Outgoing,
+                 std::optional<size_t> n_threads = std::nullopt) const {
+    auto [neighbour_list, weight_list] =
+        build_lists(direction == EdgeDirection::Outgoing ? RowLayout::Outgoing
+                                                         : RowLayout::Incoming,
+                    merge, n_threads);
+    return DirectedNetwork<WeightT, IndexT>(
+        std::move(neighbour_list), std::move(weight_list), direction);
+  }
+
+  /*
+  Builds an UndirectedNetwork, in which every edge is stored for both of its
+  agents, on n_threads threads. With WeightMerge::Sum this gives the same
+  network as push_back_neighbour_and_weight for every edge followed by
+  remove_double_counting
+  */
+  [[nodiscard]] UndirectedNetwork<WeightT, IndexT>
+  build_undirected(WeightMerge merge = WeightMerge::Sum,
+                   std::optional<size_t> n_threads = std::nullopt) const {
+    auto [neighbour_list, weight_list] =
+        build_lists(RowLayout::Symmetric, merge, n_threads);
+    return UndirectedNetwork<WeightT, IndexT>(std::move(neighbour_list),
+                                              std::move(weight_list));
+  }
+
+  /*
+  Builds the compressed (CSR) snapshot of the DirectedNetwork given by
+  build_directed, without building the nested lists first
+  */
+  [[nodiscard]] CompressedNetwork<WeightT, IndexT> build_compressed_directed(
+      WeightMerge merge = WeightMerge::Sum,
+      EdgeDirection direction = EdgeDirection::Outgoing,
+      std::optional<size_t> n_threads = std::nullopt) const {
+    return build_compressed(direction == EdgeDirection::Outgoing
+                                ? RowLayout::Outgoing
+                                : RowLayout::Incoming,
+                            merge, n_threads);
+  }
+
+  /*
+  Builds the compressed (CSR) snapshot of the UndirectedNetwork given by
+  build_undirected, without building the nested lists first
+  */
+  [[nodiscard]] CompressedNetwork<WeightT, IndexT> build_compressed_undirected(
+      WeightMerge merge = WeightMerge::Sum,
+      std::optional<size_t> n_threads = std::nullopt) const {
+    return build_compressed(RowLayout::Symmetric, merge, n_threads);
+  }
+};
+
+} // namespace Graph
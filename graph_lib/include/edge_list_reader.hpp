@@ -0,0 +1,426 @@
+#pragma once
+#include "compressed_network.hpp"
+#include "directed_network.hpp"
+#include "edge_list_builder.hpp"
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include "undirected_network.hpp"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fmt/format.h>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+namespace Detail {
+
+/*
+    A map from 64-bit node IDs to agent indices, hashed with open addressing
+    (linear probing) into one flat array, like the FlatIndexSet. Unlike
+    std::unordered_map, a lookup touches one slot in most cases, which matters
+    when every edge of a large edge list is looked up twice.
+*/
+template <std::unsigned_integral IndexT> class FlatIdMap {
+private:
+  struct Slot {
+    std::uint64_t id;
+    IndexT agent; // invalid_index marks an empty slot
+  };
+  std::vector<Slot> slots{};
+  size_t n_entries = 0;
+  unsigned int shift = 64; // 64 - log2 of the number of slots
+
+  [[nodiscard]] size_t home_slot(std::uint64_t id) const {
+    return (id * 0x9E3779B97F4A7C15ull) >> shift;
+  }
+
+  // Rehashes into enough slots for n entries, keeping the load factor <= 1/2
+  void rehash(size_t n) {
+    const size_t n_slots = std::bit_ceil(std::max<size_t>(2 * n, 8));
+    std::vector<Slot> old_slots(n_slots, Slot{0, invalid_index<IndexT>});
+    old_slots.swap(slots);
+    shift = 64 - std::countr_zero(n_slots);
+    const size_t mask = slots.size() - 1;
+    for (const auto &slot : old_slots) {
+      if (slot.agent != invalid_index<IndexT>) {
+        size_t i = home_slot(slot.id);
+        while (slots[i].agent != invalid_index<IndexT>) {
+          i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+      }
+    }
+  }
+
+public:
+  [[nodiscard]] size_t size() const { return n_entries; }
+
+  /*
+  Gives the agent of id. An id that is not in the map yet is given the next
+  agent index, size()
+  */
+  IndexT find_or_insert(std::uint64_t id) {
+    if (2 * (n_entries + 1) > slots.size()) {
+      rehash(n_entries + 1);
+    }
+    const size_t mask = slots.size() - 1;
+    for (size_t i = home_slot(id);; i = (i + 1) & mask) {
+      if (slots[i].agent == invalid_index<IndexT>) {
+        slots[i] = {id, static_cast<IndexT>(n_entries)};
+        n_entries++;
+        return slots[i].agent;
+      }
+      if (slots[i].id == id) {
+        return slots[i].agent;
+      }
+    }
+  }
+};
+
+} // namespace Detail
+
+/*
+    Options of the EdgeListReader
+*/
+template <typename WeightT> struct EdgeListReadOptions {
+  WeightT default_weight = 1; // Weight of the edges given without one
+  bool remap_ids = false; // Number the node IDs 0, 1, ... in order of their
+                          // first appearance, instead of using them as indices
+  size_t n_header_lines = 0; // Lines at the start of each file to skip
+  size_t chunk_bytes = size_t(1) << 22; // Bytes read at a time, per thread
+  std::optional<size_t> n_threads = std::nullopt; // One per core if not set
+};
+
+/*
+    Reads edge lists in text form, one edge per line:
+
+        source target [weight]
+
+    The fields are separated by spaces, tabs, commas or semicolons (so that CSV
+    works as well), and the weight is optional. Empty lines and lines starting
+    with '#' or '%' are skipped.
+
+    The file is read in chunks of options.chunk_bytes per thread, which are
+    split at line boundaries into one piece per thread; the pieces are parsed
+    in parallel with std::from_chars, and the edges appended to an
+    EdgeListBuilder in the order of the file. Only one chunk of the text is in
+    memory at a time.
+
+    Without remapping, the node IDs are the agent indices, and the network has
+    one agent more than the largest ID. With options.remap_ids, any 64-bit IDs
+    are numbered in order of their first appearance (across all files read),
+    and node_ids() gives the ID of each agent; this step runs on one thread.
+*/
+template <typename WeightType = double,
+          std::unsigned_integral IndexType = size_t>
+class EdgeListReader {
+public:
+  using WeightT = WeightType;
+  using IndexT = IndexType;
+  using EdgeDirection =
+      typename DirectedNetwork<WeightT, IndexT>::EdgeDirection;
+  using Options = EdgeListReadOptions<WeightT>;
+
+private:
+  // The edges parsed by one thread from its piece of a chunk
+  struct ParsedPiece {
+    std::vector<IndexT> sources{};
+    std::vector<IndexT> targets{};
+    std::vector<WeightT> weights{};
+    std::vector<std::uint64_t> ids{}; // Source and target IDs, if remapped
+    size_t n_lines = 0;               // Lines in the piece
+    std::optional<std::pair<size_t, std::string>>
+        error{}; // Line (in the piece) and reason of the first error
+
+    void clear() {
+      sources.clear();
+      targets.clear();
+      weights.clear();
+      ids.clear();
+      n_lines = 0;
+      error.reset();
+    }
+  };
+
+  Options options;
+  EdgeListBuilder<WeightT, IndexT> edges{};
+  Detail::FlatIdMap<IndexT> agents_of_ids{};
+  std::vector<std::uint64_t> ids_of_agents{};
+  std::vector<ParsedPiece> pieces{};
+
+  static bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+  }
+
+  static const char *skip_separators(const char *p, const char *end) {
+    while (p < end && is_separator(*p)) {
+      p++;
+    }
+    return p;
+  }
+
+  // Parses one line into piece. Gives the reason if it is not a valid edge,
+  // and nullptr otherwise
+  const char *parse_line(const char *p, const char *end,
+                         ParsedPiece &piece) const {
+    p = skip_separators(p, end);
+    if (p == end || *p == '#' || *p == '%') {
+      return nullptr;
+    }
+
+    std::uint64_t source = 0;
+    std::uint64_t target = 0;
+    auto result = std::from_chars(p, end, source);
+    if (result.ec != std::errc{}) {
+      return "could not read the source";
+    }
+    p = skip_separators(result.ptr, end);
+    result = std::from_chars(p, end, target);
+    if (result.ec != std::errc{}) {
+      return "could not read the target";
+    }
+    p = skip_separators(result.ptr, end);
+    WeightT weight = options.default_weight;
+    if (p < end) {
+      result = std::from_chars(p, end, weight);
+      if (result.ec != std::errc{}) {
+        return "could not read the weight";
+      }
+      p = skip_separators(result.ptr, end);
+      if (p < end) {
+        return "unexpected text after the weight";
+      }
+    }
+
+    if (options.remap_ids) {
+      piece.ids.push_back(source);
+      piece.ids.push_back(target);
+    } else {
+      if (source >= invalid_index<IndexT> || target >= invalid_index<IndexT>) {
+        return "the node ID does not fit into the index type";
+      }
+      piece.sources.push_back(static_cast<IndexT>(source));
+      piece.targets.push_back(static_cast<IndexT>(target));
+    }
+    piece.weights.push_back(weight);
+    return nullptr;
+  }
+
+  // Parses the lines in [begin, end), which ends at a line boundary
+  void parse_piece(const char *begin, const char *end,
+                   ParsedPiece &piece) const {
+    for (const char *p = begin; p < end; piece.n_lines++) {
+      const auto *newline =
+          static_cast<const char *>(std::memchr(p, '\n', end - p));
+      const char *line_end = newline != nullptr ? newline : end;
+      const char *reason = parse_line(p, line_end, piece);
+      if (reason != nullptr) {
+        piece.error = {piece.n_lines, reason};
+        return;
+      }
+      p = newline != nullptr ? newline + 1 : end;
+    }
+  }
+
+  // Gives the agent of a node ID, numbering new IDs as they appear
+  IndexT agent_of_id(std::uint64_t id) {
+    const IndexT agent = agents_of_ids.find_or_insert(id);
+    if (agent == ids_of_agents.size()) {
+      if (agent == invalid_index<IndexT> - 1) {
+        throw std::runtime_error("EdgeListReader: there are more node IDs "
+                                 "than the index type can number!");
+      }
+      ids_of_agents.push_back(id);
+    }
+    return agent;
+  }
+
+  /*
+  Parses the complete lines in [begin, end) on the threads and appends their
+  edges in order. first_line is the line number of begin in the file. Gives
+  the number of lines parsed
+  */
+  size_t parse_chunk(const char *begin, const char *end, size_t first_line,
+                   const std::string &path) {
+    const size_t length = end - begin;
+    const size_t n_pieces = std::max<size_t>(
+        std::min(resolve_n_threads(options.n_threads), length / 4096), 1);
+    pieces.resize(std::max(pieces.size(), n_pieces));
+
+    // Each piece starts after the first newline at or after its nominal start
+    std::vector<const char *> piece_begins(n_pieces + 1, end);
+    piece_begins[0] = begin;
+    for (size_t i_piece = 1; i_piece < n_pieces; i_piece++) {
+      const char *nominal = std::max(
+          begin + block_range(0, length, n_pieces, i_piece).first,
+          piece_begins[i_piece - 1]);
+      const auto *newline =
+          static_cast<const char *>(std::memchr(nominal, '\n', end - nominal));
+      piece_begins[i_piece] = newline != nullptr ? newline + 1 : end;
+    }
+
+    parallel_run(n_pieces, [&](size_t i_piece) {
+      pieces[i_piece].clear();
+      parse_piece(piece_begins[i_piece], piece_begins[i_piece + 1],
+                  pieces[i_piece]);
+    });
+
+    size_t line = first_line;
+    for (size_t i_piece = 0; i_piece < n_pieces; i_piece++) {
+      auto &piece = pieces[i_piece];
+      if (piece.error.has_value()) {
+        throw std::runtime_error(
+            fmt::format("EdgeListReader: {}, line {}: {}!", path,
+                        line + piece.error->first + 1, piece.error->second));
+      }
+      line += piece.n_lines;
+      if (options.remap_ids) {
+        for (size_t i_edge = 0; i_edge < piece.weights.size(); i_edge++) {
+          piece.sources.push_back(agent_of_id(piece.ids[2 * i_edge]));
+          piece.targets.push_back(agent_of_id(piece.ids[2 * i_edge + 1]));
+        }
+      }
+      edges.add_edges(piece.sources, piece.targets, piece.weights);
+    }
+    return line - first_line;
+  }
+
+public:
+  explicit EdgeListReader(const Options &options = Options{})
+      : options(options) {}
+
+  /*
+  Reads the edges of the file at path and adds them to the ones read so far
+  */
+  void read(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+      throw std::runtime_error(
+          fmt::format("EdgeListReader: could not open {}!", path));
+    }
+
+    // The text after the last newline of a chunk is carried over to the next
+    std::vector<char> buffer(std::max<size_t>(
+        options.chunk_bytes * resolve_n_threads(options.n_threads), 1));
+    size_t n_carried = 0;
+    size_t n_header_lines = options.n_header_lines;
+    size_t line = 0;
+    size_t n_bytes_parsed = 0;
+    std::error_code size_error{};
+    const auto file_size = std::filesystem::file_size(path, size_error);
+    bool at_end = false;
+    try {
+      while (!at_end) {
+        if (n_carried == buffer.size()) {
+          buffer.resize(2 * buffer.size()); // A line longer than a chunk
+        }
+        const size_t n_read = std::fread(buffer.data() + n_carried, 1,
+                                         buffer.size() - n_carried, file);
+        if (std::ferror(file)) {
+          throw std::runtime_error(
+              fmt::format("EdgeListReader: could not read {}!", path));
+        }
+        at_end = n_read < buffer.size() - n_carried;
+
+        const char *begin = buffer.data();
+        const char *end = buffer.data() + n_carried + n_read;
+        for (; n_header_lines > 0 && begin < end; n_header_lines--, line++) {
+          const auto *newline =
+              static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+          if (newline == nullptr && !at_end) {
+            break;
+          }
+          begin = newline != nullptr ? newline + 1 : end;
+        }
+
+        // Only complete lines are parsed, unless the file ends
+        const char *parse_end = end;
+        if (!at_end) {
+          parse_end = begin;
+          for (const char *p = end; n_header_lines == 0 && p > begin; p--) {
+            if (p[-1] == '\n') {
+              parse_end = p;
+              break;
+            }
+          }
+        }
+        const size_t n_edges_before = edges.n_edges();
+        line += parse_chunk(begin, parse_end, line, path);
+
+        // Extrapolate the number of edges in the file from the first chunk, so
+        // that the edges are not copied again and again as they grow
+        if (n_bytes_parsed == 0 && !at_end && parse_end > begin &&
+            !size_error) {
+          const double edges_per_byte =
+              double(edges.n_edges() - n_edges_before) / (parse_end - begin);
+          edges.reserve(n_edges_before +
+                        size_t(1.05 * edges_per_byte * file_size));
+        }
+        n_bytes_parsed += parse_end - begin;
+
+        n_carried = end - parse_end;
+        std::memmove(buffer.data(), parse_end, n_carried);
+      }
+    } catch (...) {
+      std::fclose(file);
+      throw;
+    }
+    std::fclose(file);
+  }
+
+  /*
+  Gives the edges read so far
+  */
+  [[nodiscard]] const EdgeListBuilder<WeightT, IndexT> &builder() const {
+    return edges;
+  }
+
+  /*
+  Gives the node ID of every agent, if the IDs are remapped
+  */
+  [[nodiscard]] std::span<const std::uint64_t> node_ids() const {
+    return ids_of_agents;
+  }
+
+  /*
+  Builds a network from the edges read so far, with options.n_threads threads.
+  See the corresponding functions of the EdgeListBuilder
+  */
+  [[nodiscard]] DirectedNetwork<WeightT, IndexT>
+  build_directed(WeightMerge merge = WeightMerge::Sum,
+                 EdgeDirection direction = EdgeDirection::Outgoing) const {
+    return edges.build_directed(merge, direction, options.n_threads);
+  }
+
+  [[nodiscard]] UndirectedNetwork<WeightT, IndexT>
+  build_undirected(WeightMerge merge = WeightMerge::Sum) const {
+    return edges.build_undirected(merge, options.n_threads);
+  }
+
+  [[nodiscard]] CompressedNetwork<WeightT, IndexT> build_compressed_directed(
+      WeightMerge merge = WeightMerge::Sum,
+      EdgeDirection direction = EdgeDirection::Outgoing) const {
+    return edges.build_compressed_directed(merge, direction,
+                                           options.n_threads);
+  }
+
+  [[nodiscard]] CompressedNetwork<WeightT, IndexT>
+  build_compressed_undirected(WeightMerge merge = WeightMerge::Sum) const {
+    return edges.build_compressed_undirected(merge, options.n_threads);
+  }
+};
+
+} // namespace Graph
@@ -0,0 +1,540 @@
+#pragma once
+#include "compressed_network.hpp"
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    A counter-based random number generator: the n-th number of a stream is a
+    hash (the SplitMix64 finalizer) of the seed, the number of the stream and
+    n. Any stream can be started anywhere, on any thread, so the generators
+    below use one stream per agent (or per edge), and give the same network
+    for every number of threads.
+
+    It satisfies std::uniform_random_bit_generator. uniform() and below() give
+    the same numbers on every platform, unlike the std distributions.
+*/
+class CounterRng {
+private:
+  static constexpr std::uint64_t golden = 0x9E3779B97F4A7C15ull;
+  std::uint64_t key;
+  std::uint64_t counter = 0;
+
+public:
+  using result_type = std::uint64_t;
+
+  static constexpr std::uint64_t mix(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  CounterRng(std::uint64_t seed, std::uint64_t stream)
+      : key(mix(mix(seed + golden) + stream)) {}
+
+  static constexpr result_type min() { return 0; }
+
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  result_type operator()() { return mix(key ^ (golden * ++counter)); }
+
+  /*
+  Gives a uniformly distributed number in [0, 1)
+  */
+  double uniform() { return double((*this)() >> 11) * 0x1.0p-53; }
+
+  /*
+  Gives a uniformly distributed integer in [0, n), for n > 0
+  */
+  std::uint64_t below(std::uint64_t n) {
+    const std::uint64_t threshold = (0 - n) % n; // 2^64 mod n
+    for (;;) {
+      const std::uint64_t x = (*this)();
+      if (x >= threshold) {
+        return x % n;
+      }
+    }
+  }
+};
+
+namespace Detail {
+
+// Calls emit(c) for every c in [0, n_candidates) that succeeds in a Bernoulli
+// trial with probability p, jumping from one success to the next with
+// geometrically distributed skips (Batagelj and Brandes), so that the work is
+// proportional to the number of successes
+template <typename EmitFunc>
+void sample_candidates(CounterRng &rng, size_t n_candidates, double p,
+                       EmitFunc &&emit) {
+  if (p <= 0) {
+    return;
+  }
+  const double inverse_log_q = 1.0 / std::log1p(-std::min(p, 1.0));
+  for (size_t c = 0;; c++) {
+    const double skip =
+        std::floor(std::log(1.0 - rng.uniform()) * inverse_log_q);
+    if (skip >= double(n_candidates - c)) {
+      return;
+    }
+    c += size_t(skip);
+    emit(c);
+  }
+}
+
+// Fills a CSR network in which row i holds the neighbours that
+// row_func(i, emit) passes to emit. The rows are generated in blocks, each
+// into its own buffer, which are then concatenated; so every row is generated
+// once, and the result does not depend on the number of threads
+template <typename IndexT, typename RowFunc>
+void generate_rows(size_t n_rows, size_t n_threads, RowFunc &&row_func,
+                   std::vector<size_t> &offsets,
+                   std::vector<IndexT> &neighbours) {
+  constexpr size_t block_size = 4096;
+  const size_t n_blocks = (n_rows + block_size - 1) / block_size;
+  std::vector<std::vector<IndexT>> block_neighbours(n_blocks);
+  offsets.assign(n_rows + 1, 0);
+  parallel_for(
+      0, n_blocks, n_threads,
+      [&](size_t i_block) {
+        auto &buffer = block_neighbours[i_block];
+        const size_t block_end = std::min((i_block + 1) * block_size, n_rows);
+        for (size_t i_row = i_block * block_size; i_row < block_end; i_row++) {
+          const size_t row_begin = buffer.size();
+          row_func(i_row, [&](size_t neighbour) {
+            buffer.push_back(static_cast<IndexT>(neighbour));
+          });
+          offsets[i_row + 1] = buffer.size() - row_begin;
+        }
+      },
+      1);
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  neighbours.resize(offsets.back());
+  parallel_for(
+      0, n_blocks, n_threads,
+      [&](size_t i_block) {
+        auto &buffer = block_neighbours[i_block];
+        std::copy(buffer.begin(), buffer.end(),
+                  neighbours.begin() + offsets[i_block * block_size]);
+        buffer = std::vector<IndexT>{};
+      },
+      1);
+}
+
+// Turns a CSR network, in which every undirected edge is stored in the row of
+// one of its agents, into one in which it is stored in the rows of both. The
+// rows come out sorted, and repeated edges and self-loops are removed.
+//
+// The rows are split into one block per thread. Like a counting sort, every
+// block first counts its edges into each block, and a prefix sum over these
+// counts gives every pair of blocks its own range, into which the edges are
+// scattered as (target, source) pairs. Each block then only goes through the
+// edges that end in it. As the ranges are ordered by the source block, the
+// incoming edges of every row arrive sorted, without atomics, and the result
+// does not depend on the number of threads
+template <typename IndexT>
+void symmetrize_rows(std::vector<size_t> &offsets,
+                     std::vector<IndexT> &neighbours, size_t n_threads) {
+  const size_t n_rows = offsets.size() - 1;
+  const size_t n_blocks = std::max<size_t>(std::min(n_threads, n_rows), 1);
+  const size_t block_size = std::max<size_t>((n_rows + n_blocks - 1) / n_blocks,
+                                             1);
+  const auto block_rows = [&](size_t i_block) {
+    return std::pair{std::min(i_block * block_size, n_rows),
+                     std::min((i_block + 1) * block_size, n_rows)};
+  };
+
+  // Range of the edges from block s into block t, at t * n_blocks + s
+  std::vector<size_t> range_starts(n_blocks * n_blocks + 1, 0);
+  parallel_for(
+      0, n_blocks, n_threads,
+      [&](size_t s) {
+        const auto [begin, end] = block_rows(s);
+        for (size_t i = offsets[begin]; i < offsets[end]; i++) {
+          range_starts[(neighbours[i] / block_size) * n_blocks + s + 1]++;
+        }
+      },
+      1);
+  std::partial_sum(range_starts.begin(), range_starts.end(),
+                   range_starts.begin());
+
+  std::vector<std::pair<IndexT, IndexT>> incoming(offsets.back());
+  parallel_for(
+      0, n_blocks, n_threads,
+      [&](size_t s) {
+        std::vector<size_t> cursors(n_blocks);
+        for (size_t t = 0; t < n_blocks; t++) {
+          cursors[t] = range_starts[t * n_blocks + s];
+        }
+        const auto [begin, end] = block_rows(s);
+        for (size_t i_row = begin; i_row < end; i_row++) {
+          for (size_t i = offsets[i_row]; i < offsets[i_row + 1]; i++) {
+            const IndexT neighbour = neighbours[i];
+            incoming[cursors[neighbour / block_size]++] = {
+                neighbour, static_cast<IndexT>(i_row)};
+          }
+        }
+      },
+      1);
+
+  // Every row gets its incoming edges and its own ones
+  std::vector<size_t> sym_offsets(n_rows + 1, 0);
+  parallel_for(
+      0, n_blocks, n_threads,
+      [&](size_t t) {
+        for (size_t i = range_starts[t * n_blocks];
+             i < range_starts[(t + 1) * n_blocks]; i++) {
+          sym_offsets[incoming[i].first + 1]++;
+        }
+        const auto [begin, end] = block_rows(t);
+        for (size_t i_row = begin; i_row < end; i_row++) {
+          sym_offsets[i_row + 1] += offsets[i_row + 1] - offsets[i_row];
+        }
+      },
+      1);
+  std::partial_sum(sym_offsets.begin(), sym_offsets.end(),
+                   sym_offsets.begin());
+
+  // Each row gets its incoming edges first and then its own ones, is sorted
+  // if that is not already the case, and merged
+  std::vector<IndexT> sym_neighbours(sym_offsets.back());
+  std::vector<size_t> merged_sizes(n_rows);
+  parallel_for(
+      0, n_blocks, n_threads,
+      [&](size_t t) {
+        const auto [begin, end] = block_rows(t);
+        std::vector<size_t> cursors(sym_offsets.begin() + begin,
+                                    sym_offsets.begin() + end);
+        for (size_t i = range_starts[t * n_blocks];
+             i < range_starts[(t + 1) * n_blocks]; i++) {
+          const auto [target, source] = incoming[i];
+          sym_neighbours[cursors[target - begin]++] = source;
+        }
+        for (size_t i_row = begin; i_row < end; i_row++) {
+          const auto row_begin = sym_neighbours.begin() + sym_offsets[i_row];
+          const auto row_end = sym_neighbours.begin() + sym_offsets[i_row + 1];
+          std::copy(neighbours.begin() + offsets[i_row],
+                    neighbours.begin() + offsets[i_row + 1],
+                    sym_neighbours.begin() + cursors[i_row - begin]);
+          if (!std::is_sorted(row_begin, row_end)) {
+            std::sort(row_begin, row_end);
+          }
+          auto merged_end = std::unique(row_begin, row_end);
+          merged_end =
+              std::remove(row_begin, merged_end, static_cast<IndexT>(i_row));
+          merged_sizes[i_row] = merged_end - row_begin;
+        }
+      },
+      1);
+  incoming = std::vector<std::pair<IndexT, IndexT>>{};
+
+  offsets.assign(n_rows + 1, 0);
+  std::partial_sum(merged_sizes.begin(), merged_sizes.end(),
+                   offsets.begin() + 1);
+  if (offsets.back() == sym_offsets.back()) {
+    neighbours = std::move(sym_neighbours);
+    return;
+  }
+  neighbours.resize(offsets.back());
+  parallel_for(0, n_rows, n_threads, [&](size_t i_row) {
+    std::copy_n(sym_neighbours.begin() + sym_offsets[i_row],
+                merged_sizes[i_row], neighbours.begin() + offsets[i_row]);
+  });
+}
+
+template <typename IndexT> void check_n_agents_fit(size_t n_agents) {
+  if (n_agents >= invalid_index<IndexT>) {
+    throw std::runtime_error("The number of agents does not fit into the "
+                             "index type!");
+  }
+}
+
+template <typename WeightT, typename IndexT>
+CompressedNetwork<WeightT, IndexT>
+make_compressed(std::vector<size_t> &&offsets, std::vector<IndexT> &&neighbours,
+                WeightT weight) {
+  auto weights = std::vector<WeightT>(neighbours.size(), weight);
+  return CompressedNetwork<WeightT, IndexT>(
+      std::move(offsets), std::move(neighbours), std::move(weights));
+}
+
+} // namespace Detail
+
+/*
+    The generators below write their networks directly into the flat arrays of
+    a CompressedNetwork, with every edge of the given weight. The rows are
+    sorted by neighbour index. The networks of the undirected models store
+    every edge in the rows of both of its agents, like an UndirectedNetwork,
+    and have no self-loops or repeated edges.
+
+    Each row (or edge) draws its random numbers from its own CounterRng
+    stream, so the same seed gives the same network on any number of threads
+    (n_threads, one per core if not set).
+*/
+
+/*
+    Directed Erdos-Renyi network G(n, p): every ordered pair of distinct agents
+    (i, j) is an edge i -> j with probability p. The rows hold the outgoing
+    edges
+*/
+template <typename WeightT = double, std::unsigned_integral IndexT = size_t>
+CompressedNetwork<WeightT, IndexT>
+generate_erdos_renyi_directed(size_t n_agents, double p,
+                              std::uint64_t seed = 0, WeightT weight = 1,
+                              std::optional<size_t> n_threads = std::nullopt) {
+  Detail::check_n_agents_fit<IndexT>(n_agents);
+  std::vector<size_t> offsets{};
+  std::vector<IndexT> neighbours{};
+  Detail::generate_rows(
+      n_agents, resolve_n_threads(n_threads),
+      [&](size_t i_agent, auto &&emit) {
+        auto rng = CounterRng(seed, i_agent);
+        const size_t n_candidates = n_agents > 0 ? n_agents - 1 : 0;
+        Detail::sample_candidates(rng, n_candidates, p, [&](size_t c) {
+          emit(c < i_agent ? c : c + 1); // Skip the agent itself
+        });
+      },
+      offsets, neighbours);
+  return Detail::make_compressed(std::move(offsets), std::move(neighbours),
+                                 weight);
+}
+
+/*
+    Undirected Erdos-Renyi network G(n, p): every pair of distinct agents is an
+    edge with probability p
+*/
+template <typename WeightT = double, std::unsigned_integral IndexT = size_t>
+CompressedNetwork<WeightT, IndexT> generate_erdos_renyi_undirected(
+    size_t n_agents, double p, std::uint64_t seed = 0, WeightT weight = 1,
+    std::optional<size_t> n_threads = std::nullopt) {
+  Detail::check_n_agents_fit<IndexT>(n_agents);
+  const size_t n_threads_used = resolve_n_threads(n_threads);
+  std::vector<size_t> offsets{};
+  std::vector<IndexT> neighbours{};
+  // Each agent draws its edges to the agents with a larger index
+  Detail::generate_rows(
+      n_agents, n_threads_used,
+      [&](size_t i_agent, auto &&emit) {
+        auto rng = CounterRng(seed, i_agent);
+        Detail::sample_candidates(rng, n_agents - i_agent - 1, p,
+                                  [&](size_t c) { emit(i_agent + 1 + c); });
+      },
+      offsets, neighbours);
+  Detail::symmetrize_rows(offsets, neighbours, n_threads_used);
+  return Detail::make_compressed(std::move(offsets), std::move(neighbours),
+                                 weight);
+}
+
+/*
+    Undirected stochastic block model: the agents are split into consecutive
+    blocks of the given sizes, and two distinct agents in the blocks a and b
+    are connected with probability probabilities[a][b] (a symmetric matrix)
+*/
+template <typename WeightT = double, std::unsigned_integral IndexT = size_t>
+CompressedNetwork<WeightT, IndexT> generate_stochastic_block_model(
+    std::span<const size_t> block_sizes,
+    const std::vector<std::vector<double>> &probabilities,
+    std::uint64_t seed = 0, WeightT weight = 1,
+    std::optional<size_t> n_threads = std::nullopt) {
+  const size_t n_blocks = block_sizes.size();
+  bool valid = probabilities.size() == n_blocks;
+  for (size_t a = 0; valid && a < n_blocks; a++) {
+    valid = probabilities[a].size() == n_blocks;
+    for (size_t b = 0; valid && b < n_blocks; b++) {
+      valid = probabilities[a][b] == probabilities[b][a];
+    }
+  }
+  if (!valid) {
+    throw std::runtime_error("generate_stochastic_block_model: the "
+                             "probabilities need to be a symmetric matrix "
+                             "with a row for every block!");
+  }
+
+  std::vector<size_t> block_starts(n_blocks + 1, 0);
+  std::partial_sum(block_sizes.begin(), block_sizes.end(),
+                   block_starts.begin() + 1);
+  const size_t n_agents = block_starts.back();
+  Detail::check_n_agents_fit<IndexT>(n_agents);
+  std::vector<size_t> block_of_agent(n_agents);
+  for (size_t a = 0; a < n_blocks; a++) {
+    std::fill(block_of_agent.begin() + block_starts[a],
+              block_of_agent.begin() + block_starts[a + 1], a);
+  }
+
+  const size_t n_threads_used = resolve_n_threads(n_threads);
+  std::vector<size_t> offsets{};
+  std::vector<IndexT> neighbours{};
+  // Each agent draws its edges to the agents with a larger index, block by
+  // block
+  Detail::generate_rows(
+      n_agents, n_threads_used,
+      [&](size_t i_agent, auto &&emit) {
+        auto rng = CounterRng(seed, i_agent);
+        const size_t a = block_of_agent[i_agent];
+        for (size_t b = a; b < n_blocks; b++) {
+          const size_t first = std::max(i_agent + 1, block_starts[b]);
+          Detail::sample_candidates(rng, block_starts[b + 1] - first,
+                                    probabilities[a][b],
+                                    [&](size_t c) { emit(first + c); });
+        }
+      },
+      offsets, neighbours);
+  Detail::symmetrize_rows(offsets, neighbours, n_threads_used);
+  return Detail::make_compressed(std::move(offsets), std::move(neighbours),
+                                 weight);
+}
+
+/*
+    Undirected Barabasi-Albert network: starting from n_links agents without
+    edges, every further agent is connected to n_links agents chosen with a
+    probability proportional to their degree.
+
+    Like the generator of Batagelj and Brandes, each new edge copies an end of
+    a uniformly chosen earlier edge. The choices are made with one random
+    stream per edge, so that the target of any edge can be found on its own
+    by following the copies back (two steps on average), and all agents are
+    generated in parallel (the scheme of Sanders and Schulz). Repeated choices
+    and self-loops are dropped, so a few agents end up with less than n_links
+    edges of their own.
+*/
+template <typename WeightT = double, std::unsigned_integral IndexT = size_t>
+CompressedNetwork<WeightT, IndexT>
+generate_barabasi_albert(size_t n_agents, size_t n_links,
+                         std::uint64_t seed = 0, WeightT weight = 1,
+                         std::optional<size_t> n_threads = std::nullopt) {
+  if (n_links == 0 || n_links >= n_agents) {
+    throw std::runtime_error("generate_barabasi_albert: n_links needs to be "
+                             "at least 1 and less than n_agents!");
+  }
+  Detail::check_n_agents_fit<IndexT>(n_agents);
+
+  // Edge e joins the agent n_links + e / n_links to its target. The edges of
+  // the first new agent go to the n_links initial agents
+  auto target_of_edge = [&](size_t e) {
+    while (e >= n_links) {
+      auto rng = CounterRng(seed, e);
+      const size_t end = rng.below(2 * e); // One of the 2e earlier edge ends
+      if (end % 2 == 0) {
+        return n_links + (end / 2) / n_links;
+      }
+      e = end / 2;
+    }
+    return e;
+  };
+
+  const size_t n_threads_used = resolve_n_threads(n_threads);
+  std::vector<size_t> offsets{};
+  std::vector<IndexT> neighbours{};
+  Detail::generate_rows(
+      n_agents, n_threads_used,
+      [&](size_t i_agent, auto &&emit) {
+        if (i_agent < n_links) {
+          return;
+        }
+        const size_t first_edge = (i_agent - n_links) * n_links;
+        for (size_t e = first_edge; e < first_edge + n_links; e++) {
+          emit(target_of_edge(e));
+        }
+      },
+      offsets, neighbours);
+  Detail::symmetrize_rows(offsets, neighbours, n_threads_used);
+  return Detail::make_compressed(std::move(offsets), std::move(neighbours),
+                                 weight);
+}
+
+/*
+    Undirected Watts-Strogatz small-world network: a ring in which every agent
+    is connected to its n_neighbours nearest agents (n_neighbours / 2 on each
+    side), where every edge i -- i + d is rewired to a uniformly chosen agent
+    with probability beta. A rewired edge avoids self-loops and the agents
+    i + 1, ..., i + n_neighbours / 2; the rare repeated edges (e.g. between
+    agents that were rewired to each other) are merged.
+*/
+template <typename WeightT = double, std::unsigned_integral IndexT = size_t>
+CompressedNetwork<WeightT, IndexT>
+generate_watts_strogatz(size_t n_agents, size_t n_neighbours, double beta,
+                        std::uint64_t seed = 0, WeightT weight = 1,
+                        std::optional<size_t> n_threads = std::nullopt) {
+  if (n_neighbours % 2 != 0 || n_neighbours == 0 ||
+      n_neighbours + 1 >= n_agents) {
+    throw std::runtime_error("generate_watts_strogatz: n_neighbours needs to "
+                             "be even, positive and less than n_agents - 1!");
+  }
+  Detail::check_n_agents_fit<IndexT>(n_agents);
+
+  const size_t n_threads_used = resolve_n_threads(n_threads);
+  const size_t half = n_neighbours / 2;
+  std::vector<size_t> offsets{};
+  std::vector<IndexT> neighbours{};
+  Detail::generate_rows(
+      n_agents, n_threads_used,
+      [&](size_t i_agent, auto &&emit) {
+        auto rng = CounterRng(seed, i_agent);
+        for (size_t d = 1; d <= half; d++) {
+          if (rng.uniform() >= beta) {
+            emit((i_agent + d) % n_agents);
+            continue;
+          }
+          // Draw the distance to the target among the allowed ones
+          const size_t distance = half + 1 + rng.below(n_agents - half - 1);
+          emit((i_agent + distance) % n_agents);
+        }
+      },
+      offsets, neighbours);
+  Detail::symmetrize_rows(offsets, neighbours, n_threads_used);
+  return Detail::make_compressed(std::move(offsets), std::move(neighbours),
+                                 weight);
+}
+
+/*
+    Undirected periodic square lattice of n_edge x n_edge agents, in which
+    agent x + n_edge * y is connected to its four nearest neighbours
+    (x +- 1, y) and (x, y +- 1), with periodic boundaries. n_edge needs to be
+    at least 3, so that the four neighbours are distinct
+*/
+template <typename WeightT = double, std::unsigned_integral IndexT = size_t>
+CompressedNetwork<WeightT, IndexT>
+generate_periodic_lattice(size_t n_edge, WeightT weight = 1,
+                          std::optional<size_t> n_threads = std::nullopt) {
+  if (n_edge < 3) {
+    throw std::runtime_error(
+        "generate_periodic_lattice: n_edge needs to be at least 3!");
+  }
+  const size_t n_agents = n_edge * n_edge;
+  Detail::check_n_agents_fit<IndexT>(n_agents);
+
+  std::vector<size_t> offsets(n_agents + 1);
+  std::iota(offsets.begin(), offsets.end(), 0);
+  std::transform(offsets.begin(), offsets.end(), offsets.begin(),
+                 [](size_t i) { return 4 * i; });
+  std::vector<IndexT> neighbours(4 * n_agents);
+  parallel_for(0, n_agents, resolve_n_threads(n_threads), [&](size_t i_agent) {
+    const size_t x = i_agent % n_edge;
+    const size_t y = i_agent / n_edge;
+    const auto row = neighbours.begin() + 4 * i_agent;
+    row[0] = static_cast<IndexT>((x + n_edge - 1) % n_edge + n_edge * y);
+    row[1] = static_cast<IndexT>((x + 1) % n_edge + n_edge * y);
+    row[2] = static_cast<IndexT>(x + n_edge * ((y + n_edge - 1) % n_edge));
+    row[3] = static_cast<IndexT>(x + n_edge * ((y + 1) % n_edge));
+    std::sort(row, row + 4);
+  });
+  return Detail::make_compressed(std::move(offsets), std::move(neighbours),
+                                 weight);
+}
+
+} // namespace Graph
@@ -0,0 +1,588 @@
+#pragma once
+#include "connectivity.hpp"
+#include "network_view.hpp"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <fmt/format.h>
+#include <iterator>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    The strongly connected components (SCCs) of a directed network whose
+    edges are inserted and removed over time, kept up to date without running
+    Tarjan's algorithm on the whole network after every batch.
+    Every agent carries the label of its component, and the components carry
+    keys which give a topological order of the condensation: every edge
+    between two components goes from a smaller to a larger key. The order is
+    maintained with two searches bounded by the keys, like in the algorithm
+    of Pearce and Kelly:
+    - An inserted edge from component a to component b with key[a] < key[b]
+      changes nothing.
+    - Otherwise, the components reachable from b and those reaching a, with
+      keys from key[b] to key[a], are searched at the same time, one edge
+      after the other, until one of the searches is complete. Only the
+      components of the complete search move, keeping their order: those
+      reachable from b right behind a, or those reaching a right in front of
+      b. If the complete search got to the other end, the edge closes a
+      cycle, and the components on the paths from b to a (found by searching
+      back within the complete search) are merged into one, which takes the
+      place of that end.
+    - A removed edge between two components changes nothing. A removed edge
+      inside a component runs Tarjan's algorithm on just that component, which
+      may split it into pieces, ordered in place of the component.
+    The work per change is thus proportional to the edges of the components
+    which are searched or split, not to the size of the network. The keys
+    are kept in an ordered list; a component which moves between two keys
+    without a free key between them gets one by spacing out the keys of the
+    smallest surrounding window of keys which is sparse enough (the order
+    maintenance of Dietz and Sleator), which touches O(log n) keys on
+    average.
+    The edges (in both directions) are copied, and repeated edges are kept.
+    Like TarjanConnectivityAlgo, a network is read as the edges from every
+    agent to its get_neighbours. Labels are reused after merges, so they lie
+    in [0, n_agents) but are not contiguous.
+*/
+template <std::unsigned_integral IndexType = size_t> class IncrementalSCC {
+public:
+  using IndexT = IndexType;
+
+  struct Edge {
+    IndexT source;
+    IndexT target;
+  };
+
+  /*
+  Creates n_agents agents without edges, each in a component of its own
+  */
+  explicit IncrementalSCC(size_t n_agents)
+      : out_neighbours(n_agents), in_neighbours(n_agents), labels(n_agents),
+        members(n_agents), keys(n_agents), local_index(n_agents),
+        marks(n_agents, 0) {
+    const uint64_t spacing = key_spacing(n_agents);
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      labels[i_agent] = static_cast<IndexT>(i_agent);
+      members[i_agent] = {static_cast<IndexT>(i_agent)};
+      keys[i_agent] = (i_agent + 1) * spacing;
+      order.emplace_hint(order.end(), keys[i_agent],
+                         static_cast<IndexT>(i_agent));
+    }
+  }
+
+  /*
+  Copies the edges of a network and finds its components with Tarjan's
+  algorithm
+  */
+  template <NetworkView NetworkT>
+  explicit IncrementalSCC(const NetworkT &network)
+      : IncrementalSCC(network.n_agents()) {
+    for (size_t i_agent = 0; i_agent < n_agents(); i_agent++) {
+      for (size_t j_agent : network.get_neighbours(i_agent)) {
+        out_neighbours[i_agent].push_back(static_cast<IndexT>(j_agent));
+        in_neighbours[j_agent].push_back(static_cast<IndexT>(i_agent));
+      }
+    }
+
+    const auto scc_list =
+        TarjanConnectivityAlgo<IndexT>(out_neighbours).scc_list;
+    std::vector<bool> used(n_agents(), false);
+    for (auto &component : members) {
+      component.clear();
+    }
+    // Tarjan's algorithm finds the components in reverse topological order.
+    // Each component is labelled with its first vertex
+    const uint64_t spacing = key_spacing(scc_list.size());
+    order.clear();
+    for (size_t k = scc_list.size(); k-- > 0;) {
+      const auto component = scc_list[k];
+      const IndexT label = component[0];
+      used[label] = true;
+      members[label].assign(component.begin(), component.end());
+      for (IndexT v : component) {
+        labels[v] = label;
+      }
+      keys[label] = (scc_list.size() - k) * spacing;
+      order.emplace_hint(order.end(), keys[label], label);
+    }
+    for (size_t label = n_agents(); label-- > 0;) {
+      if (!used[label]) {
+        free_labels.push_back(static_cast<IndexT>(label));
+      }
+    }
+  }
+
+  [[nodiscard]] std::size_t n_agents() const { return labels.size(); }
+
+  /*
+  Gives the number of strongly connected components
+  */
+  [[nodiscard]] std::size_t n_components() const {
+    return n_agents() - free_labels.size();
+  }
+
+  /*
+  Gives the label of the component of an agent
+  */
+  [[nodiscard]] IndexT component(std::size_t i_agent) const {
+    return labels[i_agent];
+  }
+
+  [[nodiscard]] bool same_component(std::size_t i_agent,
+                                    std::size_t j_agent) const {
+    return labels[i_agent] == labels[j_agent];
+  }
+
+  /*
+  Gives the agents in the component with the given label (in no particular
+  order)
+  */
+  [[nodiscard]] std::span<const IndexT>
+  component_members(std::size_t label) const {
+    return members[label];
+  }
+
+  /*
+  Gives the labels of all components, in a topological order of the
+  condensation: an edge between two components never goes backwards
+  */
+  [[nodiscard]] std::vector<IndexT> topological_order() const {
+    std::vector<IndexT> labels_in_order{};
+    labels_in_order.reserve(n_components());
+    for (const auto &[key, label] : order) {
+      labels_in_order.push_back(label);
+    }
+    return labels_in_order;
+  }
+
+  /*
+  Gives the components as lists of agents, in topological order
+  */
+  [[nodiscard]] std::vector<std::vector<IndexT>>
+  strongly_connected_components() const {
+    std::vector<std::vector<IndexT>> components{};
+    for (IndexT label : topological_order()) {
+      components.push_back(members[label]);
+    }
+    return components;
+  }
+
+  /*
+  Gives the labels of the components which the edges leaving the component
+  with the given label lead to, sorted. Costs the number of those edges
+  */
+  [[nodiscard]] std::vector<IndexT>
+  condensation_neighbours(std::size_t label) const {
+    std::vector<IndexT> neighbours{};
+    for (IndexT v : members[label]) {
+      for (IndexT w : out_neighbours[v]) {
+        if (labels[w] != label) {
+          neighbours.push_back(labels[w]);
+        }
+      }
+    }
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+                     neighbours.end());
+    return neighbours;
+  }
+
+  /*
+  Gives the condensation as an adjacency list indexed by the labels. The rows
+  of unused labels are empty
+  */
+  [[nodiscard]] std::vector<std::vector<IndexT>> condensation() const {
+    std::vector<std::vector<IndexT>> condensed(n_agents());
+    for (size_t label = 0; label < n_agents(); label++) {
+      condensed[label] = condensation_neighbours(label);
+    }
+    return condensed;
+  }
+
+  /*
+  Inserts an edge from source to target. Gives true if it closed a cycle,
+  i.e. components were merged
+  */
+  bool insert_edge(std::size_t source, std::size_t target) {
+    check_agents(source, target, "insert_edge");
+    out_neighbours[source].push_back(static_cast<IndexT>(target));
+    in_neighbours[target].push_back(static_cast<IndexT>(source));
+    return restore_order(labels[source], labels[target]);
+  }
+
+  /*
+  Inserts a batch of edges, one after the other. Gives the number of edges
+  which closed a cycle
+  */
+  std::size_t insert_edges(std::span<const Edge> edges) {
+    for (const auto &edge : edges) {
+      check_agents(edge.source, edge.target, "insert_edges");
+    }
+    size_t n_merges = 0;
+    for (const auto &edge : edges) {
+      n_merges += insert_edge(edge.source, edge.target);
+    }
+    return n_merges;
+  }
+
+  /*
+  Removes one edge from source to target, and splits its component if
+  needed. Gives false if there is no such edge
+  */
+  bool remove_edge(std::size_t source, std::size_t target) {
+    check_agents(source, target, "remove_edge");
+    if (!erase_edge(source, target)) {
+      return false;
+    }
+    if (labels[source] == labels[target]) {
+      split(labels[source]);
+    }
+    return true;
+  }
+
+  /*
+  Removes a batch of edges. Every component which lost an edge inside it is
+  recomputed once, after all edges are removed. Gives the number of edges
+  removed
+  */
+  std::size_t remove_edges(std::span<const Edge> edges) {
+    for (const auto &edge : edges) {
+      check_agents(edge.source, edge.target, "remove_edges");
+    }
+    size_t n_removed = 0;
+    std::vector<IndexT> touched{};
+    for (const auto &edge : edges) {
+      if (!erase_edge(edge.source, edge.target)) {
+        continue;
+      }
+      n_removed++;
+      const IndexT label = labels[edge.source];
+      if (label == labels[edge.target] && !marks[label]) {
+        marks[label] = 1;
+        touched.push_back(label);
+      }
+    }
+    for (IndexT label : touched) {
+      marks[label] = 0;
+      split(label);
+    }
+    return n_removed;
+  }
+
+private:
+  // Keys lie in (0, key_universe), so that 0 and key_universe can stand for
+  // the ends of the order, and no key arithmetic overflows
+  static constexpr uint64_t key_universe = uint64_t(1) << 62;
+
+  // A window of 2^level keys is sparse enough to be spaced out if it holds
+  // fewer than (2 / key_overflow)^level components, so larger windows need to
+  // be sparser, which bounds the keys that are spaced out on average
+  static constexpr double key_overflow = 1.25;
+
+  // The distance between the keys of n_components spaced out evenly
+  static uint64_t key_spacing(size_t n_components) {
+    return key_universe / (n_components + 1);
+  }
+
+  // Bits of marks, for the components seen by the two searches
+  static constexpr char forward_mark = 1;
+  static constexpr char backward_mark = 2;
+
+  // A search over the components which can be advanced one edge at a time
+  struct Search {
+    std::vector<IndexT> found{};
+    size_t i_found = 0;  // The component whose edges are followed
+    size_t i_member = 0; // Its agent whose edges are followed
+    size_t i_edge = 0;   // The next edge of that agent
+  };
+
+  std::vector<std::vector<IndexT>> out_neighbours;
+  std::vector<std::vector<IndexT>> in_neighbours;
+  std::vector<IndexT> labels;               // component label per agent
+  std::vector<std::vector<IndexT>> members; // agents per label
+  std::vector<uint64_t> keys;               // topological key per label
+  std::map<uint64_t, IndexT> order{};       // label per key, in key order
+  std::vector<IndexT> free_labels{};
+
+  // Scratch space, kept between changes
+  std::vector<IndexT> local_index;
+  std::vector<char> marks;
+  Search forward{};
+  Search backward{};
+
+  void check_agents(size_t source, size_t target, const char *name) const {
+    if (source >= n_agents() || target >= n_agents()) {
+      throw std::runtime_error(fmt::format(
+          "IncrementalSCC::{}: the agent index is out of range!", name));
+    }
+  }
+
+  // Removes one edge from source to target from both directions. Gives false
+  // if there is no such edge
+  bool erase_edge(size_t source, size_t target) {
+    auto erase_one = [](std::vector<IndexT> &row, size_t value) {
+      const auto it = std::find(row.begin(), row.end(), value);
+      if (it == row.end()) {
+        return false;
+      }
+      *it = row.back();
+      row.pop_back();
+      return true;
+    };
+    if (!erase_one(out_neighbours[source], target)) {
+      return false;
+    }
+    erase_one(in_neighbours[target], source);
+    return true;
+  }
+
+  void start_search(Search &search, IndexT start, char mark) {
+    search = Search{std::move(search.found)};
+    search.found.assign(1, start);
+    marks[start] |= mark;
+  }
+
+  // Follows the next edge of a search along the given edges, to components
+  // accepted by in_region, which are marked with the given bit. Gives false
+  // if the search is complete
+  template <typename InRegionFunc>
+  bool advance(Search &search, char mark,
+               const std::vector<std::vector<IndexT>> &adjacency,
+               InRegionFunc in_region) {
+    while (search.i_found < search.found.size()) {
+      const auto &component = members[search.found[search.i_found]];
+      if (search.i_member == component.size()) {
+        search.i_found++;
+        search.i_member = 0;
+        continue;
+      }
+      const auto &row = adjacency[component[search.i_member]];
+      if (search.i_edge == row.size()) {
+        search.i_member++;
+        search.i_edge = 0;
+        continue;
+      }
+      const IndexT label = labels[row[search.i_edge++]];
+      if (!(marks[label] & mark) && in_region(label)) {
+        marks[label] |= mark;
+        search.found.push_back(label);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  void sort_by_key(std::vector<IndexT> &components) const {
+    std::sort(components.begin(), components.end(),
+              [&](IndexT a, IndexT b) { return keys[a] < keys[b]; });
+  }
+
+  // Restores the topological order after an edge from component source to
+  // component target was inserted. Gives true if the edge closed a cycle
+  bool restore_order(IndexT source, IndexT target) {
+    if (source == target || keys[source] < keys[target]) {
+      return false;
+    }
+    const uint64_t low = keys[target];
+    const uint64_t high = keys[source];
+    const auto in_range = [&](IndexT label) {
+      return keys[label] >= low && keys[label] <= high;
+    };
+    start_search(forward, target, forward_mark);
+    start_search(backward, source, backward_mark);
+    bool forward_complete = false;
+    while (!forward_complete) {
+      forward_complete =
+          !advance(forward, forward_mark, out_neighbours, in_range);
+      if (!forward_complete &&
+          !advance(backward, backward_mark, in_neighbours, in_range)) {
+        break;
+      }
+    }
+
+    // The complete search, the other one, and the end of the edge which the
+    // complete search heads for
+    Search &complete = forward_complete ? forward : backward;
+    Search &other = forward_complete ? backward : forward;
+    const char complete_mark = forward_complete ? forward_mark : backward_mark;
+    const char other_mark = forward_complete ? backward_mark : forward_mark;
+    const IndexT far_end = forward_complete ? source : target;
+    for (IndexT label : other.found) {
+      marks[label] &= ~other_mark;
+    }
+
+    // If the complete search got to the far end, the components of it which
+    // can be reached back from the far end are on the cycle
+    const bool closes_cycle = marks[far_end] & complete_mark;
+    if (closes_cycle) {
+      start_search(other, far_end, other_mark);
+      while (advance(other, other_mark,
+                     forward_complete ? in_neighbours : out_neighbours,
+                     [&](IndexT label) {
+                       return (marks[label] & complete_mark) != 0;
+                     })) {
+      }
+    } else {
+      other.found.clear();
+    }
+
+    // The complete search moves next to the far end, or into its place if it
+    // is merged. The edges from outside into the moved components come from
+    // components in front of that place, and their edges to outside go to
+    // components behind it, so the order stays valid
+    std::vector<IndexT> run{};
+    for (IndexT label : complete.found) {
+      if (!(marks[label] & other_mark)) {
+        run.push_back(label);
+      }
+    }
+    sort_by_key(run);
+    const uint64_t far_key = keys[far_end];
+    for (IndexT label : complete.found) {
+      order.erase(keys[label]);
+    }
+    if (closes_cycle) {
+      const IndexT merged = merge(other.found);
+      run.insert(forward_complete ? run.begin() : run.end(), merged);
+    }
+    insert_run(run, forward_complete ? order.upper_bound(far_key)
+                                     : order.lower_bound(far_key));
+
+    for (IndexT label : complete.found) {
+      marks[label] = 0;
+    }
+    return closes_cycle;
+  }
+
+  // Puts the components of run, which are not in the order, right in front
+  // of next (or at the end), in the order of run. If there are not enough
+  // free keys there, the keys of the smallest sparse enough window around
+  // that place are spaced out evenly, together with run
+  void insert_run(const std::vector<IndexT> &run,
+                  typename std::map<uint64_t, IndexT>::iterator next) {
+    const uint64_t before =
+        next == order.begin() ? 0 : std::prev(next)->first;
+    const uint64_t after = next == order.end() ? key_universe : next->first;
+    if (after - before > run.size()) {
+      const uint64_t step = (after - before) / (run.size() + 1);
+      for (size_t i = 0; i < run.size(); i++) {
+        keys[run[i]] = before + (i + 1) * step;
+        order.emplace_hint(next, keys[run[i]], run[i]);
+      }
+      return;
+    }
+
+    // Without a sparse enough window, all keys are spaced out
+    uint64_t window_begin = 0;
+    uint64_t window_size = key_universe;
+    for (int level = 1; uint64_t(1) << level < key_universe; level++) {
+      const uint64_t size = uint64_t(1) << level;
+      const uint64_t begin = before & ~(size - 1);
+      size_t n_window = 0;
+      for (auto it = order.lower_bound(begin);
+           it != order.end() && it->first < begin + size; it++) {
+        n_window++;
+      }
+      if (double(n_window + run.size()) <
+          std::pow(2.0 / key_overflow, level)) {
+        window_begin = begin;
+        window_size = size;
+        break;
+      }
+    }
+
+    // The window in order, with run in its place
+    std::vector<IndexT> spaced{};
+    auto it = order.lower_bound(window_begin);
+    for (; it != next; it++) {
+      spaced.push_back(it->second);
+    }
+    spaced.insert(spaced.end(), run.begin(), run.end());
+    for (; it != order.end() && it->first < window_begin + window_size; it++) {
+      spaced.push_back(it->second);
+    }
+    order.erase(order.lower_bound(window_begin), it);
+    const uint64_t step = window_size / (spaced.size() + 1);
+    for (size_t i = 0; i < spaced.size(); i++) {
+      keys[spaced[i]] = window_begin + (i + 1) * step;
+      order.emplace_hint(it, keys[spaced[i]], spaced[i]);
+    }
+  }
+
+  // Merges the given components into the largest of them, whose label is
+  // returned. The other labels are freed
+  IndexT merge(const std::vector<IndexT> &components) {
+    const IndexT merged = *std::max_element(
+        components.begin(), components.end(), [&](IndexT a, IndexT b) {
+          return members[a].size() < members[b].size();
+        });
+    for (IndexT label : components) {
+      if (label == merged) {
+        continue;
+      }
+      for (IndexT v : members[label]) {
+        labels[v] = merged;
+        members[merged].push_back(v);
+      }
+      std::vector<IndexT>().swap(members[label]);
+      free_labels.push_back(label);
+    }
+    return merged;
+  }
+
+  // Runs Tarjan's algorithm on the agents of one component, with the edges
+  // between them. If it falls apart, the pieces get labels, and keys in the
+  // place of the component
+  void split(IndexT label) {
+    const auto agents = members[label];
+    for (size_t k = 0; k < agents.size(); k++) {
+      local_index[agents[k]] = static_cast<IndexT>(k);
+    }
+    std::vector<std::vector<IndexT>> local_adjacency(agents.size());
+    for (size_t k = 0; k < agents.size(); k++) {
+      for (IndexT w : out_neighbours[agents[k]]) {
+        if (labels[w] == label) {
+          local_adjacency[k].push_back(local_index[w]);
+        }
+      }
+    }
+    const auto scc_list =
+        TarjanConnectivityAlgo<IndexT>(local_adjacency).scc_list;
+    const size_t n_pieces = scc_list.size();
+    if (n_pieces == 1) {
+      return;
+    }
+
+    // Tarjan's algorithm finds the pieces in reverse topological order; the
+    // first piece keeps the label. They take the place of the component
+    members[label].clear();
+    std::vector<IndexT> pieces(n_pieces);
+    for (size_t p = 0; p < n_pieces; p++) {
+      const IndexT piece = p == 0 ? label : take_free_label();
+      for (IndexT k : scc_list[p]) {
+        labels[agents[k]] = piece;
+        members[piece].push_back(agents[k]);
+      }
+      pieces[n_pieces - 1 - p] = piece;
+    }
+    insert_run(pieces, order.erase(order.find(keys[label])));
+  }
+
+  IndexT take_free_label() {
+    const IndexT label = free_labels.back();
+    free_labels.pop_back();
+    return label;
+  }
+};
+
+template <NetworkView NetworkT>
+IncrementalSCC(const NetworkT &) -> IncrementalSCC<network_index_t<NetworkT>>;
+
+} // namespace Graph
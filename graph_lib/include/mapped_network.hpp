@@ -0,0 +1,498 @@
+#pragma once
+#include "connectivity.hpp"
+#include "directed_network.hpp"
+#include "network_base.hpp"
+#include "network_view.hpp"
+#include "undirected_network.hpp"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    What the rows of a network file hold: the outgoing or the incoming edges of
+    each agent (of a directed network), or the edges of an undirected network,
+    stored once for each agent
+*/
+enum class StoredDirection : std::uint32_t {
+  Outgoing = 0,
+  Incoming = 1,
+  Undirected = 2
+};
+
+/*
+    The header at the start of a binary network file (version 1).
+
+    The file is a CSR snapshot of the network, like the CompressedNetwork,
+    written in the byte order of the machine that wrote it:
+
+        header
+        offsets     n_agents + 1 values of type uint64_t
+        neighbours  n_edges values of the index type
+        weights     n_edges values of the weight type
+
+    Each section starts at a multiple of binary_network_alignment bytes, at the
+    position given in the header, and the gaps are filled with zeros.
+*/
+struct BinaryNetworkHeader {
+  char magic[8];              // "GRAPHLIB"
+  std::uint32_t version;      // binary_network_version
+  std::uint32_t byte_order;   // binary_network_byte_order, as written
+  std::uint32_t index_bytes;  // sizeof the neighbour index type
+  std::uint32_t weight_bytes; // sizeof the weight type
+  std::uint32_t weight_kind;  // See Detail::weight_kind
+  std::uint32_t direction;    // A StoredDirection
+  std::uint64_t n_agents;
+  std::uint64_t n_edges;
+  std::uint64_t offsets_position; // Positions of the sections in the file
+  std::uint64_t neighbours_position;
+  std::uint64_t weights_position;
+  std::uint64_t file_size;
+};
+
+inline constexpr char binary_network_magic[8] = {'G', 'R', 'A', 'P',
+                                                 'H', 'L', 'I', 'B'};
+inline constexpr std::uint32_t binary_network_version = 1;
+inline constexpr std::uint32_t binary_network_byte_order = 0x01020304;
+inline constexpr std::uint64_t binary_network_alignment = 64;
+
+namespace Detail {
+
+// 0 for unsigned integer, 1 for signed integer and 2 for floating point weights
+template <typename WeightT> constexpr std::uint32_t weight_kind() {
+  if constexpr (std::is_floating_point_v<WeightT>) {
+    return 2;
+  } else if constexpr (std::is_signed_v<WeightT>) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+inline std::uint64_t align_position(std::uint64_t position) {
+  return (position + binary_network_alignment - 1) /
+         binary_network_alignment * binary_network_alignment;
+}
+
+// Lays out the sections of a file for a network of the given size
+template <typename WeightT, typename IndexT>
+BinaryNetworkHeader make_binary_header(std::uint64_t n_agents,
+                                       std::uint64_t n_edges,
+                                       StoredDirection direction) {
+  BinaryNetworkHeader header{};
+  std::memcpy(header.magic, binary_network_magic, sizeof(header.magic));
+  header.version = binary_network_version;
+  header.byte_order = binary_network_byte_order;
+  header.index_bytes = sizeof(IndexT);
+  header.weight_bytes = sizeof(WeightT);
+  header.weight_kind = weight_kind<WeightT>();
+  header.direction = static_cast<std::uint32_t>(direction);
+  header.n_agents = n_agents;
+  header.n_edges = n_edges;
+  header.offsets_position = align_position(sizeof(BinaryNetworkHeader));
+  header.neighbours_position = align_position(
+      header.offsets_position + (n_agents + 1) * sizeof(std::uint64_t));
+  header.weights_position =
+      align_position(header.neighbours_position + n_edges * sizeof(IndexT));
+  header.file_size = header.weights_position + n_edges * sizeof(WeightT);
+  return header;
+}
+
+// Pads the stream with zeros up to position
+inline void pad_to(std::ofstream &file, std::uint64_t position) {
+  static constexpr char zeros[binary_network_alignment] = {};
+  const auto current = static_cast<std::uint64_t>(file.tellp());
+  file.write(zeros, static_cast<std::streamsize>(position - current));
+}
+
+template <typename T>
+void write_span(std::ofstream &file, std::span<const T> values) {
+  file.write(reinterpret_cast<const char *>(values.data()),
+             static_cast<std::streamsize>(values.size_bytes()));
+}
+
+} // namespace Detail
+
+/*
+    Writes the rows of any weighted network to a binary network file at path,
+    recording direction as what the rows hold. The neighbour indices are
+    written with the index type of the network.
+
+    The file is written next to path and then renamed, so that processes which
+    have the old file mapped keep seeing a complete network.
+*/
+template <WeightedNetworkView NetworkT>
+void write_binary_network(const NetworkT &network, const std::string &path,
+                          StoredDirection direction) {
+  using WeightT = typename NetworkT::WeightT;
+  using IndexT = network_index_t<NetworkT>;
+  static_assert(std::is_arithmetic_v<WeightT>,
+                "write_binary_network: the weights need to be numbers");
+
+  const size_t n_agents = network.n_agents();
+  std::vector<std::uint64_t> offsets(n_agents + 1, 0);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    offsets[i_agent + 1] =
+        offsets[i_agent] + network.get_neighbours(i_agent).size();
+  }
+  const auto header = Detail::make_binary_header<WeightT, IndexT>(
+      n_agents, offsets.back(), direction);
+
+  // A unique temporary name, so that processes writing the same path at the
+  // same time do not write into each other's file
+  std::string temporary_path = path + ".XXXXXX";
+  const int fd = ::mkstemp(temporary_path.data());
+  if (fd < 0) {
+    throw std::runtime_error(fmt::format(
+        "write_binary_network: could not create a file next to {}!", path));
+  }
+  // mkstemp makes the file private; other processes need to map it
+  ::fchmod(fd, 0644);
+  ::close(fd);
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      std::remove(temporary_path.c_str());
+      throw std::runtime_error(fmt::format(
+          "write_binary_network: could not open {}!", temporary_path));
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    Detail::pad_to(file, header.offsets_position);
+    Detail::write_span<std::uint64_t>(file, offsets);
+    Detail::pad_to(file, header.neighbours_position);
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      Detail::write_span<IndexT>(file, network.get_neighbours(i_agent));
+    }
+    Detail::pad_to(file, header.weights_position);
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      Detail::write_span<WeightT>(file, network.get_weights(i_agent));
+    }
+    file.close();
+    if (!file) {
+      std::remove(temporary_path.c_str());
+      throw std::runtime_error(fmt::format(
+          "write_binary_network: could not write {}!", temporary_path));
+    }
+  }
+  if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    std::remove(temporary_path.c_str());
+    throw std::runtime_error(
+        fmt::format("write_binary_network: could not write {}!", path));
+  }
+}
+
+/*
+    Writes a network to a binary network file at path. The stored direction is
+    that of a DirectedNetwork, Undirected for an UndirectedNetwork, and
+    Outgoing for any other network (e.g. the BidirectionalNetwork, whose
+    neighbour list holds the outgoing edges)
+*/
+template <typename WeightT, typename IndexT>
+void write_binary_network(const NetworkBase<WeightT, IndexT> &network,
+                          const std::string &path) {
+  using DirectedT = DirectedNetwork<WeightT, IndexT>;
+  auto direction = StoredDirection::Outgoing;
+  if (const auto *directed = dynamic_cast<const DirectedT *>(&network)) {
+    direction = directed->direction() == DirectedT::EdgeDirection::Incoming
+                    ? StoredDirection::Incoming
+                    : StoredDirection::Outgoing;
+  } else if (dynamic_cast<const UndirectedNetwork<WeightT, IndexT> *>(
+                 &network) != nullptr) {
+    direction = StoredDirection::Undirected;
+  }
+  write_binary_network(network, path, direction);
+}
+
+/*
+    A read-only network backed by a memory-mapped binary network file, with
+    the same interface as the CompressedNetwork. Opening it only maps the file
+    and checks the header, the offsets and the neighbour indices: the rows are
+    read straight from the page cache, without copying, and processes which
+    map the same file share its pages.
+
+    The weight type and the index type have to be those the file was written
+    with. The file must not be changed in place while it is mapped;
+    write_binary_network replaces it instead.
+*/
+template <typename WeightType = double,
+          std::unsigned_integral IndexType = size_t>
+class MappedNetwork {
+public:
+  using WeightT = WeightType;
+  using IndexT = IndexType;
+
+private:
+  void *mapping = nullptr; // Start of the mapped file
+  size_t mapping_size = 0; // Length of the mapping in bytes
+  BinaryNetworkHeader header{};
+  const std::uint64_t *offsets = nullptr; // Point into the mapping
+  const IndexT *neighbours = nullptr;
+  const WeightT *weights = nullptr;
+
+  void unmap() {
+    if (mapping != nullptr) {
+      munmap(mapping, mapping_size);
+      mapping = nullptr;
+    }
+  }
+
+  [[noreturn]] void fail(const std::string &path, const std::string &reason) {
+    unmap();
+    throw std::runtime_error(
+        fmt::format("MappedNetwork: {} {}!", path, reason));
+  }
+
+  void check_header(const std::string &path) {
+    if (mapping_size < sizeof(BinaryNetworkHeader)) {
+      fail(path, "is too short to be a network file");
+    }
+    std::memcpy(&header, mapping, sizeof(header));
+    if (std::memcmp(header.magic, binary_network_magic,
+                    sizeof(header.magic)) != 0) {
+      fail(path, "is not a network file");
+    }
+    if (header.version != binary_network_version) {
+      fail(path, fmt::format("has the unsupported version {}", header.version));
+    }
+    if (header.byte_order != binary_network_byte_order) {
+      fail(path, "was written with a different byte order");
+    }
+    if (header.index_bytes != sizeof(IndexT)) {
+      fail(path, fmt::format("has {}-byte indices", header.index_bytes));
+    }
+    if (header.weight_bytes != sizeof(WeightT) ||
+        header.weight_kind != Detail::weight_kind<WeightT>()) {
+      fail(path, "has a different weight type");
+    }
+    if (header.direction >
+        static_cast<std::uint32_t>(StoredDirection::Undirected)) {
+      fail(path, "has an unknown direction");
+    }
+    // Sizes which cannot fit into the file are rejected first, so that the
+    // section sizes below cannot overflow
+    if (header.n_agents >= mapping_size / sizeof(std::uint64_t) ||
+        header.n_edges > mapping_size / sizeof(IndexT) ||
+        header.n_edges > mapping_size / sizeof(WeightT)) {
+      fail(path, "has sizes which do not fit into the file");
+    }
+    // The layout is recomputed, so that the positions are known to lie inside
+    // the file and to be aligned
+    const auto expected = Detail::make_binary_header<WeightT, IndexT>(
+        header.n_agents, header.n_edges, StoredDirection(header.direction));
+    if (header.offsets_position != expected.offsets_position ||
+        header.neighbours_position != expected.neighbours_position ||
+        header.weights_position != expected.weights_position ||
+        header.file_size != expected.file_size ||
+        header.file_size > mapping_size) {
+      fail(path, "has an inconsistent layout or is truncated");
+    }
+  }
+
+public:
+  MappedNetwork() = default;
+
+  /*
+  Maps the network file at path. Throws if it cannot be opened or is not a
+  network file with this weight type and index type.
+  With check_rows, all offsets and neighbour indices are read once to check
+  that every row lies inside the file and every neighbour is an agent.
+  Without it, only the first and the last offset are checked, so opening does
+  not touch the pages of the rows, but the file has to be trusted: damaged
+  offsets give rows outside of the mapping, and damaged indices make the
+  algorithms index their per-agent arrays out of bounds
+  */
+  explicit MappedNetwork(const std::string &path, bool check_rows = true) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      throw std::runtime_error(
+          fmt::format("MappedNetwork: could not open {}!", path));
+    }
+    struct stat file_stat {};
+    if (::fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+      ::close(fd);
+      throw std::runtime_error(
+          fmt::format("MappedNetwork: {} is empty!", path));
+    }
+    mapping_size = static_cast<size_t>(file_stat.st_size);
+    mapping = ::mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      throw std::runtime_error(
+          fmt::format("MappedNetwork: could not map {}!", path));
+    }
+
+    check_header(path);
+    const auto *bytes = static_cast<const char *>(mapping);
+    offsets = reinterpret_cast<const std::uint64_t *>(
+        bytes + header.offsets_position);
+    neighbours =
+        reinterpret_cast<const IndexT *>(bytes + header.neighbours_position);
+    weights =
+        reinterpret_cast<const WeightT *>(bytes + header.weights_position);
+    if (offsets[0] != 0 || offsets[header.n_agents] != header.n_edges) {
+      fail(path, "has inconsistent offsets");
+    }
+    if (check_rows) {
+      for (size_t i_agent = 0; i_agent < header.n_agents; i_agent++) {
+        if (offsets[i_agent + 1] < offsets[i_agent] ||
+            offsets[i_agent + 1] > header.n_edges) {
+          fail(path, "has inconsistent offsets");
+        }
+      }
+      const auto n_agents = header.n_agents;
+      if (std::any_of(neighbours, neighbours + header.n_edges,
+                      [&](IndexT j_agent) { return j_agent >= n_agents; })) {
+        fail(path, "has neighbour indices which are not agents");
+      }
+    }
+  }
+
+  MappedNetwork(const MappedNetwork &) = delete;
+  MappedNetwork &operator=(const MappedNetwork &) = delete;
+
+  MappedNetwork(MappedNetwork &&other) noexcept
+      : mapping(std::exchange(other.mapping, nullptr)),
+        mapping_size(std::exchange(other.mapping_size, 0)),
+        header(other.header), offsets(std::exchange(other.offsets, nullptr)),
+        neighbours(std::exchange(other.neighbours, nullptr)),
+        weights(std::exchange(other.weights, nullptr)) {}
+
+  MappedNetwork &operator=(MappedNetwork &&other) noexcept {
+    if (this != &other) {
+      unmap();
+      mapping = std::exchange(other.mapping, nullptr);
+      mapping_size = std::exchange(other.mapping_size, 0);
+      header = other.header;
+      offsets = std::exchange(other.offsets, nullptr);
+      neighbours = std::exchange(other.neighbours, nullptr);
+      weights = std::exchange(other.weights, nullptr);
+    }
+    return *this;
+  }
+
+  ~MappedNetwork() { unmap(); }
+
+  /*
+  Gives what the rows hold (outgoing, incoming or undirected edges)
+  */
+  [[nodiscard]] StoredDirection direction() const {
+    return StoredDirection(header.direction);
+  }
+
+  /*
+  Gives the total number of nodes in the network
+  */
+  [[nodiscard]] std::size_t n_agents() const {
+    return mapping == nullptr ? 0 : header.n_agents;
+  }
+
+  /*
+  Gives the number of edges stored for agent_idx
+  If agent_idx is nullopt, gives the total number of stored edges
+  */
+  [[nodiscard]] std::size_t
+  n_edges(std::optional<std::size_t> agent_idx = std::nullopt) const {
+    if (agent_idx.has_value()) {
+      return offsets[agent_idx.value() + 1] - offsets[agent_idx.value()];
+    } else {
+      return mapping == nullptr ? 0 : header.n_edges;
+    }
+  }
+
+  /*
+  Gives a view into the neighbour indices connected to agent_idx
+  */
+  [[nodiscard]] std::span<const IndexT>
+  get_neighbours(std::size_t agent_idx) const {
+    return std::span<const IndexT>(neighbours + offsets[agent_idx],
+                                   n_edges(agent_idx));
+  }
+
+  /*
+  Gives a view into the edge weights corresponding to edges connected to
+  agent_idx
+  */
+  [[nodiscard]] std::span<const WeightT>
+  get_weights(std::size_t agent_idx) const {
+    return std::span<const WeightT>(weights + offsets[agent_idx],
+                                    n_edges(agent_idx));
+  }
+
+  /*
+  Gets the weight for agent_idx, for a neighbour index
+  */
+  const WeightT get_edge_weight(std::size_t agent_idx,
+                                std::size_t index_neighbour) const {
+    return weights[offsets[agent_idx] + index_neighbour];
+  }
+
+  /*
+  Checks if a connection exists between two agents i_idx and j_idx
+  */
+  bool connection_exists(size_t i_idx, size_t j_idx) const {
+    auto i_neighbours = get_neighbours(i_idx);
+    return std::find(i_neighbours.begin(), i_neighbours.end(), j_idx) !=
+           std::end(i_neighbours);
+  }
+
+  /*
+  Gives the strongly connected components in the graph, in one flat buffer
+  (preferred for large networks: no allocation per component)
+  If n_threads is set, the multi-threaded ParallelConnectivityAlgo is used
+  */
+  [[nodiscard]] ComponentList<IndexT> strongly_connected_component_list(
+      std::optional<size_t> n_threads = std::nullopt) const {
+    if (n_threads.has_value()) {
+      return std::move(ParallelConnectivityAlgo(*this, n_threads).scc_list);
+    }
+    return std::move(TarjanConnectivityAlgo(*this).scc_list);
+  }
+
+  /*
+  Gives the strongly connected components in the graph, as a vector of vectors
+  If n_threads is set, the multi-threaded ParallelConnectivityAlgo is used
+  */
+  [[nodiscard]] std::vector<std::vector<IndexT>> strongly_connected_components(
+      std::optional<size_t> n_threads = std::nullopt) const {
+    return strongly_connected_component_list(n_threads).to_nested();
+  }
+
+  /*
+  Views into the mapped arrays
+  */
+  [[nodiscard]] std::span<const std::uint64_t> get_offsets() const {
+    if (mapping == nullptr) {
+      return {};
+    }
+    return std::span<const std::uint64_t>(offsets, n_agents() + 1);
+  }
+
+  [[nodiscard]] std::span<const IndexT> get_all_neighbours() const {
+    return std::span<const IndexT>(neighbours, n_edges());
+  }
+
+  [[nodiscard]] std::span<const WeightT> get_all_weights() const {
+    return std::span<const WeightT>(weights, n_edges());
+  }
+};
+
+} // namespace Graph
@@ -0,0 +1,346 @@
+#pragma once
+#include "directed_network.hpp"
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Graph {
+
+/*
+    How the rows of a network enter the weighted neighbour sum
+    y[i] = sum_j w_ij * x[j], where w_ij is the weight of the edge j -> i.
+    Gather: the row of agent i holds the edges j -> i (incoming edges, or an
+    undirected network), so y[i] is summed over the row of i.
+    Scatter: the row of agent j holds the edges j -> i (outgoing edges), so
+    every row adds w_ij * x[j] to the entries of its neighbours.
+*/
+enum class AggregationMode { Gather, Scatter };
+
+namespace Detail {
+
+#if defined(__AVX2__)
+// Sum of the 4 lanes of a vector
+inline double horizontal_sum(__m256d sum) {
+  const __m128d half =
+      _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+// Loads the 4 values of x at the given indices with one gather instruction.
+// The masked form with an explicit source avoids a false warning of GCC about
+// the undefined source of the unmasked form
+template <typename IndexT>
+__m256d gather_4(const double *x, const IndexT *indices) {
+  const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+  if constexpr (sizeof(IndexT) == 8) {
+    return _mm256_mask_i64gather_pd(
+        _mm256_setzero_pd(), x,
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices)), all,
+        8);
+  } else {
+    return _mm256_mask_i32gather_pd(
+        _mm256_setzero_pd(), x,
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices)), all, 8);
+  }
+}
+
+// Dot product of a row of double weights with the values of its neighbours,
+// 8 neighbours at a time. 32-bit indices are read as signed, so x needs fewer
+// than 2^31 entries for them
+template <typename IndexT>
+double gather_row_avx2(std::span<const IndexT> neighbours,
+                       std::span<const double> weights, const double *x) {
+  static_assert(sizeof(IndexT) == 4 || sizeof(IndexT) == 8);
+  const size_t n = neighbours.size();
+  __m256d sum_0 = _mm256_setzero_pd();
+  __m256d sum_1 = _mm256_setzero_pd();
+  size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    const __m256d x_0 = gather_4(x, neighbours.data() + k);
+    const __m256d x_1 = gather_4(x, neighbours.data() + k + 4);
+    sum_0 = _mm256_add_pd(
+        sum_0, _mm256_mul_pd(_mm256_loadu_pd(weights.data() + k), x_0));
+    sum_1 = _mm256_add_pd(
+        sum_1, _mm256_mul_pd(_mm256_loadu_pd(weights.data() + k + 4), x_1));
+  }
+  double sum = horizontal_sum(_mm256_add_pd(sum_0, sum_1));
+  for (; k < n; k++) {
+    sum += weights[k] * x[neighbours[k]];
+  }
+  return sum;
+}
+#endif
+
+// Dot product of the weights of a row with the values of its neighbours. Four
+// partial sums keep several additions in flight at once
+template <typename ValueT, typename IndexT, typename WeightT>
+ValueT gather_row(std::span<const IndexT> neighbours,
+                  std::span<const WeightT> weights, const ValueT *x,
+                  [[maybe_unused]] bool small_x) {
+#if defined(__AVX2__)
+  if constexpr (std::is_same_v<ValueT, double> &&
+                std::is_same_v<WeightT, double> &&
+                (sizeof(IndexT) == 8 || sizeof(IndexT) == 4)) {
+    if (sizeof(IndexT) == 8 || small_x) {
+      return gather_row_avx2<IndexT>(neighbours, weights, x);
+    }
+  }
+#endif
+  const size_t n = neighbours.size();
+  ValueT sum[4] = {0, 0, 0, 0};
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4) {
+    for (size_t lane = 0; lane < 4; lane++) {
+      sum[lane] += weights[k + lane] * x[neighbours[k + lane]];
+    }
+  }
+  for (; k < n; k++) {
+    sum[0] += weights[k] * x[neighbours[k]];
+  }
+  return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+// Calls func(neighbour, weight) for every entry of a row. The two views are
+// walked with iterators, so they need not be contiguous
+template <typename NeighboursT, typename WeightsT, typename Func>
+void for_each_entry(const NeighboursT &neighbours, const WeightsT &weights,
+                    Func &&func) {
+  auto weight = std::ranges::begin(weights);
+  for (const auto neighbour : neighbours) {
+    func(size_t(neighbour), *weight);
+    ++weight;
+  }
+}
+
+// Calls func with the number of vectors as a compile-time constant for the
+// common small batch sizes (so that the loops over the vectors are unrolled
+// and the sums stay in registers), or with 0 for any other number
+template <typename Func>
+void dispatch_n_vectors(size_t n_vectors, Func &&func) {
+  switch (n_vectors) {
+  case 1:
+    func(std::integral_constant<size_t, 1>{});
+    break;
+  case 2:
+    func(std::integral_constant<size_t, 2>{});
+    break;
+  case 4:
+    func(std::integral_constant<size_t, 4>{});
+    break;
+  case 8:
+    func(std::integral_constant<size_t, 8>{});
+    break;
+  default:
+    func(std::integral_constant<size_t, 0>{});
+  }
+}
+
+// Gather form for n_vectors values per agent (Width if it is not 0). The rows
+// are handed out to the threads in chunks, since every entry of y is written
+// by one row only. Rows which are not contiguous (like those of a
+// DynamicNetwork with pending changes) are walked with iterators instead of
+// the unrolled dot product
+template <size_t Width, WeightedNetworkView NetworkT, typename ValueT>
+void gather_rows(const NetworkT &network, const ValueT *x, ValueT *y,
+                 size_t n_vectors, size_t n_threads) {
+  using IndexT = network_index_t<NetworkT>;
+  using WeightT = typename NetworkT::WeightT;
+  constexpr bool contiguous_rows =
+      std::ranges::contiguous_range<
+          decltype(network.get_neighbours(size_t(0)))> &&
+      std::ranges::contiguous_range<decltype(network.get_weights(size_t(0)))>;
+  const bool small_x =
+      network.n_agents() <= size_t(std::numeric_limits<int32_t>::max());
+
+  parallel_for(
+      0, network.n_agents(), n_threads,
+      [&](size_t i_agent) {
+        const auto neighbours = network.get_neighbours(i_agent);
+        const auto weights = network.get_weights(i_agent);
+        if constexpr (Width == 1 && contiguous_rows) {
+          y[i_agent] = gather_row(std::span<const IndexT>(neighbours),
+                                  std::span<const WeightT>(weights), x,
+                                  small_x);
+        } else if constexpr (Width == 1) {
+          ValueT sum = 0;
+          for_each_entry(neighbours, weights, [&](size_t j_agent, ValueT w) {
+            sum += w * x[j_agent];
+          });
+          y[i_agent] = sum;
+        } else if constexpr (Width > 1) {
+          ValueT sums[Width] = {};
+          for_each_entry(neighbours, weights, [&](size_t j_agent, ValueT w) {
+            const ValueT *x_row = x + j_agent * Width;
+            for (size_t i_vector = 0; i_vector < Width; i_vector++) {
+              sums[i_vector] += w * x_row[i_vector];
+            }
+          });
+          std::copy(sums, sums + Width, y + i_agent * Width);
+        } else {
+          ValueT *y_row = y + i_agent * n_vectors;
+          std::fill(y_row, y_row + n_vectors, ValueT(0));
+          for_each_entry(neighbours, weights, [&](size_t j_agent, ValueT w) {
+            const ValueT *x_row = x + j_agent * n_vectors;
+            for (size_t i_vector = 0; i_vector < n_vectors; i_vector++) {
+              y_row[i_vector] += w * x_row[i_vector];
+            }
+          });
+        }
+      },
+      1024);
+}
+
+// Scatter form for n_vectors values per agent (Width if it is not 0). Every
+// thread owns a contiguous block of rows and adds into its own partial sums
+// (thread 0 directly into y), which are summed up afterwards, so no atomics
+// are needed. The blocks are fixed, so the result only depends on the number
+// of threads
+template <size_t Width, WeightedNetworkView NetworkT, typename ValueT>
+void scatter_rows(const NetworkT &network, const ValueT *x, ValueT *y,
+                  size_t n_vectors, size_t n_threads) {
+  const size_t n_agents = network.n_agents();
+  const size_t n_values = n_agents * n_vectors;
+  // Small networks are not worth the partial sums
+  n_threads = std::max<size_t>(std::min(n_threads, n_agents / 4096), 1);
+
+  std::fill(y, y + n_values, ValueT(0));
+  auto partial_sums = std::vector<std::vector<ValueT>>(n_threads - 1);
+
+  parallel_for_blocks(
+      0, n_agents, n_threads,
+      [&](size_t block_begin, size_t block_end, size_t i_thread) {
+        ValueT *sums = y;
+        if (i_thread > 0) {
+          partial_sums[i_thread - 1].assign(n_values, ValueT(0));
+          sums = partial_sums[i_thread - 1].data();
+        }
+        const size_t width = Width > 0 ? Width : n_vectors;
+        for (size_t j_agent = block_begin; j_agent < block_end; j_agent++) {
+          const auto neighbours = network.get_neighbours(j_agent);
+          const auto weights = network.get_weights(j_agent);
+          const ValueT *x_row = x + j_agent * width;
+          for_each_entry(neighbours, weights, [&](size_t i_agent, ValueT w) {
+            ValueT *sums_row = sums + i_agent * width;
+            for (size_t i_vector = 0; i_vector < width; i_vector++) {
+              sums_row[i_vector] += w * x_row[i_vector];
+            }
+          });
+        }
+      });
+
+  // Every thread sums up the partial sums for its own block of entries
+  parallel_for_blocks(0, n_values, n_threads,
+                      [&](size_t block_begin, size_t block_end, size_t) {
+                        for (const auto &sums : partial_sums) {
+                          for (size_t i = block_begin; i < block_end; i++) {
+                            y[i] += sums[i];
+                          }
+                        }
+                      });
+}
+
+template <WeightedNetworkView NetworkT, typename ValueT>
+void aggregate_neighbours(const NetworkT &network, AggregationMode mode,
+                          const std::vector<ValueT> &x, std::vector<ValueT> &y,
+                          size_t n_vectors, std::optional<size_t> n_threads) {
+  if (x.size() != network.n_agents() * n_vectors) {
+    throw std::runtime_error("aggregate_neighbours: x needs n_vectors entries "
+                             "for every agent!");
+  }
+  if (&x == &y) {
+    throw std::runtime_error(
+        "aggregate_neighbours: x and y need to be different vectors!");
+  }
+  y.resize(x.size());
+  dispatch_n_vectors(n_vectors, [&](auto width) {
+    if (mode == AggregationMode::Gather) {
+      gather_rows<width()>(network, x.data(), y.data(), n_vectors,
+                           resolve_n_threads(n_threads));
+    } else {
+      scatter_rows<width()>(network, x.data(), y.data(), n_vectors,
+                            resolve_n_threads(n_threads));
+    }
+  });
+}
+
+} // namespace Detail
+
+/*
+Weighted neighbour sum y[i] = sum_j w_ij * x[j] for every agent i, i.e. the
+product of the weighted adjacency matrix with the vector x (one entry per
+agent). mode tells how the rows of the network store the edges, see
+AggregationMode. y is resized to n_agents entries and must not be x.
+Runs on n_threads threads (one per core if not set). The Gather form gives the
+same result on any number of threads, while for the Scatter form the order of
+the floating point additions depends on the number of threads. With AVX2
+enabled at compile time (-mavx2, which the meson option avx2 adds), rows of
+double weights are summed with gather instructions
+*/
+template <WeightedNetworkView NetworkT, typename ValueT>
+void aggregate_neighbours(const NetworkT &network, AggregationMode mode,
+                          const std::vector<ValueT> &x, std::vector<ValueT> &y,
+                          std::optional<size_t> n_threads = std::nullopt) {
+  Detail::aggregate_neighbours(network, mode, x, y, 1, n_threads);
+}
+
+/*
+Same as above, with the mode given by the direction of the network: Gather for
+incoming edges, Scatter for outgoing edges
+*/
+template <typename WeightT, typename IndexT, typename ValueT>
+void aggregate_neighbours(const DirectedNetwork<WeightT, IndexT> &network,
+                          const std::vector<ValueT> &x, std::vector<ValueT> &y,
+                          std::optional<size_t> n_threads = std::nullopt) {
+  using EdgeDirection =
+      typename DirectedNetwork<WeightT, IndexT>::EdgeDirection;
+  const auto mode = network.direction() == EdgeDirection::Incoming
+                        ? AggregationMode::Gather
+                        : AggregationMode::Scatter;
+  Detail::aggregate_neighbours(network, mode, x, y, 1, n_threads);
+}
+
+/*
+Weighted neighbour sum for n_vectors vectors at once (the product of the
+weighted adjacency matrix with a dense matrix). The n_vectors values of agent j
+are x[j * n_vectors] ... x[(j + 1) * n_vectors - 1], and y is laid out the same
+way. Going through the edges once for all the vectors is much faster than
+n_vectors separate calls of aggregate_neighbours
+*/
+template <WeightedNetworkView NetworkT, typename ValueT>
+void aggregate_neighbours_batch(
+    const NetworkT &network, AggregationMode mode,
+    const std::vector<ValueT> &x, std::vector<ValueT> &y, size_t n_vectors,
+    std::optional<size_t> n_threads = std::nullopt) {
+  Detail::aggregate_neighbours(network, mode, x, y, n_vectors, n_threads);
+}
+
+/*
+Same as above, with the mode given by the direction of the network: Gather for
+incoming edges, Scatter for outgoing edges
+*/
+template <typename WeightT, typename IndexT, typename ValueT>
+void aggregate_neighbours_batch(
+    const DirectedNetwork<WeightT, IndexT> &network,
+    const std::vector<ValueT> &x, std::vector<ValueT> &y, size_t n_vectors,
+    std::optional<size_t> n_threads = std::nullopt) {
+  using EdgeDirection =
+      typename DirectedNetwork<WeightT, IndexT>::EdgeDirection;
+  const auto mode = network.direction() == EdgeDirection::Incoming
+                        ? AggregationMode::Gather
+                        : AggregationMode::Scatter;
+  Detail::aggregate_neighbours(network, mode, x, y, n_vectors, n_threads);
+}
+
+} // namespace Graph
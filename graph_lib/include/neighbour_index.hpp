@@ -0,0 +1,126 @@
+#pragma once
+#include "network_view.hpp"
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Graph {
+
+namespace Detail {
+
+// Position of the first entry that is not less than value in the sorted
+// range. Unlike std::lower_bound, the loop has no data-dependent branch (the
+// comparison becomes a conditional move), so that the search does not stall
+// on branch mispredictions in long rows
+template <typename IndexT>
+size_t branchless_lower_bound(std::span<const IndexT> sorted, size_t value) {
+  const IndexT *base = sorted.data();
+  size_t length = sorted.size();
+  while (length > 1) {
+    const size_t half = length / 2;
+    base = (base[half - 1] < value) ? base + half : base;
+    length -= half;
+  }
+  return (base - sorted.data()) + (length == 1 && *base < value);
+}
+
+/*
+    A set of indices, hashed with open addressing (linear probing) into one
+    flat array. It gives the membership of the neighbours of high-degree agents
+    in O(1), where even a binary search jumps across a long row. Entries can
+    only be inserted; the set is rebuilt when a row changes otherwise.
+*/
+template <std::unsigned_integral IndexT> class FlatIndexSet {
+private:
+  std::vector<IndexT> slots{}; // invalid_index marks an empty slot
+  size_t n_entries = 0;
+  unsigned int shift = 64; // 64 - log2 of the number of slots
+
+  // Fibonacci hashing: the top bits of the product are well mixed
+  [[nodiscard]] size_t home_slot(size_t index) const {
+    return (uint64_t(index) * 0x9E3779B97F4A7C15ull) >> shift;
+  }
+
+  void insert_unchecked(IndexT index) {
+    const size_t mask = slots.size() - 1;
+    for (size_t i = home_slot(index);; i = (i + 1) & mask) {
+      if (slots[i] == index) {
+        return;
+      }
+      if (slots[i] == invalid_index<IndexT>) {
+        slots[i] = index;
+        n_entries++;
+        return;
+      }
+    }
+  }
+
+  // Rehashes into enough slots for n entries, keeping the load factor <= 1/2
+  void rehash(size_t n) {
+    const size_t n_slots = std::bit_ceil(std::max<size_t>(2 * n, 8));
+    std::vector<IndexT> old_slots(n_slots, invalid_index<IndexT>);
+    old_slots.swap(slots);
+    shift = 64 - std::countr_zero(n_slots);
+    n_entries = 0;
+    for (IndexT index : old_slots) {
+      if (index != invalid_index<IndexT>) {
+        insert_unchecked(index);
+      }
+    }
+  }
+
+public:
+  [[nodiscard]] bool empty() const { return n_entries == 0; }
+
+  [[nodiscard]] size_t size() const { return n_entries; }
+
+  /*
+  Removes all entries and frees the memory
+  */
+  void clear() {
+    slots = std::vector<IndexT>{};
+    n_entries = 0;
+    shift = 64;
+  }
+
+  /*
+  Replaces the entries by the given indices
+  */
+  void assign(std::span<const IndexT> indices) {
+    clear();
+    rehash(indices.size());
+    for (IndexT index : indices) {
+      insert_unchecked(index);
+    }
+  }
+
+  void insert(IndexT index) {
+    if (2 * (n_entries + 1) > slots.size()) {
+      rehash(n_entries + 1);
+    }
+    insert_unchecked(index);
+  }
+
+  [[nodiscard]] bool contains(size_t index) const {
+    if (slots.empty() || index >= invalid_index<IndexT>) {
+      return false;
+    }
+    const size_t mask = slots.size() - 1;
+    for (size_t i = home_slot(index);; i = (i + 1) & mask) {
+      if (slots[i] == index) {
+        return true;
+      }
+      if (slots[i] == invalid_index<IndexT>) {
+        return false;
+      }
+    }
+  }
+};
+
+} // namespace Detail
+
+} // namespace Graph
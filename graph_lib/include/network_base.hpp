@@ -1,5 +1,10 @@
 #pragma once
 #include "connectivity.hpp"
+#include "duplicate_edges.hpp"
+#include "neighbour_index.hpp"
+#include "parallel.hpp"
+#include "permutation.hpp"
+#include "weight_operations.hpp"
 #include <algorithm>
 #include <cstddef>
 #include <fmt/format.h>
@@ -7,36 +12,134 @@
 #include <optional>
 #include <span>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace Graph {
 
 /*
     An abstract base class for undirected and directed networks.
+    The neighbour indices are stored as IndexType; for networks with less than
+    2^32 agents, uint32_t halves the memory of the adjacency lists.
 */
-template <typename WeightType = double> class NetworkBase {
+template <typename WeightType = double, typename IndexType = size_t>
+class NetworkBase {
 public:
   using WeightT = WeightType;
+  using IndexT = IndexType;
 
 protected:
-  std::vector<std::vector<size_t>>
+  std::vector<std::vector<IndexT>>
       neighbour_list{}; // Neighbour list for the connections
   std::vector<std::vector<WeightT>>
       weight_list{}; // List for the interaction weights of each connections
+  bool sorted_neighbours =
+      false; // In sorted adjacency mode, the rows are kept sorted by index
+  std::optional<size_t>
+      hash_index_min_degree{}; // Agents with at least this many neighbours
+                               // have a hash index (if set)
+  std::vector<Detail::FlatIndexSet<IndexT>>
+      neighbour_hash_index{}; // Hash index of the neighbours of each agent
+
+  /*
+  Adds an edge to the row of agent_idx. It is appended, or, in sorted
+  adjacency mode, inserted after the neighbours with an index up to its own.
+  Gives the position of the new edge
+  */
+  size_t insert_neighbour(size_t agent_idx, size_t neighbour, WeightT w) {
+    auto &neighbours = neighbour_list[agent_idx];
+    auto &weights = weight_list[agent_idx];
+    size_t position = neighbours.size();
+    neighbours.push_back(neighbour);
+    weights.push_back(w);
+    if (sorted_neighbours) {
+      position = std::upper_bound(neighbours.begin(), neighbours.end() - 1,
+                                  neighbours.back()) -
+                 neighbours.begin();
+      std::rotate(neighbours.begin() + position, neighbours.end() - 1,
+                  neighbours.end());
+      std::rotate(weights.begin() + position, weights.end() - 1,
+                  weights.end());
+    }
+
+    if (hash_index_min_degree.has_value()) {
+      auto &hash_index = neighbour_hash_index[agent_idx];
+      if (!hash_index.empty()) {
+        hash_index.insert(neighbour);
+      } else {
+        rebuild_hash_index(agent_idx);
+      }
+    }
+    return position;
+  }
+
+  /*
+  Restores the order and the hash index of the row of agent_idx after it was
+  changed in place
+  */
+  void row_changed(size_t agent_idx) {
+    if (sorted_neighbours) {
+      std::vector<std::pair<IndexT, WeightT>> scratch{};
+      Detail::sort_row(neighbour_list[agent_idx], weight_list[agent_idx],
+                       scratch);
+    }
+    rebuild_hash_index(agent_idx);
+  }
+
+  /*
+  Restores the order and the hash index of every row after the rows were
+  replaced, on n_threads threads
+  */
+  void rows_changed(std::optional<size_t> n_threads = std::nullopt) {
+    if (sorted_neighbours) {
+      sort_adjacency(neighbour_list, weight_list, n_threads);
+    }
+    if (hash_index_min_degree.has_value()) {
+      neighbour_hash_index.resize(n_agents());
+      parallel_for(0, n_agents(), resolve_n_threads(n_threads),
+                   [&](size_t i_agent) { rebuild_hash_index(i_agent); });
+    }
+  }
+
+  // Hashes the neighbours of agent_idx if it has at least the minimum degree
+  void rebuild_hash_index(size_t agent_idx) {
+    if (!hash_index_min_degree.has_value()) {
+      return;
+    }
+    auto &hash_index = neighbour_hash_index[agent_idx];
+    if (neighbour_list[agent_idx].size() < hash_index_min_degree.value()) {
+      hash_index.clear();
+    } else {
+      hash_index.assign(neighbour_list[agent_idx]);
+    }
+  }
+
+  /*
+  Updates what a derived class stores besides the rows, after the weight
+  operations changed the weights in place (and removed edges, if
+  edges_removed is set). Restores the hash index if edges were removed
+  */
+  virtual void weights_changed(bool edges_removed,
+                               std::optional<size_t> n_threads) {
+    if (edges_removed) {
+      rows_changed(n_threads);
+    }
+  }
 
 public:
   NetworkBase() = default;
 
   NetworkBase(size_t n_agents)
       : neighbour_list(
-            std::vector<std::vector<size_t>>(n_agents, std::vector<size_t>{})),
+            std::vector<std::vector<IndexT>>(n_agents, std::vector<IndexT>{})),
         weight_list(std::vector<std::vector<WeightT>>(n_agents,
                                                       std::vector<WeightT>{})) {
   }
 
-  NetworkBase(std::vector<std::vector<size_t>> &&neighbour_list,
+  NetworkBase(std::vector<std::vector<IndexT>> &&neighbour_list,
               std::vector<std::vector<WeightT>> &&weight_list)
-      : neighbour_list(neighbour_list), weight_list(weight_list) {}
+      : neighbour_list(std::move(neighbour_list)),
+        weight_list(std::move(weight_list)) {}
 
   virtual ~NetworkBase() = default;
 
@@ -69,26 +172,45 @@ public:
 
   /*
   Sorts the neighbours by index and removes doubly counted edges by summing the
-  weights
+  weights. The agents are processed on n_threads threads (one per core if not
+  set)
+  */
+  virtual void
+  remove_double_counting(std::optional<size_t> n_threads = std::nullopt) = 0;
+
+  /*
+  Gives the strongly connected components in the graph, in one flat buffer.
+  This is the form to use on large networks: it needs no allocation per
+  component
+  If n_threads is set, the multi-threaded ParallelConnectivityAlgo is used with
+  that many threads (0 means one per core); it gives the same components, but
+  ordered by their smallest index
   */
-  virtual void remove_double_counting() = 0;
+  [[nodiscard]] ComponentList<IndexT> strongly_connected_component_list(
+      std::optional<size_t> n_threads = std::nullopt) const {
+    if (n_threads.has_value()) {
+      return std::move(ParallelConnectivityAlgo(*this, n_threads).scc_list);
+    }
+    // Run Tarjan's algorithm for strongly connected components directly on
+    // the neighbour list (or adjacency list), without copying it
+    return std::move(TarjanConnectivityAlgo(*this).scc_list);
+  }
 
   /*
-  Gives the strongly connected components in the graph
+  Gives the strongly connected components in the graph, as a vector of
+  vectors. The flat buffer is released while the components are copied out of
+  it, so the two forms are not both held in full
   @TODO: implement as visitor on the graph?
   */
-  [[nodiscard]] std::vector<std::vector<size_t>>
-  strongly_connected_components() const {
-    // Now that we have the neighbour list (or adjacency list)
-    // Run Tarjan's algorithm for strongly connected components
-    auto tarjan_scc = TarjanConnectivityAlgo(neighbour_list);
-    return tarjan_scc.scc_list;
+  [[nodiscard]] std::vector<std::vector<IndexT>> strongly_connected_components(
+      std::optional<size_t> n_threads = std::nullopt) const {
+    return strongly_connected_component_list(n_threads).to_nested();
   }
 
   /*
   Gives a view into the neighbour indices connected to agent_idx
   */
-  [[nodiscard]] std::span<const size_t>
+  [[nodiscard]] std::span<const IndexT>
   get_neighbours(std::size_t agent_idx) const {
     return std::span(neighbour_list[agent_idx].data(),
                      neighbour_list[agent_idx].size());
@@ -113,27 +235,169 @@ public:
   }
 
   /*
-  Checks if a connection exists between two agents i_idx and j_idx
+  Switches the sorted adjacency mode on or off. In this mode the neighbours of
+  every agent are kept sorted by index: switching it on sorts every row (on
+  n_threads threads), and edges added later are inserted at their sorted
+  position instead of being appended. Looking up a neighbour then uses a
+  binary search instead of a linear scan. Note that the position of the
+  existing edges of an agent changes when an edge is inserted before them.
   */
-  bool connection_exists(size_t i_idx, size_t j_idx) const {
-    auto i_neighbours = get_neighbours(i_idx);
-    if (std::find(i_neighbours.begin(), i_neighbours.end(), j_idx) ==
-        std::end(i_neighbours)) {
-      return false;
+  virtual void
+  set_sorted_adjacency(bool sorted,
+                       std::optional<size_t> n_threads = std::nullopt) {
+    sorted_neighbours = sorted;
+    rows_changed(n_threads);
+  }
+
+  [[nodiscard]] bool has_sorted_adjacency() const { return sorted_neighbours; }
+
+  /*
+  Builds a hash index of the neighbours of every agent with at least
+  min_degree neighbours (on n_threads threads), which answers
+  connection_exists in O(1) for these agents. The index is kept up to date as
+  edges are added. nullopt removes the index
+  */
+  void set_hash_index(std::optional<size_t> min_degree,
+                      std::optional<size_t> n_threads = std::nullopt) {
+    hash_index_min_degree = min_degree;
+    neighbour_hash_index.clear();
+    if (min_degree.has_value()) {
+      rows_changed(n_threads);
+    }
+  }
+
+  /*
+  Gives the position of j_idx among the neighbours of i_idx (the first one, if
+  there are several edges), or nullopt if it is not a neighbour
+  */
+  [[nodiscard]] std::optional<size_t> find_neighbour(size_t i_idx,
+                                                     size_t j_idx) const {
+    const auto i_neighbours = get_neighbours(i_idx);
+    if (hash_index_min_degree.has_value() &&
+        !neighbour_hash_index[i_idx].empty() &&
+        !neighbour_hash_index[i_idx].contains(j_idx)) {
+      return std::nullopt;
+    }
+
+    size_t position = 0;
+    if (sorted_neighbours) {
+      position = Detail::branchless_lower_bound(i_neighbours, j_idx);
     } else {
-      return true;
+      position = std::find(i_neighbours.begin(), i_neighbours.end(), j_idx) -
+                 i_neighbours.begin();
+    }
+    if (position == i_neighbours.size() || i_neighbours[position] != j_idx) {
+      return std::nullopt;
+    }
+    return position;
+  }
+
+  /*
+  Checks if a connection exists between two agents i_idx and j_idx. This is a
+  linear scan over the neighbours of i_idx, a binary search in sorted adjacency
+  mode, or a hash lookup if i_idx has a hash index (see set_hash_index)
+  */
+  bool connection_exists(size_t i_idx, size_t j_idx) const {
+    if (hash_index_min_degree.has_value() &&
+        !neighbour_hash_index[i_idx].empty()) {
+      return neighbour_hash_index[i_idx].contains(j_idx);
     }
+    return find_neighbour(i_idx, j_idx).has_value();
+  }
+
+  /*
+  Scales the weights of every agent so that they sum to 1 (agents whose
+  weights sum to 0 are left as they are), on n_threads threads (one per core
+  if not set). In an UndirectedNetwork, the two halves of an edge generally
+  get different weights
+  */
+  void normalize_rows(std::optional<size_t> n_threads = std::nullopt) {
+    normalize_weight_rows(weight_list, n_threads);
+    weights_changed(false, n_threads);
+  }
+
+  /*
+  Scales the weights so that, for every agent j, the weights of the edges
+  stored with neighbour j sum to 1 (e.g. the outgoing weights of j, if
+  incoming edges are stored), without transposing the network. Runs on
+  n_threads threads (one per core if not set)
+  */
+  void normalize_columns(std::optional<size_t> n_threads = std::nullopt) {
+    normalize_weight_columns(neighbour_list, weight_list, n_threads);
+    weights_changed(false, n_threads);
+  }
+
+  /*
+  Multiplies every weight by factor, on n_threads threads (one per core if not
+  set)
+  */
+  void scale_weights(WeightT factor,
+                     std::optional<size_t> n_threads = std::nullopt) {
+    transform_weight_list(
+        neighbour_list, weight_list, [factor](WeightT w) { return w * factor; },
+        n_threads);
+    weights_changed(false, n_threads);
+  }
+
+  /*
+  Removes every edge with a weight below threshold, keeping the order of the
+  other edges, on n_threads threads (one per core if not set). Gives the
+  number of removed entries (both halves of an edge count for an
+  UndirectedNetwork)
+  */
+  size_t threshold_weights(WeightT threshold,
+                           std::optional<size_t> n_threads = std::nullopt) {
+    const size_t n_removed = remove_edges_if(
+        neighbour_list, weight_list,
+        [threshold](size_t, size_t, WeightT w) { return w < threshold; },
+        n_threads);
+    weights_changed(n_removed > 0, n_threads);
+    return n_removed;
+  }
+
+  /*
+  Replaces every weight w by func(w), or, if func takes three arguments, by
+  func(i_agent, j_agent, w) for the edge to j_agent in the row of i_agent.
+  Runs on n_threads threads (one per core if not set), so func is called from
+  several threads at once. In an UndirectedNetwork, both halves of an edge are
+  transformed, and they only keep the same weight if func treats them the same
+  */
+  template <typename Func>
+  void transform_weights(Func &&func,
+                         std::optional<size_t> n_threads = std::nullopt) {
+    transform_weight_list(neighbour_list, weight_list, func, n_threads);
+    weights_changed(false, n_threads);
+  }
+
+  /*
+  Renumbers the agents: agent i becomes agent permutation.forward[i], and the
+  neighbour indices are renamed accordingly (see permute_adjacency). The rows
+  are permuted on n_threads threads (one per core if not set). Per-agent state
+  kept outside the network follows with permute_values
+  */
+  virtual void
+  permute_agents(const Permutation &permutation,
+                 std::optional<size_t> n_threads = std::nullopt) {
+    if (permutation.size() != n_agents()) {
+      throw std::runtime_error("NetworkBase::permute_agents: the permutation "
+                               "needs one entry per agent!");
+    }
+    permute_adjacency(neighbour_list, weight_list, permutation, n_threads);
+    rows_changed(n_threads);
   }
 
   /*
   Clears the network
   */
-  void clear() {
+  virtual void clear() {
     for (auto &w : weight_list)
       w.clear();
 
     for (auto &n : neighbour_list)
       n.clear();
+
+    for (auto &hash_index : neighbour_hash_index)
+      hash_index.clear();
   }
 };
 
@@ -1,30 +1,43 @@
+#pragma once
 #include "fmt/core.h"
 #include "fmt/ranges.h"
 #include "network_base.hpp"
-#include <climits>
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <bit>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 #include <optional>
 #include <queue>
+#include <random>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace Graph {
 
 // Breadth-first search from a source node, up to an optional user-defined
 // max_depth. Requires a vector for the depth level or distance from
-// the source (initialized to MAX_INT at first), and also a vector of vectors
-// for the parent nodes of each node.
-template <typename WeightType = double>
-void bfs(const NetworkBase<WeightType> &network,
-         std::vector<std::vector<int>> &parent, std::vector<int> &depth_level,
-         size_t source, std::optional<int> max_depth) {
+// the source (initialized to invalid_index<IndexT> at first), and also a
+// vector of vectors for the parent nodes of each node. IndexT is any unsigned
+// type, e.g. the index type of the network (size_t or uint32_t). Works on any
+// NetworkView, e.g. a NetworkBase or a CompressedNetwork.
+template <NetworkView NetworkT, std::unsigned_integral IndexT>
+void bfs(const NetworkT &network, std::vector<std::vector<IndexT>> &parent,
+         std::vector<IndexT> &depth_level, size_t source,
+         std::optional<size_t> max_depth) {
   std::queue<size_t> q; // To keep track of nodes to visit
   // Insert the source node in the queue
   q.push(source);
-  // Update its parent to be -1 (characteristic of the source) and its
-  // depth_level
-  parent[source] = {-1};
+  // Update its parent to be invalid_index (characteristic of the source) and
+  // its depth_level
+  parent[source] = {invalid_index<IndexT>};
   depth_level[source] = 0;
 
   // Keep traversing until the queue is empty
@@ -35,7 +48,7 @@ void bfs(const NetworkBase<WeightType> &network,
     // Check to see if the maximum depth has been reached, break if it has
     // been reached
     if (max_depth.has_value()) {
-      if (depth_level[v] > max_depth.value() - 1) {
+      if (depth_level[v] >= max_depth.value()) {
         break; // Stop BFS if the maximum search depth has been reached
       }
     }
@@ -47,25 +60,422 @@ void bfs(const NetworkBase<WeightType> &network,
       if (depth_level[w] > depth_level[v] + 1) {
         depth_level[w] = depth_level[v] + 1;
         parent[w].clear();
-        parent[w].push_back(v);
+        parent[w].push_back(static_cast<IndexT>(v));
         q.push(w); // Add the current node w to the queue
       }
       // Otherwise, another candidate parent (i.e. node v) has been found for
       // the shortest path
       else if (depth_level[w] == depth_level[v] + 1) {
-        parent[w].push_back(v);
+        parent[w].push_back(static_cast<IndexT>(v));
       }
     }
   }
 }
 
+namespace Detail {
+
+// Level-synchronous BFS which switches between top-down steps (looping over
+// the frontier) and bottom-up steps (looping over the unvisited nodes and
+// looking for a parent in the frontier). Parents are only collected if parent
+// is not nullptr
+template <NetworkView ForwardNetworkT, NetworkView BackwardNetworkT,
+          std::unsigned_integral IndexT>
+void bfs_direction_optimizing(const ForwardNetworkT &forward_network,
+                              const BackwardNetworkT &backward_network,
+                              std::vector<std::vector<IndexT>> *parent,
+                              std::vector<IndexT> &depth_level, size_t source,
+                              std::optional<size_t> max_depth) {
+  // Switch to bottom-up once the frontier has more than 1/alpha of the edges
+  // still to be explored, and back to top-down once it has less than 1/beta
+  // of the nodes
+  const size_t alpha = 14;
+  const size_t beta = 24;
+  const size_t n_agents = forward_network.n_agents();
+
+  std::vector<size_t> frontier{source}; // Nodes at the current depth
+  std::vector<size_t> next_frontier{};  // Nodes at the next depth
+  std::vector<uint64_t> frontier_bitmap((n_agents + 63) / 64, 0);
+  auto in_frontier = [&](size_t v) {
+    return (frontier_bitmap[v / 64] >> (v % 64)) & 1;
+  };
+
+  // Edges going out of nodes that have not been visited yet
+  size_t n_edges_unexplored = 0;
+  for (size_t v = 0; v < n_agents; v++) {
+    n_edges_unexplored += forward_network.get_neighbours(v).size();
+  }
+
+  if (parent != nullptr) {
+    (*parent)[source] = {invalid_index<IndexT>};
+  }
+  depth_level[source] = 0;
+  n_edges_unexplored -= forward_network.get_neighbours(source).size();
+  bool bottom_up = false;
+
+  for (size_t depth = 0; !frontier.empty(); depth++) {
+    // Nodes at max_depth are found, but not expanded
+    if (max_depth.has_value() && depth >= max_depth.value()) {
+      break;
+    }
+
+    size_t n_edges_frontier = 0;
+    for (size_t v : frontier) {
+      n_edges_frontier += forward_network.get_neighbours(v).size();
+    }
+    if (!bottom_up && n_edges_frontier > n_edges_unexplored / alpha) {
+      bottom_up = true;
+    } else if (bottom_up && frontier.size() < n_agents / beta) {
+      bottom_up = false;
+    }
+
+    next_frontier.clear();
+    if (!bottom_up) {
+      // Top-down: go through the neighbours of the frontier, as in bfs
+      for (size_t v : frontier) {
+        for (size_t w : forward_network.get_neighbours(v)) {
+          if (depth_level[w] == invalid_index<IndexT>) {
+            depth_level[w] = static_cast<IndexT>(depth + 1);
+            if (parent != nullptr) {
+              (*parent)[w].clear();
+              (*parent)[w].push_back(static_cast<IndexT>(v));
+            }
+            next_frontier.push_back(w);
+          } else if (parent != nullptr && depth_level[w] == depth + 1) {
+            (*parent)[w].push_back(static_cast<IndexT>(v));
+          }
+        }
+      }
+    } else {
+      // Bottom-up: every unvisited node looks for parents in the frontier
+      for (size_t v : frontier) {
+        frontier_bitmap[v / 64] |= uint64_t(1) << (v % 64);
+      }
+      for (size_t w = 0; w < n_agents; w++) {
+        if (depth_level[w] != invalid_index<IndexT>) {
+          continue;
+        }
+        for (size_t v : backward_network.get_neighbours(w)) {
+          if (!in_frontier(v)) {
+            continue;
+          }
+          if (depth_level[w] == invalid_index<IndexT>) {
+            depth_level[w] = static_cast<IndexT>(depth + 1);
+            next_frontier.push_back(w);
+            if (parent == nullptr) {
+              break; // One parent is enough
+            }
+            (*parent)[w].clear();
+          }
+          (*parent)[w].push_back(static_cast<IndexT>(v));
+        }
+      }
+      for (size_t v : frontier) {
+        frontier_bitmap[v / 64] = 0;
+      }
+    }
+
+    for (size_t w : next_frontier) {
+      n_edges_unexplored -= forward_network.get_neighbours(w).size();
+    }
+    std::swap(frontier, next_frontier);
+  }
+}
+
+// Level-synchronous BFS on n_threads threads. Parents are only collected if
+// parent is not nullptr
+template <NetworkView NetworkT, std::unsigned_integral IndexT>
+void bfs_parallel(const NetworkT &network,
+                  std::vector<std::vector<IndexT>> *parent,
+                  std::vector<IndexT> &depth_level, size_t source,
+                  std::optional<size_t> max_depth, size_t n_threads) {
+  const size_t chunk_size = 64; // Frontier nodes handed out at once
+
+  std::vector<size_t> frontier{source};
+  // Nodes found by each thread for the next frontier
+  std::vector<std::vector<size_t>> next_buffers(n_threads);
+  // (node, parent) pairs found by each thread, bucketed by the thread that
+  // owns the node: parent[w] is only ever written by thread w % n_threads
+  std::vector<std::vector<std::vector<std::pair<size_t, size_t>>>>
+      parent_buffers(n_threads,
+                     std::vector<std::vector<std::pair<size_t, size_t>>>(
+                         n_threads));
+  std::atomic<size_t> next_chunk = 0;
+  IndexT depth = 0;
+
+  if (parent != nullptr) {
+    (*parent)[source] = {invalid_index<IndexT>};
+  }
+  depth_level[source] = 0;
+
+  auto finished = [&]() {
+    return frontier.empty() ||
+           (max_depth.has_value() && depth >= max_depth.value());
+  };
+  bool done = finished();
+
+  // Runs on a single thread once all threads have finished a level
+  auto next_level = [&]() noexcept {
+    frontier.clear();
+    merge_thread_buffers(next_buffers, frontier);
+    next_chunk.store(0);
+    depth += 1;
+    done = finished();
+  };
+  std::barrier level_barrier(static_cast<std::ptrdiff_t>(n_threads),
+                             next_level);
+  std::barrier parent_barrier(static_cast<std::ptrdiff_t>(n_threads));
+
+  parallel_run(n_threads, [&](size_t i_thread) {
+    auto &next_buffer = next_buffers[i_thread];
+    auto &parent_buffer = parent_buffers[i_thread];
+
+    while (!done) {
+      // Claim the unvisited neighbours of the frontier
+      for (size_t i_chunk = next_chunk.fetch_add(1);
+           i_chunk * chunk_size < frontier.size();
+           i_chunk = next_chunk.fetch_add(1)) {
+        const size_t chunk_end =
+            std::min((i_chunk + 1) * chunk_size, frontier.size());
+        for (size_t i = i_chunk * chunk_size; i < chunk_end; i++) {
+          const size_t v = frontier[i];
+          for (size_t w : network.get_neighbours(v)) {
+            const IndexT depth_next = depth + 1;
+            std::atomic_ref<IndexT> depth_w(depth_level[w]);
+            IndexT depth_w_old = depth_w.load(std::memory_order_relaxed);
+            if (depth_w_old == invalid_index<IndexT> &&
+                depth_w.compare_exchange_strong(depth_w_old, depth_next)) {
+              next_buffer.push_back(w);
+              depth_w_old = depth_next;
+              if (parent != nullptr) {
+                (*parent)[w].clear();
+              }
+            }
+            // Every node of the frontier with an edge to w is a parent
+            if (parent != nullptr && depth_w_old == depth_next) {
+              parent_buffer[w % n_threads].push_back({w, v});
+            }
+          }
+        }
+      }
+
+      if (parent != nullptr) {
+        parent_barrier.arrive_and_wait();
+        // Append the parents of the nodes owned by this thread
+        for (auto &buffers : parent_buffers) {
+          for (auto [w, v] : buffers[i_thread]) {
+            (*parent)[w].push_back(static_cast<IndexT>(v));
+          }
+        }
+      }
+
+      level_barrier.arrive_and_wait();
+      for (auto &buffer : parent_buffer) {
+        buffer.clear();
+      }
+    }
+  });
+}
+
+// Breadth-first searches from all the sources at once, in batches of
+// 64 * NWords sources. Every node has a bitset with one bit per source of the
+// batch for the sources that have reached it (seen), and one for the sources
+// whose frontier it is in (visit). An edge is then traversed once per level
+// for the whole batch, and the bitsets of its ends are combined word by word.
+// Calls visit_func(i_source, v, depth) once for every node v reached from
+// sources[i_source]
+template <size_t NWords, NetworkView NetworkT, typename VisitFunc>
+void bfs_multi_source(const NetworkT &network,
+                      const std::vector<size_t> &sources,
+                      std::optional<size_t> max_depth, VisitFunc &visit_func) {
+  using Bitset = std::array<uint64_t, NWords>;
+  const size_t batch_size = 64 * NWords;
+  const size_t n_agents = network.n_agents();
+
+  std::vector<Bitset> seen(n_agents);
+  std::vector<Bitset> visit(n_agents);
+  std::vector<Bitset> visit_next(n_agents);
+  std::vector<size_t> frontier{}; // Nodes with a non-empty visit bitset
+  std::vector<size_t> next_frontier{};
+
+  // Calls visit_func for every source with a bit set in bits
+  auto visit_sources = [&](const Bitset &bits, size_t batch_begin, size_t v,
+                           size_t depth) {
+    for (size_t i_word = 0; i_word < NWords; i_word++) {
+      for (uint64_t word = bits[i_word]; word != 0; word &= word - 1) {
+        const size_t i_bit = std::countr_zero(word);
+        visit_func(batch_begin + 64 * i_word + i_bit, v, depth);
+      }
+    }
+  };
+
+  for (size_t batch_begin = 0; batch_begin < sources.size();
+       batch_begin += batch_size) {
+    const size_t batch_end = std::min(batch_begin + batch_size, sources.size());
+    std::fill(seen.begin(), seen.end(), Bitset{});
+
+    for (size_t i_source = batch_begin; i_source < batch_end; i_source++) {
+      const size_t source = sources[i_source];
+      const size_t i_bit = i_source - batch_begin;
+      if (visit[source] == Bitset{}) {
+        frontier.push_back(source);
+      }
+      seen[source][i_bit / 64] |= uint64_t(1) << (i_bit % 64);
+      visit[source][i_bit / 64] |= uint64_t(1) << (i_bit % 64);
+      visit_func(i_source, source, 0);
+    }
+
+    for (size_t depth = 0; !frontier.empty(); depth++) {
+      // Nodes at max_depth are found, but not expanded
+      if (max_depth.has_value() && depth >= max_depth.value()) {
+        break;
+      }
+
+      // Pass the sources in the frontier on to the neighbours that they have
+      // not reached yet
+      for (size_t v : frontier) {
+        const Bitset &visit_v = visit[v];
+        for (size_t w : network.get_neighbours(v)) {
+          Bitset &visit_next_w = visit_next[w];
+          const Bitset &seen_w = seen[w];
+          uint64_t before = 0;
+          uint64_t added = 0;
+          for (size_t i_word = 0; i_word < NWords; i_word++) {
+            const uint64_t bits = visit_v[i_word] & ~seen_w[i_word];
+            before |= visit_next_w[i_word];
+            added |= bits;
+            visit_next_w[i_word] |= bits;
+          }
+          if (before == 0 && added != 0) {
+            next_frontier.push_back(w);
+          }
+        }
+      }
+
+      for (size_t w : next_frontier) {
+        for (size_t i_word = 0; i_word < NWords; i_word++) {
+          seen[w][i_word] |= visit_next[w][i_word];
+        }
+        visit_sources(visit_next[w], batch_begin, w, depth + 1);
+      }
+      for (size_t v : frontier) {
+        visit[v] = Bitset{};
+      }
+      std::swap(visit, visit_next);
+      std::swap(frontier, next_frontier);
+      next_frontier.clear();
+    }
+
+    // Leftovers of a search stopped at max_depth
+    for (size_t v : frontier) {
+      visit[v] = Bitset{};
+    }
+    frontier.clear();
+  }
+}
+
+} // namespace Detail
+
+// Parallel level-synchronous breadth-first search from a source node, up to an
+// optional user-defined max_depth. Gives the same depth_level and the same
+// parent sets as bfs (the order of the parents of a node may differ). Each
+// level is split among n_threads threads (one per core if not set); nodes are
+// claimed by an atomic update of their depth level, and the next frontier and
+// the parents are collected per thread and merged after each level.
+template <NetworkView NetworkT, std::unsigned_integral IndexT>
+void bfs_parallel(const NetworkT &network,
+                  std::vector<std::vector<IndexT>> &parent,
+                  std::vector<IndexT> &depth_level, size_t source,
+                  std::optional<size_t> max_depth,
+                  std::optional<size_t> n_threads = std::nullopt) {
+  Detail::bfs_parallel(network, &parent, depth_level, source, max_depth,
+                       resolve_n_threads(n_threads));
+}
+
+// Same as above, but only computes the depth levels
+template <NetworkView NetworkT, std::unsigned_integral IndexT>
+void bfs_parallel(const NetworkT &network, std::vector<IndexT> &depth_level,
+                  size_t source, std::optional<size_t> max_depth,
+                  std::optional<size_t> n_threads = std::nullopt) {
+  Detail::bfs_parallel<NetworkT, IndexT>(network, nullptr, depth_level, source,
+                                         max_depth,
+                                         resolve_n_threads(n_threads));
+}
+
+// Direction-optimizing breadth-first search from a source node, up to an
+// optional user-defined max_depth. Gives the same depth_level and the same
+// parent sets as bfs (the order of the parents of a node may differ). For the
+// levels where the frontier covers a large part of the network, the
+// unvisited nodes look for a parent in the frontier instead (bottom-up), which
+// needs the edges in the opposite direction: backward_network must give, for
+// each node, the nodes from which it is reached in forward_network. For an
+// UndirectedNetwork, pass the same network twice; for a BidirectionalNetwork,
+// pass out_view() and in_view().
+template <NetworkView ForwardNetworkT, NetworkView BackwardNetworkT,
+          std::unsigned_integral IndexT>
+void bfs_direction_optimizing(const ForwardNetworkT &forward_network,
+                              const BackwardNetworkT &backward_network,
+                              std::vector<std::vector<IndexT>> &parent,
+                              std::vector<IndexT> &depth_level, size_t source,
+                              std::optional<size_t> max_depth) {
+  Detail::bfs_direction_optimizing(forward_network, backward_network, &parent,
+                                   depth_level, source, max_depth);
+}
+
+// Same as above, but only computes the depth levels, so that the bottom-up
+// steps can stop at the first parent found
+template <NetworkView ForwardNetworkT, NetworkView BackwardNetworkT,
+          std::unsigned_integral IndexT>
+void bfs_direction_optimizing(const ForwardNetworkT &forward_network,
+                              const BackwardNetworkT &backward_network,
+                              std::vector<IndexT> &depth_level, size_t source,
+                              std::optional<size_t> max_depth) {
+  Detail::bfs_direction_optimizing<ForwardNetworkT, BackwardNetworkT, IndexT>(
+      forward_network, backward_network, nullptr, depth_level, source,
+      max_depth);
+}
+
+// Breadth-first search from several sources at once, up to an optional
+// user-defined max_depth. Calls visit_func(i_source, v, depth) once for every
+// node v that is reached from sources[i_source], with its depth level (the
+// same as bfs gives). The sources are searched together in batches of
+// 64 * NWords, so that every edge is traversed once per level for the whole
+// batch instead of once per source.
+template <size_t NWords = 1, NetworkView NetworkT, typename VisitFunc>
+  requires std::invocable<VisitFunc &, size_t, size_t, size_t>
+void bfs_multi_source(const NetworkT &network,
+                      const std::vector<size_t> &sources,
+                      std::optional<size_t> max_depth,
+                      VisitFunc &&visit_func) {
+  Detail::bfs_multi_source<NWords>(network, sources, max_depth, visit_func);
+}
+
+// Same as above, but gives the depth levels as a matrix: the distance of node
+// v from sources[i_source] is in [i_source][v] (invalid_index<IndexT> if v is
+// not reached)
+template <size_t NWords = 1, std::unsigned_integral IndexT = size_t,
+          NetworkView NetworkT>
+std::vector<std::vector<IndexT>>
+bfs_multi_source(const NetworkT &network, const std::vector<size_t> &sources,
+                 std::optional<size_t> max_depth) {
+  auto depth_level = std::vector<std::vector<IndexT>>(
+      sources.size(),
+      std::vector<IndexT>(network.n_agents(), invalid_index<IndexT>));
+  auto set_depth = [&](size_t i_source, size_t v, size_t depth) {
+    depth_level[i_source][v] = static_cast<IndexT>(depth);
+  };
+  Detail::bfs_multi_source<NWords>(network, sources, max_depth, set_depth);
+  return depth_level;
+}
+
 // Given all the parents for each node, *all* paths are reconstructed by
 // iterating up the parents recursively
-inline void reconstruct_paths(const std::vector<std::vector<int>> &parent,
-                              std::vector<std::vector<int>> &result_paths,
-                              std::vector<int> &path, const int v) {
+template <std::unsigned_integral IndexT>
+void reconstruct_paths(const std::vector<std::vector<IndexT>> &parent,
+                       std::vector<std::vector<IndexT>> &result_paths,
+                       std::vector<IndexT> &path,
+                       const std::type_identity_t<IndexT> v) {
   // When you have reached the source parent, add the path and return
-  if (v == -1) {
+  if (v == invalid_index<IndexT>) {
     result_paths.push_back(path);
     return;
   }
@@ -84,14 +494,177 @@ inline void reconstruct_paths(const std::vector<std::vector<int>> &parent,
   }
 }
 
+// Counts the shortest paths from the source to every node, given the parents
+// and depth levels from bfs (paths through repeated edges count separately, as
+// in reconstruct_paths). The nodes are visited once, ordered by their depth
+// level, and the count of a node is the sum of the counts of its parents.
+// Unreached nodes have no paths. The number of paths can grow exponentially
+// with the depth (e.g. on lattices); use a floating-point CountT for an
+// approximate count if it could overflow
+template <typename CountT = uint64_t, std::unsigned_integral IndexT>
+std::vector<CountT>
+count_shortest_paths(const std::vector<std::vector<IndexT>> &parent,
+                     const std::vector<IndexT> &depth_level) {
+  // Order the reached nodes by depth with a counting sort
+  std::vector<size_t> n_at_depth{};
+  for (IndexT depth : depth_level) {
+    if (depth != invalid_index<IndexT>) {
+      if (size_t(depth) + 1 >= n_at_depth.size()) {
+        n_at_depth.resize(size_t(depth) + 2, 0);
+      }
+      n_at_depth[depth + 1] += 1;
+    }
+  }
+  for (size_t depth = 1; depth < n_at_depth.size(); depth++) {
+    n_at_depth[depth] += n_at_depth[depth - 1];
+  }
+  std::vector<size_t> by_depth(n_at_depth.empty() ? 0 : n_at_depth.back());
+  for (size_t v = 0; v < depth_level.size(); v++) {
+    if (depth_level[v] != invalid_index<IndexT>) {
+      by_depth[n_at_depth[depth_level[v]]++] = v;
+    }
+  }
+
+  std::vector<CountT> n_paths(depth_level.size(), CountT(0));
+  for (size_t v : by_depth) {
+    for (IndexT par : parent[v]) {
+      n_paths[v] += par == invalid_index<IndexT> ? CountT(1) : n_paths[par];
+    }
+  }
+  return n_paths;
+}
+
+// Goes through the shortest paths to a node one at a time, without storing
+// them all, given the parents from bfs. The paths come in the same order and
+// format as from reconstruct_paths (from the node back to the source), so
+// that the enumeration can be stopped after any number of paths
+template <std::unsigned_integral IndexType> class ShortestPathEnumerator {
+public:
+  using IndexT = IndexType;
+
+private:
+  const std::vector<std::vector<IndexT>> *parent;
+  std::vector<IndexT> path{};   // Nodes of the current path
+  std::vector<size_t> choice{}; // Index of the parent chosen for each node
+  bool started = false;
+
+  // Extends the path from its last node by always choosing the first parent,
+  // until the source is reached. Gives false at a node without parents
+  bool descend() {
+    while (true) {
+      const auto &parents = (*parent)[path.back()];
+      if (parents.empty()) {
+        return false;
+      }
+      choice.push_back(0);
+      if (parents.front() == invalid_index<IndexT>) {
+        return true;
+      }
+      path.push_back(parents.front());
+    }
+  }
+
+public:
+  ShortestPathEnumerator(const std::vector<std::vector<IndexT>> &parent,
+                         size_t destination)
+      : parent(&parent), path({static_cast<IndexT>(destination)}) {}
+
+  // Writes the next path into result. Gives false if there are no more paths
+  bool next(std::vector<IndexT> &result) {
+    if (!started) {
+      started = true;
+      if (!descend()) {
+        path.clear();
+        return false;
+      }
+      result = path;
+      return true;
+    }
+    // Move on to the next parent at the deepest node that has one left, and
+    // take the first parents from there on
+    while (!path.empty()) {
+      const auto &parents = (*parent)[path.back()];
+      if (choice.size() == path.size()) {
+        choice.back() += 1;
+        if (choice.back() < parents.size()) {
+          path.push_back(parents[choice.back()]);
+          if (descend()) {
+            result = path;
+            return true;
+          }
+          continue;
+        }
+        choice.pop_back();
+      }
+      path.pop_back();
+    }
+    return false;
+  }
+};
+
+// Gives at most max_paths of the shortest paths to destination, in the order
+// and format of reconstruct_paths
+template <std::unsigned_integral IndexT>
+std::vector<std::vector<IndexT>>
+enumerate_shortest_paths(const std::vector<std::vector<IndexT>> &parent,
+                         size_t destination, size_t max_paths) {
+  std::vector<std::vector<IndexT>> result_paths{};
+  std::vector<IndexT> path{};
+  auto enumerator = ShortestPathEnumerator(parent, destination);
+  while (result_paths.size() < max_paths && enumerator.next(path)) {
+    result_paths.push_back(path);
+  }
+  return result_paths;
+}
+
+// Draws one of the shortest paths to destination uniformly at random, given
+// the parents from bfs and the path counts from count_shortest_paths. Going
+// back from destination, each parent is chosen with a probability
+// proportional to its number of paths. The path is in the format of
+// reconstruct_paths, and is empty if destination was not reached
+template <typename CountT, std::unsigned_integral IndexT, typename Generator>
+std::vector<IndexT>
+sample_shortest_path(const std::vector<std::vector<IndexT>> &parent,
+                     const std::vector<CountT> &n_paths, size_t destination,
+                     Generator &gen) {
+  std::vector<IndexT> path{};
+  if (n_paths[destination] == CountT(0)) {
+    return path;
+  }
+  IndexT v = static_cast<IndexT>(destination);
+  while (v != invalid_index<IndexT>) {
+    path.push_back(v);
+    // Pick a path through the parents, and find the parent it goes through
+    CountT pick{};
+    if constexpr (std::is_integral_v<CountT>) {
+      pick = std::uniform_int_distribution<CountT>(0, n_paths[v] - 1)(gen);
+    } else {
+      pick = std::uniform_real_distribution<CountT>(0, n_paths[v])(gen);
+    }
+    IndexT next_v = parent[v].back();
+    for (IndexT par : parent[v]) {
+      const CountT n_paths_par =
+          par == invalid_index<IndexT> ? CountT(1) : n_paths[par];
+      if (pick < n_paths_par) {
+        next_v = par;
+        break;
+      }
+      pick -= n_paths_par;
+    }
+    v = next_v;
+  }
+  return path;
+}
+
 // For this function to work, you must have already performed BFS using a source
 // node. This will create the depth_level vector containing the
 // distances/depth_level from the source This tells you whether a path from the
 // source to v exists or not
-bool inline path_exists_to_destination(const std::vector<int> &depth_level,
-                                       const int v) {
+template <std::unsigned_integral IndexT>
+bool path_exists_to_destination(const std::vector<IndexT> &depth_level,
+                                const size_t v) {
 
-  return !(depth_level[v] == INT_MAX);
+  return !(depth_level[v] == invalid_index<IndexT>);
 }
 
 } // namespace Graph
@@ -0,0 +1,55 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace Graph {
+
+/*
+    Anything that can be traversed like a network: it knows its number of nodes
+    and gives a view into the neighbour indices of each node. NetworkBase and
+    its derived classes satisfy this, as does the CompressedNetwork.
+*/
+template <typename NetworkT>
+concept NetworkView = requires(const NetworkT &network, std::size_t agent_idx) {
+  { network.n_agents() } -> std::convertible_to<std::size_t>;
+  network.get_neighbours(agent_idx).begin();
+  network.get_neighbours(agent_idx).end();
+  {
+    network.get_neighbours(agent_idx).size()
+  } -> std::convertible_to<std::size_t>;
+};
+
+/*
+    A NetworkView which also gives a view into the edge weights of each node,
+    in the same order as the neighbour indices
+*/
+template <typename NetworkT>
+concept WeightedNetworkView =
+    NetworkView<NetworkT> &&
+    requires(const NetworkT &network, std::size_t agent_idx) {
+      typename NetworkT::WeightT;
+      network.get_weights(agent_idx).begin();
+      {
+        network.get_weights(agent_idx).size()
+      } -> std::convertible_to<std::size_t>;
+    };
+
+/*
+    The type of the neighbour indices given by a NetworkView (e.g. size_t, or
+    uint32_t for a network with 32-bit indices)
+*/
+template <NetworkView NetworkT>
+using network_index_t = std::remove_cvref_t<
+    decltype(*std::declval<const NetworkT &>().get_neighbours(0).begin())>;
+
+/*
+    The largest value of an unsigned index type. Marks a node that was not
+    reached (as its depth level or distance) and the missing parent of a source
+*/
+template <std::unsigned_integral IndexT>
+inline constexpr IndexT invalid_index = std::numeric_limits<IndexT>::max();
+
+} // namespace Graph
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+Gives the number of threads to use: n_threads if it is set, otherwise one per
+hardware thread
+*/
+inline size_t resolve_n_threads(std::optional<size_t> n_threads) {
+  if (n_threads.has_value() && n_threads.value() > 0) {
+    return n_threads.value();
+  }
+  return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+/*
+Runs func(i_thread) on n_threads threads and waits for all of them to finish.
+The calling thread works as thread 0. The first exception thrown by any of the
+threads is rethrown.
+*/
+template <typename Func> void parallel_run(size_t n_threads, Func &&func) {
+  if (n_threads <= 1) {
+    func(size_t(0));
+    return;
+  }
+
+  std::exception_ptr exception = nullptr;
+  std::mutex exception_mutex;
+  auto guarded_func = [&](size_t i_thread) {
+    try {
+      func(i_thread);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(exception_mutex);
+      if (!exception) {
+        exception = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads{};
+  threads.reserve(n_threads - 1);
+  for (size_t i_thread = 1; i_thread < n_threads; i_thread++) {
+    threads.emplace_back(guarded_func, i_thread);
+  }
+  guarded_func(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+/*
+Gives the i_block-th of n_blocks contiguous blocks of (almost) equal size that
+[begin, end) is split into, as a pair {block_begin, block_end}
+*/
+inline std::pair<size_t, size_t> block_range(size_t begin, size_t end,
+                                             size_t n_blocks, size_t i_block) {
+  const size_t length = end - begin;
+  const size_t block_begin = begin + (length * i_block) / n_blocks;
+  const size_t block_end = begin + (length * (i_block + 1)) / n_blocks;
+  return {block_begin, block_end};
+}
+
+/*
+Splits [begin, end) into n_threads contiguous blocks, and calls
+func(block_begin, block_end, i_thread) for each block on its own thread
+*/
+template <typename Func>
+void parallel_for_blocks(size_t begin, size_t end, size_t n_threads,
+                         Func &&func) {
+  n_threads = std::max<size_t>(std::min(n_threads, end - begin), 1);
+  parallel_run(n_threads, [&](size_t i_thread) {
+    const auto [block_begin, block_end] =
+        block_range(begin, end, n_threads, i_thread);
+    func(block_begin, block_end, i_thread);
+  });
+}
+
+/*
+Calls func(i) (or func(i, i_thread)) for every i in [begin, end). The indices
+are handed out to the threads in chunks of chunk_size as the threads become
+free, so that unbalanced work (e.g. agents of very different degree) is spread
+evenly
+*/
+template <typename Func>
+void parallel_for(size_t begin, size_t end, size_t n_threads, Func &&func,
+                  size_t chunk_size = 256) {
+  if (begin >= end) {
+    return;
+  }
+  chunk_size = std::max<size_t>(chunk_size, 1);
+  const size_t n_chunks = (end - begin + chunk_size - 1) / chunk_size;
+  n_threads = std::max<size_t>(std::min(n_threads, n_chunks), 1);
+
+  std::atomic<size_t> next_chunk = 0;
+  parallel_run(n_threads, [&](size_t i_thread) {
+    for (size_t i_chunk = next_chunk.fetch_add(1); i_chunk < n_chunks;
+         i_chunk = next_chunk.fetch_add(1)) {
+      const size_t chunk_begin = begin + i_chunk * chunk_size;
+      const size_t chunk_end = std::min(chunk_begin + chunk_size, end);
+      for (size_t i = chunk_begin; i < chunk_end; i++) {
+        if constexpr (std::is_invocable_v<Func, size_t, size_t>) {
+          func(i, i_thread);
+        } else {
+          func(i);
+        }
+      }
+    }
+  });
+}
+
+/*
+Appends the per-thread buffers to result, in the order of the threads, and
+clears them
+*/
+template <typename T>
+void merge_thread_buffers(std::vector<std::vector<T>> &buffers,
+                          std::vector<T> &result) {
+  size_t total_size = result.size();
+  for (const auto &buffer : buffers) {
+    total_size += buffer.size();
+  }
+  result.reserve(total_size);
+  for (auto &buffer : buffers) {
+    result.insert(result.end(), buffer.begin(), buffer.end());
+    buffer.clear();
+  }
+}
+
+} // namespace Graph
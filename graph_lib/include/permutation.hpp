@@ -0,0 +1,140 @@
+#pragma once
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    A renumbering of the agents. forward[i] is the new index of the agent with
+    the old index i, and inverse[k] is the old index of the agent with the new
+    index k
+*/
+struct Permutation {
+  std::vector<size_t> forward{};
+  std::vector<size_t> inverse{};
+
+  [[nodiscard]] size_t size() const { return forward.size(); }
+};
+
+/*
+    Builds the permutation which puts the agents in the given order: order[k]
+    is the old index of the agent which gets the new index k
+*/
+inline Permutation permutation_from_order(std::vector<size_t> &&order) {
+  const size_t n_agents = order.size();
+  auto permutation = Permutation{
+      std::vector<size_t>(n_agents, invalid_index<size_t>), std::move(order)};
+  for (size_t k = 0; k < n_agents; k++) {
+    const size_t old_index = permutation.inverse[k];
+    if (old_index >= n_agents ||
+        permutation.forward[old_index] != invalid_index<size_t>) {
+      throw std::runtime_error(
+          "permutation_from_order: the order is not a permutation!");
+    }
+    permutation.forward[old_index] = k;
+  }
+  return permutation;
+}
+
+/*
+    Gives the permutation which undoes permutation
+*/
+inline Permutation inverse_permutation(Permutation permutation) {
+  std::swap(permutation.forward, permutation.inverse);
+  return permutation;
+}
+
+/*
+    Renumbers the agents of an adjacency list in place: the row of the agent
+    with the old index i becomes row permutation.forward[i], and every
+    neighbour j becomes permutation.forward[j]. The order within each row is
+    kept. The rows are copied into fresh allocations in the new order (on
+    n_threads threads), so that rows which are now close by also tend to lie
+    close by in memory
+*/
+template <typename WeightT, typename IndexT>
+void permute_adjacency(std::vector<std::vector<IndexT>> &neighbour_list,
+                       std::vector<std::vector<WeightT>> &weight_list,
+                       const Permutation &permutation,
+                       std::optional<size_t> n_threads = std::nullopt) {
+  const size_t n_agents = neighbour_list.size();
+  if (permutation.size() != n_agents || weight_list.size() != n_agents) {
+    throw std::runtime_error("permute_adjacency: the permutation needs one "
+                             "entry per agent!");
+  }
+
+  std::vector<std::vector<IndexT>> permuted_neighbours(n_agents);
+  std::vector<std::vector<WeightT>> permuted_weights(n_agents);
+  parallel_for(0, n_agents, resolve_n_threads(n_threads), [&](size_t k) {
+    const size_t old_index = permutation.inverse[k];
+    const auto &neighbours = neighbour_list[old_index];
+    auto &row = permuted_neighbours[k];
+    row.resize(neighbours.size());
+    for (size_t i = 0; i < neighbours.size(); i++) {
+      row[i] = static_cast<IndexT>(permutation.forward[neighbours[i]]);
+    }
+    permuted_weights[k] = weight_list[old_index];
+  });
+  neighbour_list = std::move(permuted_neighbours);
+  weight_list = std::move(permuted_weights);
+}
+
+/*
+    Moves per-agent values (e.g. opinions or labels) along with their agents:
+    gives result[permutation.forward[i]] = values[i], on n_threads threads
+*/
+template <typename T>
+std::vector<T> permute_values(const std::vector<T> &values,
+                              const Permutation &permutation,
+                              std::optional<size_t> n_threads = std::nullopt) {
+  if (values.size() != permutation.size()) {
+    throw std::runtime_error(
+        "permute_values: the values need one entry per agent!");
+  }
+  std::vector<T> result(values.size());
+  parallel_for(0, values.size(), resolve_n_threads(n_threads), [&](size_t k) {
+    result[k] = values[permutation.inverse[k]];
+  });
+  return result;
+}
+
+/*
+    Brings per-agent values computed on the renumbered network back to the
+    old agent indices: gives result[i] = values[permutation.forward[i]]
+*/
+template <typename T>
+std::vector<T>
+unpermute_values(const std::vector<T> &values, const Permutation &permutation,
+                 std::optional<size_t> n_threads = std::nullopt) {
+  if (values.size() != permutation.size()) {
+    throw std::runtime_error(
+        "unpermute_values: the values need one entry per agent!");
+  }
+  std::vector<T> result(values.size());
+  parallel_for(0, values.size(), resolve_n_threads(n_threads), [&](size_t i) {
+    result[i] = values[permutation.forward[i]];
+  });
+  return result;
+}
+
+/*
+    Renames agent indices stored as values (e.g. a list of sources, or a
+    parent index per agent) from the old to the new numbering, in place.
+    invalid_index entries are left as they are
+*/
+template <std::unsigned_integral IndexT>
+void permute_indices(std::vector<IndexT> &indices,
+                     const Permutation &permutation) {
+  for (auto &index : indices) {
+    if (index != invalid_index<IndexT>) {
+      index = static_cast<IndexT>(permutation.forward[index]);
+    }
+  }
+}
+
+} // namespace Graph
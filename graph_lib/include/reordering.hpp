@@ -0,0 +1,280 @@
+#pragma once
+#include "compressed_network.hpp"
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include "permutation.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    Orderings of the agents which improve the locality of sweeps over the
+    neighbours (e.g. get_neighbours loops, bfs or aggregate_neighbours). Each
+    gives a Permutation, which is applied with NetworkBase::permute_agents or
+    permute_agents below, and per-agent state follows with permute_values.
+    The degree of an agent is the number of neighbours stored in its row.
+*/
+
+namespace Detail {
+
+// The agents sorted by degree (a stable counting sort, so agents of equal
+// degree keep their order)
+template <NetworkView NetworkT>
+std::vector<size_t> agents_by_degree(const NetworkT &network, bool descending,
+                                     std::optional<size_t> n_threads) {
+  const size_t n_agents = network.n_agents();
+  std::vector<size_t> degrees(n_agents);
+  parallel_for(0, n_agents, resolve_n_threads(n_threads), [&](size_t i_agent) {
+    degrees[i_agent] = network.get_neighbours(i_agent).size();
+  });
+
+  const size_t max_degree =
+      n_agents > 0 ? *std::max_element(degrees.begin(), degrees.end()) : 0;
+  std::vector<size_t> first_position(max_degree + 2, 0);
+  for (size_t degree : degrees) {
+    const size_t bucket = descending ? max_degree - degree : degree;
+    first_position[bucket + 1] += 1;
+  }
+  for (size_t bucket = 1; bucket < first_position.size(); bucket++) {
+    first_position[bucket] += first_position[bucket - 1];
+  }
+
+  std::vector<size_t> order(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    const size_t bucket =
+        descending ? max_degree - degrees[i_agent] : degrees[i_agent];
+    order[first_position[bucket]++] = i_agent;
+  }
+  return order;
+}
+
+} // namespace Detail
+
+/*
+    Sorts the agents by degree, the highest degree first if descending is set
+    (which packs the hubs of a scale-free network into a few cache lines).
+    Agents of equal degree keep their order. The degrees are counted on
+    n_threads threads
+*/
+template <NetworkView NetworkT>
+Permutation degree_order(const NetworkT &network, bool descending = true,
+                         std::optional<size_t> n_threads = std::nullopt) {
+  return permutation_from_order(
+      Detail::agents_by_degree(network, descending, n_threads));
+}
+
+/*
+    Reverse Cuthill-McKee ordering: a BFS which visits the neighbours of every
+    agent by increasing degree, reversed at the end. Neighbouring agents get
+    close indices, which reduces the bandwidth of the adjacency matrix. Every
+    connected component is started at an unvisited agent of minimal degree.
+    Only the stored rows are followed, so for a DirectedNetwork the components
+    are those reachable along the stored direction
+*/
+template <NetworkView NetworkT>
+Permutation reverse_cuthill_mckee_order(const NetworkT &network) {
+  const size_t n_agents = network.n_agents();
+  const auto by_degree = Detail::agents_by_degree(network, false, 1);
+  auto degree = [&](size_t i_agent) {
+    return network.get_neighbours(i_agent).size();
+  };
+
+  std::vector<char> visited(n_agents, 0);
+  std::vector<size_t> order{};
+  order.reserve(n_agents);
+  for (size_t source : by_degree) {
+    if (visited[source]) {
+      continue;
+    }
+    visited[source] = 1;
+    order.push_back(source);
+    // order doubles as the BFS queue
+    for (size_t head = order.size() - 1; head < order.size(); head++) {
+      const size_t first_new = order.size();
+      for (size_t w : network.get_neighbours(order[head])) {
+        if (!visited[w]) {
+          visited[w] = 1;
+          order.push_back(w);
+        }
+      }
+      std::sort(order.begin() + first_new, order.end(),
+                [&](size_t a, size_t b) {
+                  return std::pair(degree(a), a) < std::pair(degree(b), b);
+                });
+    }
+  }
+
+  std::reverse(order.begin(), order.end());
+  return permutation_from_order(std::move(order));
+}
+
+/*
+    Community ordering in the spirit of Rabbit Order (Arai et al., 2016): the
+    agents are visited by increasing degree, and each one is merged into the
+    neighbouring community with the largest modularity gain, if there is a
+    positive one. The merges form a dendrogram, and the new order is a
+    depth-first traversal of it, so that every community (and every
+    sub-community) gets a contiguous range of indices.
+    The stored rows are taken as undirected edges of weight 1. The merging is
+    sequential; when a community is visited, the edges of the communities
+    merged into it are aggregated once and reused afterwards, which keeps the
+    total work close to linear in the number of edges
+*/
+template <NetworkView NetworkT>
+Permutation community_order(const NetworkT &network) {
+  const size_t n_agents = network.n_agents();
+  const auto by_degree = Detail::agents_by_degree(network, false, 1);
+
+  double total_degree = 0;
+  std::vector<double> community_degree(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    community_degree[i_agent] = double(network.get_neighbours(i_agent).size());
+    total_degree += community_degree[i_agent];
+  }
+
+  // Union-find of the communities; a community is named after its root
+  std::vector<size_t> community(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    community[i_agent] = i_agent;
+  }
+  auto find = [&](size_t i_agent) {
+    while (community[i_agent] != i_agent) {
+      community[i_agent] = community[community[i_agent]];
+      i_agent = community[i_agent];
+    }
+    return i_agent;
+  };
+
+  // The dendrogram, as linked lists of the agents merged into each agent
+  std::vector<size_t> first_child(n_agents, invalid_index<size_t>);
+  std::vector<size_t> next_sibling(n_agents, invalid_index<size_t>);
+  std::vector<char> visited(n_agents, 0);
+
+  // Edges from each community to the other ones (as they were when it was
+  // visited), kept until the community it was merged into is visited
+  std::vector<std::vector<std::pair<size_t, double>>> community_edges(n_agents);
+  std::vector<double> weight_to(n_agents, 0.0);
+  std::vector<size_t> touched{};
+
+  for (size_t u : by_degree) {
+    touched.clear();
+    auto add_edge = [&](size_t j_agent, double weight) {
+      const size_t c = find(j_agent);
+      if (c == u) {
+        return;
+      }
+      if (weight_to[c] == 0.0) {
+        touched.push_back(c);
+      }
+      weight_to[c] += weight;
+    };
+    for (size_t j_agent : network.get_neighbours(u)) {
+      add_edge(j_agent, 1.0);
+    }
+    for (size_t child = first_child[u]; child != invalid_index<size_t>;
+         child = next_sibling[child]) {
+      for (const auto &[j_agent, weight] : community_edges[child]) {
+        add_edge(j_agent, weight);
+      }
+      community_edges[child] = {};
+    }
+
+    // Gain in modularity (times the number of edges) of merging u into c
+    size_t best = invalid_index<size_t>;
+    double best_gain = 0;
+    for (size_t c : touched) {
+      const double gain = weight_to[c] - community_degree[u] *
+                                             community_degree[c] /
+                                             total_degree;
+      if (gain > best_gain) {
+        best_gain = gain;
+        best = c;
+      }
+    }
+
+    if (best != invalid_index<size_t>) {
+      community[u] = best;
+      community_degree[best] += community_degree[u];
+      next_sibling[u] = first_child[best];
+      first_child[best] = u;
+      // Only needed if best still has to be visited
+      if (!visited[best]) {
+        auto &edges = community_edges[u];
+        edges.reserve(touched.size() - 1);
+        for (size_t c : touched) {
+          if (c != best) {
+            edges.emplace_back(c, weight_to[c]);
+          }
+        }
+      }
+    }
+    for (size_t c : touched) {
+      weight_to[c] = 0.0;
+    }
+    visited[u] = 1;
+  }
+
+  // Depth-first traversal of the dendrogram, starting at the top-level
+  // communities. The children are pushed newest first, so they are taken out
+  // in the order they were merged
+  std::vector<size_t> order{};
+  order.reserve(n_agents);
+  std::vector<size_t> stack{};
+  for (size_t root = 0; root < n_agents; root++) {
+    if (community[root] != root) {
+      continue;
+    }
+    stack.push_back(root);
+    while (!stack.empty()) {
+      const size_t v = stack.back();
+      stack.pop_back();
+      order.push_back(v);
+      for (size_t child = first_child[v]; child != invalid_index<size_t>;
+           child = next_sibling[child]) {
+        stack.push_back(child);
+      }
+    }
+  }
+  return permutation_from_order(std::move(order));
+}
+
+/*
+    Gives a copy of a CompressedNetwork with the agents renumbered, see
+    permute_adjacency. The rows are filled on n_threads threads
+*/
+template <typename WeightT, typename IndexT>
+CompressedNetwork<WeightT, IndexT>
+permute_agents(const CompressedNetwork<WeightT, IndexT> &network,
+               const Permutation &permutation,
+               std::optional<size_t> n_threads = std::nullopt) {
+  const size_t n_agents = network.n_agents();
+  if (permutation.size() != n_agents) {
+    throw std::runtime_error(
+        "permute_agents: the permutation needs one entry per agent!");
+  }
+
+  std::vector<size_t> offsets(n_agents + 1, 0);
+  for (size_t k = 0; k < n_agents; k++) {
+    offsets[k + 1] = offsets[k] + network.n_edges(permutation.inverse[k]);
+  }
+  std::vector<IndexT> neighbours(offsets.back());
+  std::vector<WeightT> weights(offsets.back());
+  parallel_for(0, n_agents, resolve_n_threads(n_threads), [&](size_t k) {
+    const size_t old_index = permutation.inverse[k];
+    const auto old_neighbours = network.get_neighbours(old_index);
+    const auto old_weights = network.get_weights(old_index);
+    for (size_t i = 0; i < old_neighbours.size(); i++) {
+      neighbours[offsets[k] + i] =
+          static_cast<IndexT>(permutation.forward[old_neighbours[i]]);
+      weights[offsets[k] + i] = old_weights[i];
+    }
+  });
+  return CompressedNetwork<WeightT, IndexT>(
+      std::move(offsets), std::move(neighbours), std::move(weights));
+}
+
+} // namespace Graph
@@ -0,0 +1,445 @@
+#pragma once
+#include "network_view.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+namespace Detail {
+
+// Min-heap of items 0 ... n_items-1 keyed by a priority, with Arity children
+// per node (a 4-ary heap is shallower than a binary heap, and the children of
+// a node are next to each other in memory). The position of every item in the
+// heap is kept, so that the priority of an item can be decreased in place
+template <typename KeyT, size_t Arity = 4> class IndexedDaryHeap {
+  static constexpr size_t not_in_heap = std::numeric_limits<size_t>::max();
+
+  std::vector<std::pair<KeyT, size_t>> heap{}; // (priority, item)
+  std::vector<size_t> position{};              // Position of each item
+
+  void place(size_t i_heap, std::pair<KeyT, size_t> entry) {
+    position[entry.second] = i_heap;
+    heap[i_heap] = entry;
+  }
+
+  void sift_up(size_t i_heap) {
+    const auto entry = heap[i_heap];
+    while (i_heap > 0) {
+      const size_t i_parent = (i_heap - 1) / Arity;
+      if (!(entry.first < heap[i_parent].first)) {
+        break;
+      }
+      place(i_heap, heap[i_parent]);
+      i_heap = i_parent;
+    }
+    place(i_heap, entry);
+  }
+
+  void sift_down(size_t i_heap) {
+    const auto entry = heap[i_heap];
+    while (true) {
+      const size_t first_child = Arity * i_heap + 1;
+      if (first_child >= heap.size()) {
+        break;
+      }
+      const size_t last_child = std::min(first_child + Arity, heap.size());
+      size_t i_min = first_child;
+      for (size_t i_child = first_child + 1; i_child < last_child; i_child++) {
+        if (heap[i_child].first < heap[i_min].first) {
+          i_min = i_child;
+        }
+      }
+      if (!(heap[i_min].first < entry.first)) {
+        break;
+      }
+      place(i_heap, heap[i_min]);
+      i_heap = i_min;
+    }
+    place(i_heap, entry);
+  }
+
+public:
+  explicit IndexedDaryHeap(size_t n_items) : position(n_items, not_in_heap) {}
+
+  [[nodiscard]] bool empty() const { return heap.empty(); }
+
+  // Inserts item, or lowers its priority if it is already in the heap
+  void push_or_decrease(size_t item, KeyT key) {
+    if (position[item] == not_in_heap) {
+      heap.push_back({key, item});
+      sift_up(heap.size() - 1);
+    } else if (key < heap[position[item]].first) {
+      heap[position[item]].first = key;
+      sift_up(position[item]);
+    }
+  }
+
+  // Removes the item with the lowest priority and gives it as (key, item)
+  std::pair<KeyT, size_t> pop() {
+    const auto top = heap.front();
+    position[top.second] = not_in_heap;
+    if (heap.size() > 1) {
+      heap.front() = heap.back();
+      heap.pop_back();
+      sift_down(0);
+    } else {
+      heap.pop_back();
+    }
+    return top;
+  }
+};
+
+template <typename WeightT> void check_non_negative(WeightT weight) {
+  if (weight < WeightT(0)) {
+    throw std::runtime_error("Shortest paths need non-negative edge weights!");
+  }
+}
+
+// Lowers distance to new_distance if that is smaller, with a compare-exchange
+// loop. Gives true if distance was lowered
+template <typename WeightT>
+bool atomic_min(WeightT &distance, WeightT new_distance) {
+  std::atomic_ref<WeightT> distance_ref(distance);
+  WeightT old_distance = distance_ref.load(std::memory_order_relaxed);
+  while (new_distance < old_distance) {
+    if (distance_ref.compare_exchange_weak(old_distance, new_distance)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Whether v can be a parent of w on a shortest path, given that there is an
+// edge v -> w with distance[v] + weight == distance[w]: v has to be nearer
+// to the source, or as near (e.g. over an edge of zero weight) but reached
+// over fewer edges. Otherwise a cycle of zero weight would make the parents
+// cyclic
+template <typename WeightT>
+bool precedes(const std::vector<WeightT> &distance,
+              const std::vector<size_t> &n_hops, size_t v, size_t w) {
+  return distance[v] < distance[w] || n_hops[v] < n_hops[w];
+}
+
+// Gives the smallest number of edges on a shortest path from the source to
+// every reached node, with a breadth-first search along the edges v -> w for
+// which distance[v] + weight == distance[w]
+template <WeightedNetworkView NetworkT>
+std::vector<size_t>
+shortest_path_hops(const NetworkT &network,
+                   const std::vector<typename NetworkT::WeightT> &distance,
+                   size_t source, size_t n_threads) {
+  std::vector<size_t> n_hops(network.n_agents(), invalid_index<size_t>);
+  n_hops[source] = 0;
+  std::vector<size_t> frontier{source};
+  std::vector<std::vector<size_t>> next(n_threads);
+
+  for (size_t depth = 1; !frontier.empty(); depth++) {
+    parallel_for(
+        0, frontier.size(), n_threads,
+        [&](size_t i, size_t i_thread) {
+          const size_t v = frontier[i];
+          const auto neighbours = network.get_neighbours(v);
+          const auto weights = network.get_weights(v);
+          auto it_weight = weights.begin();
+          for (auto it = neighbours.begin(); it != neighbours.end();
+               ++it, ++it_weight) {
+            const size_t w = *it;
+            if (distance[v] + *it_weight != distance[w]) {
+              continue;
+            }
+            std::atomic_ref<size_t> n_hops_w(n_hops[w]);
+            size_t unreached = invalid_index<size_t>;
+            if (n_hops_w.load(std::memory_order_relaxed) == unreached &&
+                n_hops_w.compare_exchange_strong(unreached, depth)) {
+              next[i_thread].push_back(w);
+            }
+          }
+        },
+        64);
+    frontier.clear();
+    for (auto &buffer : next) {
+      frontier.insert(frontier.end(), buffer.begin(), buffer.end());
+      buffer.clear();
+    }
+  }
+  return n_hops;
+}
+
+// Fills parent from the final distances: every node v with an edge to w for
+// which distance[v] + weight == distance[w] and which precedes w is a parent
+// of w. The (node, parent) pairs are bucketed by the thread that owns the
+// node, so that parent[w] is only written by thread w % n_threads
+template <WeightedNetworkView NetworkT, std::unsigned_integral IndexT>
+void collect_parents(const NetworkT &network,
+                     std::vector<std::vector<IndexT>> &parent,
+                     const std::vector<typename NetworkT::WeightT> &distance,
+                     size_t source, size_t n_threads) {
+  using WeightT = typename NetworkT::WeightT;
+  const WeightT infinity = std::numeric_limits<WeightT>::max();
+  const auto n_hops = shortest_path_hops(network, distance, source, n_threads);
+  std::vector<std::vector<std::vector<std::pair<size_t, size_t>>>>
+      parent_buffers(n_threads,
+                     std::vector<std::vector<std::pair<size_t, size_t>>>(
+                         n_threads));
+
+  parallel_for(
+      0, network.n_agents(), n_threads, [&](size_t v, size_t i_thread) {
+        if (distance[v] == infinity) {
+          return;
+        }
+        const auto neighbours = network.get_neighbours(v);
+        const auto weights = network.get_weights(v);
+        auto it_weight = weights.begin();
+        for (auto it = neighbours.begin(); it != neighbours.end();
+             ++it, ++it_weight) {
+          const size_t w = *it;
+          if (w != v && w != source && distance[w] != infinity &&
+              distance[v] + *it_weight == distance[w] &&
+              precedes(distance, n_hops, v, w)) {
+            parent_buffers[i_thread][w % n_threads].push_back({w, v});
+          }
+        }
+      });
+
+  parallel_run(n_threads, [&](size_t i_thread) {
+    for (auto &buffers : parent_buffers) {
+      for (auto [w, v] : buffers[i_thread]) {
+        parent[w].push_back(static_cast<IndexT>(v));
+      }
+    }
+  });
+}
+
+} // namespace Detail
+
+// Dijkstra's algorithm from a source node, for non-negative edge weights, up
+// to an optional user-defined max_distance (nodes further away are not
+// reached). Like bfs, it needs a vector for the distances from the source
+// (initialized to std::numeric_limits<WeightT>::max() at first), and a vector
+// of vectors which is filled with all the parents of each node on shortest
+// paths (invalid_index<IndexT> for the source), so that reconstruct_paths
+// works on it. Parents are compared by exact equality of the summed weights.
+// A node at the same distance as w (over edges of zero weight) is only a
+// parent of w if it is reached over fewer edges, so that the parents never
+// form a cycle. Works on any WeightedNetworkView, e.g. a NetworkBase or a
+// CompressedNetwork. Throws if a negative weight is found.
+template <WeightedNetworkView NetworkT, std::unsigned_integral IndexT>
+void dijkstra(const NetworkT &network, std::vector<std::vector<IndexT>> &parent,
+              std::vector<typename NetworkT::WeightT> &distance, size_t source,
+              std::optional<typename NetworkT::WeightT> max_distance) {
+  using WeightT = typename NetworkT::WeightT;
+  // Nodes are settled by their distance, and then by the number of edges on
+  // their shortest path, which is final once the node is settled
+  Detail::IndexedDaryHeap<std::pair<WeightT, size_t>> heap(network.n_agents());
+  std::vector<size_t> n_hops(network.n_agents(), invalid_index<size_t>);
+  std::vector<bool> settled(network.n_agents(), false);
+
+  parent[source] = {invalid_index<IndexT>};
+  distance[source] = 0;
+  n_hops[source] = 0;
+  heap.push_or_decrease(source, {distance[source], n_hops[source]});
+
+  while (!heap.empty()) {
+    const auto top = heap.pop();
+    const auto [distance_v, n_hops_v] = top.first;
+    const size_t v = top.second;
+    settled[v] = true;
+    // The candidates at the same distance which were reached over as many
+    // edges as v are not parents of v
+    if (v != source) {
+      std::erase_if(parent[v], [&](IndexT u) {
+        return !Detail::precedes(distance, n_hops, u, v);
+      });
+    }
+
+    const auto neighbours = network.get_neighbours(v);
+    const auto weights = network.get_weights(v);
+    auto it_weight = weights.begin();
+    for (auto it = neighbours.begin(); it != neighbours.end();
+         ++it, ++it_weight) {
+      const size_t w = *it;
+      Detail::check_non_negative<WeightT>(*it_weight);
+      const WeightT distance_w = distance_v + *it_weight;
+      if (w == v || w == source ||
+          (max_distance.has_value() && distance_w > max_distance.value())) {
+        continue;
+      }
+      // If a shorter distance has been found, v replaces all the previous
+      // parents of w
+      if (distance_w < distance[w]) {
+        distance[w] = distance_w;
+        n_hops[w] = n_hops_v + 1;
+        parent[w].clear();
+        parent[w].push_back(static_cast<IndexT>(v));
+        heap.push_or_decrease(w, {distance_w, n_hops[w]});
+      }
+      // Otherwise, v is another candidate parent on a shortest path, unless w
+      // is already settled (which it can be if the edge has zero weight)
+      else if (distance_w == distance[w] && !settled[w]) {
+        n_hops[w] = std::min(n_hops[w], n_hops_v + 1);
+        parent[w].push_back(static_cast<IndexT>(v));
+        heap.push_or_decrease(w, {distance_w, n_hops[w]});
+      }
+    }
+  }
+}
+
+namespace Detail {
+
+// Delta-stepping. Parents are only collected if parent is not nullptr
+template <WeightedNetworkView NetworkT, std::unsigned_integral IndexT>
+void delta_stepping(const NetworkT &network,
+                    std::vector<std::vector<IndexT>> *parent,
+                    std::vector<typename NetworkT::WeightT> &distance,
+                    size_t source,
+                    std::optional<typename NetworkT::WeightT> max_distance,
+                    std::optional<typename NetworkT::WeightT> delta,
+                    size_t n_threads) {
+  using WeightT = typename NetworkT::WeightT;
+  const size_t n_agents = network.n_agents();
+
+  // Check the weights, and choose delta as the largest weight divided by the
+  // mean degree if it is not given
+  WeightT max_weight = 0;
+  size_t n_edges = 0;
+  for (size_t v = 0; v < n_agents; v++) {
+    for (WeightT weight : network.get_weights(v)) {
+      check_non_negative(weight);
+      max_weight = std::max(max_weight, weight);
+    }
+    n_edges += network.get_neighbours(v).size();
+  }
+  WeightT bucket_width = delta.value_or(
+      max_weight / std::max<WeightT>(WeightT(n_edges) / WeightT(n_agents), 1));
+  if (!(bucket_width > WeightT(0))) {
+    bucket_width = std::max<WeightT>(max_weight, 1);
+  }
+
+  // No entry can be more than max_weight / bucket_width buckets ahead of the
+  // current one, so the buckets are reused cyclically. Buckets can contain
+  // outdated entries of nodes whose distance was lowered later on
+  const size_t n_buckets =
+      static_cast<size_t>(std::floor(max_weight / bucket_width)) + 2;
+  auto bucket_of = [&](WeightT d) {
+    return static_cast<size_t>(std::floor(d / bucket_width));
+  };
+  std::vector<std::vector<size_t>> buckets(n_buckets);
+  size_t n_entries = 0;
+  // Nodes whose distance was lowered, found by each thread
+  std::vector<std::vector<size_t>> lowered(n_threads);
+
+  auto relax_edges = [&](const std::vector<size_t> &nodes, bool light) {
+    parallel_for(
+        0, nodes.size(), n_threads,
+        [&](size_t i, size_t i_thread) {
+          const size_t v = nodes[i];
+          const WeightT distance_v =
+              std::atomic_ref<WeightT>(distance[v]).load();
+          const auto neighbours = network.get_neighbours(v);
+          const auto weights = network.get_weights(v);
+          auto it_weight = weights.begin();
+          for (auto it = neighbours.begin(); it != neighbours.end();
+               ++it, ++it_weight) {
+            if ((*it_weight <= bucket_width) != light) {
+              continue;
+            }
+            const WeightT distance_w = distance_v + *it_weight;
+            if (max_distance.has_value() && distance_w > max_distance.value()) {
+              continue;
+            }
+            if (atomic_min(distance[*it], distance_w)) {
+              lowered[i_thread].push_back(*it);
+            }
+          }
+        },
+        64);
+    for (auto &buffer : lowered) {
+      for (size_t w : buffer) {
+        buckets[bucket_of(distance[w]) % n_buckets].push_back(w);
+      }
+      n_entries += buffer.size();
+      buffer.clear();
+    }
+  };
+
+  distance[source] = 0;
+  buckets[0].push_back(source);
+  n_entries = 1;
+  std::vector<size_t> current{}; // Nodes of the current bucket
+  std::vector<size_t> removed{};  // All nodes removed from the current bucket
+
+  for (size_t i_bucket = 0; n_entries > 0; i_bucket++) {
+    auto &bucket = buckets[i_bucket % n_buckets];
+    removed.clear();
+    // Relax the light edges until no node is left in the bucket. Nodes can
+    // come back to it if their distance is lowered by a light edge
+    while (!bucket.empty()) {
+      current.clear();
+      n_entries -= bucket.size();
+      for (size_t v : bucket) {
+        if (bucket_of(distance[v]) == i_bucket) {
+          current.push_back(v);
+        }
+      }
+      bucket.clear();
+      std::sort(current.begin(), current.end());
+      current.erase(std::unique(current.begin(), current.end()),
+                    current.end());
+      removed.insert(removed.end(), current.begin(), current.end());
+      relax_edges(current, true);
+    }
+    // The distances of the nodes in this bucket are final now, so their heavy
+    // edges only need to be relaxed once
+    std::sort(removed.begin(), removed.end());
+    removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+    relax_edges(removed, false);
+  }
+
+  if (parent != nullptr) {
+    (*parent)[source] = {invalid_index<IndexT>};
+    collect_parents(network, *parent, distance, source, n_threads);
+  }
+}
+
+} // namespace Detail
+
+// Parallel delta-stepping from a source node, for non-negative edge weights.
+// Gives the same distances and the same parent sets as dijkstra (the order of
+// the parents of a node may differ), and takes the same arguments. The nodes
+// are put into buckets of width delta by their tentative distance; the
+// buckets are processed in order, and the edges of all the nodes in a bucket
+// are relaxed in parallel on n_threads threads (one per core if not set). If
+// delta is not set, the largest weight divided by the mean degree is used.
+template <WeightedNetworkView NetworkT, std::unsigned_integral IndexT>
+void delta_stepping(
+    const NetworkT &network, std::vector<std::vector<IndexT>> &parent,
+    std::vector<typename NetworkT::WeightT> &distance, size_t source,
+    std::optional<typename NetworkT::WeightT> max_distance,
+    std::optional<typename NetworkT::WeightT> delta = std::nullopt,
+    std::optional<size_t> n_threads = std::nullopt) {
+  Detail::delta_stepping(network, &parent, distance, source, max_distance,
+                         delta, resolve_n_threads(n_threads));
+}
+
+// Same as above, but only computes the distances
+template <WeightedNetworkView NetworkT>
+void delta_stepping(
+    const NetworkT &network, std::vector<typename NetworkT::WeightT> &distance,
+    size_t source, std::optional<typename NetworkT::WeightT> max_distance,
+    std::optional<typename NetworkT::WeightT> delta = std::nullopt,
+    std::optional<size_t> n_threads = std::nullopt) {
+  Detail::delta_stepping<NetworkT, size_t>(network, nullptr, distance, source,
+                                           max_distance, delta,
+                                           resolve_n_threads(n_threads));
+}
+
+} // namespace Graph
@@ -0,0 +1,128 @@
+#pragma once
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace Graph {
+
+/*
+    Transposes an adjacency list: if agent j is in the row of agent i with
+    weight w, then agent i will be in the row of agent j with weight w.
+
+    Works like a counting sort: the entries of each transposed row are counted
+    first, every row is allocated once with its exact size, and the edges are
+    then scattered into the rows in parallel (each row has an atomic cursor).
+    If preserve_order is true, every transposed row is ordered by the source
+    agent (and, for repeated edges, by their position in the source row),
+    which is the order a sequential loop over the agents gives. Otherwise the
+    order within each row depends on the thread scheduling.
+*/
+template <typename WeightT, typename IndexT>
+void transpose_adjacency(
+    const std::vector<std::vector<IndexT>> &neighbour_list,
+    const std::vector<std::vector<WeightT>> &weight_list,
+    std::vector<std::vector<IndexT>> &neighbour_list_transpose,
+    std::vector<std::vector<WeightT>> &weight_list_transpose,
+    std::optional<size_t> n_threads = std::nullopt,
+    bool preserve_order = true) {
+  const size_t n_agents = neighbour_list.size();
+  const size_t n_threads_used = resolve_n_threads(n_threads);
+
+  if (n_threads_used == 1) {
+    // Same steps without the atomics; the rows come out in order
+    std::vector<size_t> n_entries(n_agents, 0);
+    for (const auto &neighbours : neighbour_list) {
+      for (size_t neighbour : neighbours) {
+        n_entries[neighbour] += 1;
+      }
+    }
+    neighbour_list_transpose.resize(n_agents);
+    weight_list_transpose.resize(n_agents);
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      neighbour_list_transpose[i_agent].resize(n_entries[i_agent]);
+      weight_list_transpose[i_agent].resize(n_entries[i_agent]);
+      n_entries[i_agent] = 0;
+    }
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      for (size_t i_neighbour = 0;
+           i_neighbour < neighbour_list[i_agent].size(); i_neighbour++) {
+        const size_t neighbour = neighbour_list[i_agent][i_neighbour];
+        const size_t position = n_entries[neighbour]++;
+        neighbour_list_transpose[neighbour][position] =
+            static_cast<IndexT>(i_agent);
+        weight_list_transpose[neighbour][position] =
+            weight_list[i_agent][i_neighbour];
+      }
+    }
+    return;
+  }
+
+  // Count the entries of each transposed row
+  std::vector<std::atomic<size_t>> cursor(n_agents);
+  parallel_for(0, n_agents, n_threads_used, [&](size_t i_agent) {
+    for (size_t neighbour : neighbour_list[i_agent]) {
+      cursor[neighbour].fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+
+  // Allocate every row once, with the exact size
+  neighbour_list_transpose.resize(n_agents);
+  weight_list_transpose.resize(n_agents);
+  parallel_for(0, n_agents, n_threads_used, [&](size_t i_agent) {
+    const size_t n_entries = cursor[i_agent].load(std::memory_order_relaxed);
+    neighbour_list_transpose[i_agent].resize(n_entries);
+    weight_list_transpose[i_agent].resize(n_entries);
+    cursor[i_agent].store(0, std::memory_order_relaxed);
+  });
+
+  // Scatter the edges. All edges of a source row are handled by the same
+  // thread, so repeated edges keep their relative order in the target row
+  parallel_for(0, n_agents, n_threads_used, [&](size_t i_agent) {
+    const auto &neighbours = neighbour_list[i_agent];
+    const auto &weights = weight_list[i_agent];
+    for (size_t i_neighbour = 0; i_neighbour < neighbours.size();
+         i_neighbour++) {
+      const size_t neighbour = neighbours[i_neighbour];
+      const size_t position =
+          cursor[neighbour].fetch_add(1, std::memory_order_relaxed);
+      neighbour_list_transpose[neighbour][position] =
+          static_cast<IndexT>(i_agent);
+      weight_list_transpose[neighbour][position] = weights[i_neighbour];
+    }
+  });
+
+  if (!preserve_order) {
+    return;
+  }
+
+  // Restore the order of the sequential loop with a stable sort of every row
+  // that was scattered out of order. Scratch space is kept per thread
+  std::vector<std::vector<std::pair<IndexT, WeightT>>> scratch(n_threads_used);
+  parallel_for(
+      0, n_agents, n_threads_used, [&](size_t i_agent, size_t i_thread) {
+        auto &neighbours = neighbour_list_transpose[i_agent];
+        auto &weights = weight_list_transpose[i_agent];
+        if (std::is_sorted(neighbours.begin(), neighbours.end())) {
+          return;
+        }
+
+        auto &entries = scratch[i_thread];
+        entries.resize(neighbours.size());
+        for (size_t i = 0; i < neighbours.size(); i++) {
+          entries[i] = {neighbours[i], weights[i]};
+        }
+        std::stable_sort(
+            entries.begin(), entries.end(),
+            [](const auto &e1, const auto &e2) { return e1.first < e2.first; });
+        for (size_t i = 0; i < neighbours.size(); i++) {
+          neighbours[i] = entries[i].first;
+          weights[i] = entries[i].second;
+        }
+      });
+}
+
+} // namespace Graph
@@ -1,24 +1,28 @@
 #pragma once
+#include "duplicate_edges.hpp"
 #include "network_base.hpp"
+#include "parallel.hpp"
+#include "transpose.hpp"
 
 namespace Graph {
 
 /*
     A class that represents an undirected graph using adjacency lists.
 */
-template <typename WeightType = double>
-class UndirectedNetwork : public NetworkBase<WeightType> {
+template <typename WeightType = double, typename IndexType = size_t>
+class UndirectedNetwork : public NetworkBase<WeightType, IndexType> {
 public:
   using WeightT = WeightType;
+  using IndexT = IndexType;
 
   UndirectedNetwork() = default;
 
-  UndirectedNetwork(size_t n_agents) : NetworkBase<WeightT>(n_agents) {}
+  UndirectedNetwork(size_t n_agents) : NetworkBase<WeightT, IndexT>(n_agents) {}
 
-  UndirectedNetwork(std::vector<std::vector<size_t>> &&neighbour_list,
+  UndirectedNetwork(std::vector<std::vector<IndexT>> &&neighbour_list,
                     std::vector<std::vector<WeightT>> &&weight_list)
-      : Graph::NetworkBase<>(std::move(neighbour_list),
-                             std::move(weight_list)) {}
+      : Graph::NetworkBase<WeightT, IndexT>(std::move(neighbour_list),
+                                            std::move(weight_list)) {}
 
   /*
   Gives the number of edges connected to agent_idx
@@ -46,18 +50,16 @@ public:
   void set_edge_weight(std::size_t agent_idx, std::size_t index_neighbour,
                        WeightT weight) override {
     this->weight_list[agent_idx][index_neighbour] = weight;
-    auto agent_jdx = this->neighbour_list[agent_idx][index_neighbour];
-    auto it = std::find(this->neighbour_list[agent_jdx].begin(),
-                        this->neighbour_list[agent_jdx].end(), agent_idx);
+    const size_t agent_jdx = this->neighbour_list[agent_idx][index_neighbour];
+    const auto position = this->find_neighbour(agent_jdx, agent_idx);
     // If agent_idx is not in the neighbour list of agent_jdx, add it to the
     // list and add the weight
-    if (it == this->neighbour_list[agent_jdx].end()) {
-      this->neighbour_list[agent_jdx].push_back(agent_idx);
-      this->weight_list[agent_jdx].push_back(weight);
+    if (!position.has_value()) {
+      this->insert_neighbour(agent_jdx, agent_idx, weight);
     }
-    // If found then update the weight
+    // If found then update the weight at the position of agent_idx
     else {
-      this->weight_list[agent_jdx][*it] = weight;
+      this->weight_list[agent_jdx][position.value()] = weight;
     }
   }
 
@@ -68,68 +70,121 @@ public:
   void push_back_neighbour_and_weight(size_t agent_idx_i, size_t agent_idx_j,
                                       WeightT w) override {
     // agent_idx_j is a neighbour of agent_idx_i
-    this->neighbour_list[agent_idx_i].push_back(agent_idx_j);
-    this->weight_list[agent_idx_i].push_back(w);
+    this->insert_neighbour(agent_idx_i, agent_idx_j, w);
     // agent_idx_i is a neighbour of agent_idx_j
-    this->neighbour_list[agent_idx_j].push_back(agent_idx_i);
-    this->weight_list[agent_idx_j].push_back(w);
+    this->insert_neighbour(agent_idx_j, agent_idx_i, w);
   }
 
   /*
   Sorts the neighbours by index and removes doubly counted edges by summing the
-  weights
+  weights. The agents are processed on n_threads threads (one per core if not
+  set), see merge_duplicate_edges.
+  Afterwards both halves of every edge carry the same weight: the weight of the
+  half stored with the smaller agent index (or of the only half, if the other
+  one is missing, which is then added)
   */
-  void remove_double_counting() override {
-    std::vector<size_t> sorting_indices{};
-
-    for (size_t idx_agent = 0; idx_agent < this->n_agents(); idx_agent++) {
-
-      auto &neighbours = this->neighbour_list[idx_agent];
-      auto &weights = this->weight_list[idx_agent];
-      bool updated_weight = false;
-
-      std::vector<WeightT> weights_copy{};
-      std::vector<size_t> neighbours_copy{};
-
-      const auto n_neighbours = neighbours.size();
-
-      // First we will the sorting_indices array
-      sorting_indices.resize(n_neighbours);
-      std::iota(sorting_indices.begin(), sorting_indices.end(), 0);
-
-      // Then, we figure out how to sort the neighbour indices list
-      std::sort(
-          sorting_indices.begin(), sorting_indices.end(),
-          [&](auto i1, auto i2) { return neighbours[i1] < neighbours[i2]; });
-
-      std::optional<size_t> last_neighbour_index = std::nullopt;
-      for (size_t i = 0; i < n_neighbours; i++) {
-        const auto sort_idx = sorting_indices[i];
-        const auto current_neigbhour_idx = neighbours[sort_idx];
-        const auto current_weight = weights[sort_idx];
-
-        if (last_neighbour_index != current_neigbhour_idx) {
-          weights_copy.push_back(current_weight);
-          neighbours_copy.push_back(current_neigbhour_idx);
-          last_neighbour_index = current_neigbhour_idx;
-        } else {
-          weights_copy.back() += current_weight;
-          updated_weight = true;
-        }
-      }
+  void remove_double_counting(
+      std::optional<size_t> n_threads = std::nullopt) override {
+    merge_duplicate_edges(this->neighbour_list, this->weight_list, n_threads);
+    if (!mirror_upper_weights()) {
+      symmetrize(n_threads);
+    }
+    this->rows_changed(n_threads);
+  }
 
-      this->neighbour_list[idx_agent] = neighbours_copy;
+private:
+  /*
+  Copies the weight of every half-edge i -> j with i < j onto its reverse half
+  j -> i, in a single sweep over the sorted rows. Sweeping i in increasing
+  order visits the reverse halves stored in each row j in increasing order
+  too, so one cursor per row gives the position of every reverse half.
+  Returns false as soon as a half-edge without its reverse half is found
+  */
+  bool mirror_upper_weights() {
+    std::vector<size_t> reverse_cursor(this->n_agents(), 0);
+    for (size_t i_agent = 0; i_agent < this->n_agents(); i_agent++) {
+      const auto &neighbours = this->neighbour_list[i_agent];
+      const size_t first_upper =
+          std::lower_bound(neighbours.begin(), neighbours.end(), i_agent) -
+          neighbours.begin();
+
+      // Every half-edge below the diagonal must have been matched by now
+      if (reverse_cursor[i_agent] != first_upper) {
+        return false;
+      }
 
-      // If the weights were updated, change the weight for the other edge:
-      if (updated_weight) {
-        for (size_t i = 0; i < n_neighbours; i++) {
-          set_edge_weight(idx_agent, this->neighbour_list[idx_agent][i],
-                          this->weight_list[idx_agent][i]);
+      for (size_t i = first_upper; i < neighbours.size(); i++) {
+        const size_t j_agent = neighbours[i];
+        if (j_agent == i_agent) {
+          continue; // A self-loop is its own reverse
+        }
+        auto &cursor = reverse_cursor[j_agent];
+        const auto &reverse_neighbours = this->neighbour_list[j_agent];
+        if (cursor == reverse_neighbours.size() ||
+            reverse_neighbours[cursor] != i_agent) {
+          return false;
         }
-      } else {
-        this->weight_list[idx_agent] = weights_copy;
+        this->weight_list[j_agent][cursor++] = this->weight_list[i_agent][i];
       }
     }
+    return true;
+  }
+
+  /*
+  Makes the sorted and merged rows symmetric when some half-edges have no
+  reverse half: every row becomes the union of itself and its row in the
+  transpose, which gives the reverse half of every edge
+  */
+  void symmetrize(std::optional<size_t> n_threads) {
+    std::vector<std::vector<IndexT>> neighbour_list_transpose{};
+    std::vector<std::vector<WeightT>> weight_list_transpose{};
+    transpose_adjacency(this->neighbour_list, this->weight_list,
+                        neighbour_list_transpose, weight_list_transpose,
+                        n_threads);
+
+    const size_t n_threads_used = resolve_n_threads(n_threads);
+    std::vector<std::vector<IndexT>> neighbours_merged(n_threads_used);
+    std::vector<std::vector<WeightT>> weights_merged(n_threads_used);
+    parallel_for(
+        0, this->n_agents(), n_threads_used,
+        [&](size_t i_agent, size_t i_thread) {
+          const auto &neighbours = this->neighbour_list[i_agent];
+          const auto &weights = this->weight_list[i_agent];
+          const auto &reverse_neighbours = neighbour_list_transpose[i_agent];
+          const auto &reverse_weights = weight_list_transpose[i_agent];
+          auto &neighbours_out = neighbours_merged[i_thread];
+          auto &weights_out = weights_merged[i_thread];
+          neighbours_out.clear();
+          weights_out.clear();
+
+          size_t i = 0;
+          size_t k = 0;
+          while (i < neighbours.size() || k < reverse_neighbours.size()) {
+            if (k == reverse_neighbours.size() ||
+                (i < neighbours.size() &&
+                 neighbours[i] < reverse_neighbours[k])) {
+              neighbours_out.push_back(neighbours[i]);
+              weights_out.push_back(weights[i++]);
+            } else if (i == neighbours.size() ||
+                       reverse_neighbours[k] < neighbours[i]) {
+              neighbours_out.push_back(reverse_neighbours[k]);
+              weights_out.push_back(reverse_weights[k++]);
+            } else {
+              // Both halves exist: the one of the smaller agent index wins
+              neighbours_out.push_back(neighbours[i]);
+              weights_out.push_back(neighbours[i] >= i_agent
+                                        ? weights[i]
+                                        : reverse_weights[k]);
+              i++;
+              k++;
+            }
+          }
+
+          this->neighbour_list[i_agent].assign(neighbours_out.begin(),
+                                               neighbours_out.end());
+          this->weight_list[i_agent].assign(weights_out.begin(),
+                                            weights_out.end());
+        });
   }
 };
 
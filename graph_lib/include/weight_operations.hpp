@@ -0,0 +1,182 @@
+#pragma once
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace Graph {
+
+namespace Detail {
+
+// Sum of a row of weights. Four partial sums let the compiler keep several
+// additions in flight (or vectorize them)
+template <typename WeightT>
+WeightT row_sum(const std::vector<WeightT> &weights) {
+  WeightT sum[4] = {0, 0, 0, 0};
+  size_t k = 0;
+  for (; k + 4 <= weights.size(); k += 4) {
+    for (size_t lane = 0; lane < 4; lane++) {
+      sum[lane] += weights[k + lane];
+    }
+  }
+  for (; k < weights.size(); k++) {
+    sum[0] += weights[k];
+  }
+  return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+// Multiplies every weight of a row by factor
+template <typename WeightT>
+void scale_row(std::vector<WeightT> &weights, WeightT factor) {
+  for (auto &weight : weights) {
+    weight *= factor;
+  }
+}
+
+} // namespace Detail
+
+/*
+    Scales every row of weights so that it sums to 1. Rows whose weights sum
+    to 0 are left as they are. The rows are processed in parallel and in place.
+*/
+template <typename WeightT>
+void normalize_weight_rows(std::vector<std::vector<WeightT>> &weight_list,
+                           std::optional<size_t> n_threads = std::nullopt) {
+  parallel_for(0, weight_list.size(), resolve_n_threads(n_threads),
+               [&](size_t i_agent) {
+                 const WeightT sum = Detail::row_sum(weight_list[i_agent]);
+                 if (sum != WeightT(0)) {
+                   Detail::scale_row(weight_list[i_agent], WeightT(1) / sum);
+                 }
+               });
+}
+
+/*
+    Scales the weights so that, for every agent j, the weights of all the
+    entries with neighbour j (the column of j) sum to 1. Columns whose weights
+    sum to 0 are left as they are.
+    No transpose is needed: every thread sums up the columns of its own block
+    of rows into its own partial sums (thread 0 directly into the result),
+    the partial sums are added up, and then every weight is divided by the sum
+    of its column.
+*/
+template <typename WeightT, typename IndexT>
+void normalize_weight_columns(
+    const std::vector<std::vector<IndexT>> &neighbour_list,
+    std::vector<std::vector<WeightT>> &weight_list,
+    std::optional<size_t> n_threads = std::nullopt) {
+  const size_t n_agents = neighbour_list.size();
+  // Small networks are not worth the partial sums
+  const size_t n_threads_used = std::max<size_t>(
+      std::min(resolve_n_threads(n_threads), n_agents / 4096), 1);
+
+  std::vector<WeightT> column_sums(n_agents, WeightT(0));
+  std::vector<std::vector<WeightT>> partial_sums(n_threads_used - 1);
+  parallel_for_blocks(
+      0, n_agents, n_threads_used,
+      [&](size_t block_begin, size_t block_end, size_t i_thread) {
+        WeightT *sums = column_sums.data();
+        if (i_thread > 0) {
+          partial_sums[i_thread - 1].assign(n_agents, WeightT(0));
+          sums = partial_sums[i_thread - 1].data();
+        }
+        for (size_t i_agent = block_begin; i_agent < block_end; i_agent++) {
+          const auto &neighbours = neighbour_list[i_agent];
+          const auto &weights = weight_list[i_agent];
+          for (size_t k = 0; k < neighbours.size(); k++) {
+            sums[neighbours[k]] += weights[k];
+          }
+        }
+      });
+
+  // Turn the sums into the factors to multiply the weights with
+  parallel_for_blocks(0, n_agents, n_threads_used,
+                      [&](size_t block_begin, size_t block_end, size_t) {
+                        for (size_t j = block_begin; j < block_end; j++) {
+                          WeightT sum = column_sums[j];
+                          for (const auto &sums : partial_sums) {
+                            sum += sums[j];
+                          }
+                          column_sums[j] =
+                              sum != WeightT(0) ? WeightT(1) / sum : WeightT(1);
+                        }
+                      });
+
+  parallel_for(0, n_agents, resolve_n_threads(n_threads), [&](size_t i_agent) {
+    const auto &neighbours = neighbour_list[i_agent];
+    auto &weights = weight_list[i_agent];
+    for (size_t k = 0; k < neighbours.size(); k++) {
+      weights[k] *= column_sums[neighbours[k]];
+    }
+  });
+}
+
+/*
+    Replaces every weight w by func(w), or, if func takes three arguments, by
+    func(i_agent, j_agent, w), where j_agent is the neighbour in the row of
+    i_agent. The rows are processed in parallel and in place, so func is called
+    from several threads at once.
+*/
+template <typename WeightT, typename IndexT, typename Func>
+void transform_weight_list(
+    const std::vector<std::vector<IndexT>> &neighbour_list,
+    std::vector<std::vector<WeightT>> &weight_list, Func &&func,
+    std::optional<size_t> n_threads = std::nullopt) {
+  parallel_for(0, weight_list.size(), resolve_n_threads(n_threads),
+               [&](size_t i_agent) {
+                 auto &weights = weight_list[i_agent];
+                 if constexpr (std::is_invocable_v<Func, size_t, size_t,
+                                                   WeightT>) {
+                   const auto &neighbours = neighbour_list[i_agent];
+                   for (size_t k = 0; k < weights.size(); k++) {
+                     weights[k] = func(i_agent, size_t(neighbours[k]),
+                                       weights[k]);
+                   }
+                 } else {
+                   for (auto &weight : weights) {
+                     weight = func(weight);
+                   }
+                 }
+               });
+}
+
+/*
+    Removes every edge for which remove(i_agent, j_agent, w) is true, where
+    j_agent is the neighbour in the row of i_agent and w the weight of the
+    edge. The order of the remaining edges is kept. The rows are processed in
+    parallel and in place. Gives the number of removed entries.
+*/
+template <typename WeightT, typename IndexT, typename Pred>
+size_t remove_edges_if(std::vector<std::vector<IndexT>> &neighbour_list,
+                       std::vector<std::vector<WeightT>> &weight_list,
+                       Pred &&remove,
+                       std::optional<size_t> n_threads = std::nullopt) {
+  const size_t n_threads_used = resolve_n_threads(n_threads);
+  std::vector<size_t> n_removed(n_threads_used, 0);
+  parallel_for(0, neighbour_list.size(), n_threads_used,
+               [&](size_t i_agent, size_t i_thread) {
+                 auto &neighbours = neighbour_list[i_agent];
+                 auto &weights = weight_list[i_agent];
+                 size_t n_kept = 0;
+                 for (size_t k = 0; k < neighbours.size(); k++) {
+                   if (!remove(i_agent, size_t(neighbours[k]), weights[k])) {
+                     neighbours[n_kept] = neighbours[k];
+                     weights[n_kept] = weights[k];
+                     n_kept++;
+                   }
+                 }
+                 n_removed[i_thread] += neighbours.size() - n_kept;
+                 neighbours.resize(n_kept);
+                 weights.resize(n_kept);
+               });
+
+  size_t n_removed_total = 0;
+  for (size_t n : n_removed) {
+    n_removed_total += n;
+  }
+  return n_removed_total;
+}
+
+} // namespace Graph
@@ -0,0 +1,130 @@
+#include "bidirectional_network.hpp"
+#include "directed_network.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <vector>
+
+// Checks that every edge is stored in both directions, with matching weights,
+// and that the cross-index of each copy points to the other copy
+template <typename NetworkT>
+bool directions_consistent(const NetworkT &network) {
+  bool consistent = true;
+  for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+    const auto out_neighbours = network.get_out_neighbours(i_agent);
+    for (size_t i = 0; i < out_neighbours.size(); i++) {
+      const size_t j_agent = out_neighbours[i];
+      const size_t position = network.get_out_cross_index(i_agent, i);
+      consistent &= network.get_in_neighbours(j_agent)[position] == i_agent;
+      consistent &= network.get_in_weights(j_agent)[position] ==
+                    network.get_out_weights(i_agent)[i];
+      consistent &= network.get_in_cross_index(j_agent, position) == i;
+    }
+    size_t n_in_edges = 0;
+    for (size_t j_agent = 0; j_agent < network.n_agents(); j_agent++) {
+      n_in_edges += network.n_in_edges(j_agent);
+    }
+    consistent &= n_in_edges == network.n_edges();
+  }
+  return consistent;
+}
+
+TEST_CASE("Testing the bidirectional network class") {
+  using namespace Graph;
+  using WeightT = double;
+  using EdgeDirection = BidirectionalNetwork<WeightT>::EdgeDirection;
+
+  // Incoming edges: 0 <- 1, 0 <- 2, 1 <- 1, 2 <- 0, 4 <- 3, 4 <- 0, 4 <- 1
+  auto directed = DirectedNetwork<WeightT>(
+      std::vector<std::vector<size_t>>{{1, 2}, {1}, {0}, {}, {3, 0, 1}},
+      std::vector<std::vector<WeightT>>{
+          {0.5, 0.6}, {0.7}, {0.2}, {}, {0.1, 0.2, 0.3}},
+      EdgeDirection::Incoming);
+
+  auto network = BidirectionalNetwork<WeightT>(directed);
+
+  REQUIRE(network.n_agents() == 5);
+  REQUIRE(network.n_edges() == 7);
+  REQUIRE(directions_consistent(network));
+
+  // The incoming side is exactly the original network
+  for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+    REQUIRE_THAT(
+        network.get_in_neighbours(i_agent),
+        Catch::Matchers::RangeEquals(directed.get_neighbours(i_agent)));
+    REQUIRE_THAT(network.get_in_weights(i_agent),
+                 Catch::Matchers::RangeEquals(directed.get_weights(i_agent)));
+  }
+  // Outgoing edges of agent 0: 0 -> 2, 0 -> 4
+  REQUIRE_THAT(network.get_out_neighbours(0),
+               Catch::Matchers::RangeEquals(std::vector<size_t>{2, 4}));
+  REQUIRE_THAT(network.get_out_weights(0),
+               Catch::Matchers::RangeEquals(std::vector<WeightT>{0.2, 0.2}));
+  REQUIRE(network.get_neighbours(1).size() == 3);
+
+  SECTION("Edge weights are updated on both sides") {
+    network.set_edge_weight(0, 1, 0.9); // the edge 0 -> 4
+    REQUIRE(network.get_in_weights(4)[1] == 0.9);
+    network.set_in_edge_weight(0, 0, 0.8); // the edge 1 -> 0
+    REQUIRE(network.get_out_weights(1)[0] == 0.8);
+    REQUIRE(directions_consistent(network));
+  }
+
+  SECTION("push_back and remove_double_counting keep both sides consistent") {
+    network.push_back_neighbour_and_weight(3, 4, 1.0);
+    network.push_back_neighbour_and_weight(1, 0, 0.5);
+    network.push_back_neighbour_and_weight(3, 2, 1.0);
+    REQUIRE(network.n_edges() == 10);
+    REQUIRE(directions_consistent(network));
+
+    network.remove_double_counting();
+    REQUIRE(network.n_edges() == 8);
+    REQUIRE(directions_consistent(network));
+    REQUIRE_THAT(network.get_out_neighbours(3),
+                 Catch::Matchers::RangeEquals(std::vector<size_t>{2, 4}));
+    REQUIRE_THAT(network.get_out_weights(3),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{1.0, 1.1}));
+    REQUIRE_THAT(network.get_in_neighbours(0),
+                 Catch::Matchers::RangeEquals(std::vector<size_t>{1, 2}));
+    REQUIRE_THAT(network.get_in_weights(0),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{1.0, 0.6}));
+  }
+
+  SECTION("Sorted adjacency mode keeps both sides consistent") {
+    network.set_sorted_adjacency(true);
+    REQUIRE(directions_consistent(network));
+    network.push_back_neighbour_and_weight(4, 2, 2.0);
+    network.push_back_neighbour_and_weight(4, 0, 3.0);
+    network.push_back_neighbour_and_weight(0, 1, 4.0);
+    REQUIRE(directions_consistent(network));
+    REQUIRE(std::ranges::is_sorted(network.get_out_neighbours(4)));
+    REQUIRE(std::ranges::is_sorted(network.get_out_neighbours(0)));
+    REQUIRE(network.connection_exists(4, 2));
+    REQUIRE(!network.connection_exists(2, 4));
+  }
+
+  SECTION("Conversion back to a DirectedNetwork") {
+    auto outgoing = network.to_directed_network(EdgeDirection::Outgoing);
+    REQUIRE(outgoing.direction() == EdgeDirection::Outgoing);
+    auto network_from_outgoing = BidirectionalNetwork<WeightT>(outgoing);
+    REQUIRE(directions_consistent(network_from_outgoing));
+    for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+      REQUIRE_THAT(network_from_outgoing.get_in_neighbours(i_agent),
+                   Catch::Matchers::UnorderedRangeEquals(
+                       directed.get_neighbours(i_agent)));
+    }
+
+    // The views can be used as networks of their own
+    auto in_view = network.in_view();
+    REQUIRE(in_view.n_agents() == network.n_agents());
+    REQUIRE_THAT(in_view.get_neighbours(4),
+                 Catch::Matchers::RangeEquals(directed.get_neighbours(4)));
+  }
+
+  SECTION("Clearing the network clears both sides") {
+    network.clear();
+    REQUIRE(network.n_edges() == 0);
+    REQUIRE(network.n_in_edges(4) == 0);
+  }
+}
@@ -0,0 +1,81 @@
+#include "compressed_network.hpp"
+#include "directed_network.hpp"
+#include "network_generation.hpp"
+#include "network_operations.hpp"
+#include "undirected_network.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <optional>
+#include <set>
+#include <vector>
+
+TEST_CASE("Testing the compressed network snapshot") {
+  using namespace Graph;
+  using WeightT = double;
+
+  auto network = DirectedNetwork<WeightT>(
+      std::vector<std::vector<size_t>>{{1, 2}, {1}, {0}, {}, {3, 0, 1}},
+      std::vector<std::vector<WeightT>>{
+          {0.5, 0.5}, {0.5}, {0.2}, {}, {0.1, 0.2, 0.3}},
+      DirectedNetwork<WeightT>::EdgeDirection::Incoming);
+
+  auto compressed = CompressedNetwork<WeightT>(network);
+
+  REQUIRE(compressed.n_agents() == network.n_agents());
+  REQUIRE(compressed.n_edges() == network.n_edges());
+  auto offsets_required = std::vector<size_t>{0, 2, 3, 4, 4, 7};
+  REQUIRE_THAT(compressed.get_offsets(),
+               Catch::Matchers::RangeEquals(offsets_required));
+
+  // Every row should be identical to the original network
+  for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+    REQUIRE(compressed.n_edges(i_agent) == network.n_edges(i_agent));
+    REQUIRE_THAT(compressed.get_neighbours(i_agent),
+                 Catch::Matchers::RangeEquals(network.get_neighbours(i_agent)));
+    REQUIRE_THAT(compressed.get_weights(i_agent),
+                 Catch::Matchers::RangeEquals(network.get_weights(i_agent)));
+  }
+
+  REQUIRE(compressed.get_edge_weight(4, 2) == 0.3);
+  REQUIRE(compressed.connection_exists(4, 0));
+  REQUIRE(!compressed.connection_exists(3, 0));
+
+  SECTION("Strongly connected components agree with the original network") {
+    auto scc_original = network.strongly_connected_components();
+    auto scc_compressed = compressed.strongly_connected_components();
+    REQUIRE_THAT(scc_compressed, Catch::Matchers::RangeEquals(scc_original));
+  }
+
+  SECTION("Constructing from inconsistent flat arrays throws") {
+    REQUIRE_THROWS(CompressedNetwork<WeightT>(std::vector<size_t>{0, 2},
+                                              std::vector<size_t>{1},
+                                              std::vector<WeightT>{1.0}));
+    REQUIRE_THROWS(CompressedNetwork<WeightT>(std::vector<size_t>{0, 1},
+                                              std::vector<size_t>{1},
+                                              std::vector<WeightT>{}));
+  }
+}
+
+TEST_CASE("BFS on a compressed network", "[compressedBFS]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_edge = 6;
+  auto network =
+      UndirectedNetworkGeneration::generate_square_lattice<WeightT>(n_edge);
+  auto compressed = CompressedNetwork<WeightT>(network);
+
+  auto depth_level =
+      std::vector<size_t>(network.n_agents(), invalid_index<size_t>);
+  auto parent = std::vector<std::vector<size_t>>(network.n_agents());
+  auto depth_level_compressed = depth_level;
+  auto parent_compressed = parent;
+
+  bfs(network, parent, depth_level, 0, std::nullopt);
+  bfs(compressed, parent_compressed, depth_level_compressed, 0, std::nullopt);
+
+  REQUIRE_THAT(depth_level_compressed,
+               Catch::Matchers::RangeEquals(depth_level));
+  REQUIRE_THAT(parent_compressed, Catch::Matchers::RangeEquals(parent));
+}
@@ -0,0 +1,229 @@
+#include "connectivity.hpp"
+#include "directed_network.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Puts the components into a canonical form, so that partitions can be
+// compared independently of the order in which the components were found
+template <typename IndexT>
+std::set<std::set<size_t>>
+as_partition(const std::vector<std::vector<IndexT>> &components) {
+  std::set<std::set<size_t>> partition{};
+  for (const auto &component : components) {
+    partition.insert(std::set<size_t>(component.begin(), component.end()));
+  }
+  return partition;
+}
+
+TEST_CASE("Testing Tarjan's algorithm for strongly connected components",
+          "[tarjan]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // 0 -> 1 -> 0 and 0 -> 2 -> 1 form one SCC; 3 -> 4 -> 3 another one;
+  // 5 has a self-loop and only points into the others
+  std::vector<std::vector<size_t>> neighbour_list = {
+      {1, 2}, {0}, {1}, {4}, {3, 2}, {5, 0, 3}};
+  std::vector<std::vector<WeightT>> weight_list = {
+      {1.0, 1.0}, {1.0}, {1.0}, {1.0}, {1.0, 1.0}, {1.0, 1.0, 1.0}};
+
+  auto network = DirectedNetwork<WeightT>(
+      std::move(neighbour_list), std::move(weight_list),
+      DirectedNetwork<WeightT>::EdgeDirection::Outgoing);
+
+  auto scc_required = std::set<std::set<size_t>>{{0, 1, 2}, {3, 4}, {5}};
+
+  auto tarjan_scc = TarjanConnectivityAlgo(network);
+  REQUIRE(tarjan_scc.scc_list.size() == 3);
+  REQUIRE(as_partition(tarjan_scc.scc_list.to_nested()) == scc_required);
+
+  // The flat buffer contains every vertex exactly once
+  auto flat_vertices = tarjan_scc.scc_list.get_vertices();
+  auto vertices =
+      std::vector<size_t>(flat_vertices.begin(), flat_vertices.end());
+  std::sort(vertices.begin(), vertices.end());
+  REQUIRE_THAT(vertices, Catch::Matchers::RangeEquals(
+                             std::vector<size_t>{0, 1, 2, 3, 4, 5}));
+
+  // Components are found in reverse topological order, in the order in which
+  // Tarjan's algorithm pops them from the stack
+  REQUIRE_THAT(network.strongly_connected_components(),
+               Catch::Matchers::RangeEquals(std::vector<std::vector<size_t>>{
+                   {2, 1, 0}, {4, 3}, {5}}));
+
+  // The flat list gives the same components; turning it into nested form
+  // empties it
+  auto scc_list = network.strongly_connected_component_list();
+  REQUIRE(scc_list.size() == 3);
+  REQUIRE_THAT(scc_list[1], Catch::Matchers::RangeEquals(
+                                std::vector<size_t>{4, 3}));
+  REQUIRE(scc_list.to_nested() == network.strongly_connected_components());
+  REQUIRE(std::move(scc_list).to_nested() ==
+          network.strongly_connected_components());
+  REQUIRE(scc_list.empty());
+}
+
+TEST_CASE("Tarjan's algorithm on a very long cycle", "[tarjanLong]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // A single cycle 0 -> 1 -> ... -> n-1 -> 0. The depth-first search has to
+  // go n levels deep, which would overflow the stack if done recursively
+  const size_t n_agents = 500000;
+  auto network = DirectedNetwork<WeightT>(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    network.push_back_neighbour_and_weight(i_agent, (i_agent + 1) % n_agents,
+                                           1.0);
+  }
+
+  auto scc = network.strongly_connected_components();
+  REQUIRE(scc.size() == 1);
+  REQUIRE(scc[0].size() == n_agents);
+
+  // Removing the closing edge gives n trivial SCCs
+  network.set_neighbours_and_weights(n_agents - 1, std::vector<size_t>{},
+                                     std::vector<WeightT>{});
+  auto tarjan_scc = TarjanConnectivityAlgo(network);
+  REQUIRE(tarjan_scc.scc_list.size() == n_agents);
+}
+
+TEST_CASE("Parallel SCCs give the same partition as Tarjan's algorithm",
+          "[parallelSCC]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_agents = 20000;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+
+  auto network = DirectedNetwork<WeightT>(n_agents);
+
+  SECTION("Sparse random network with many small SCCs") {
+    // With an average degree close to one, there is no giant SCC
+    for (size_t i_edge = 0; i_edge < n_agents + n_agents / 4; i_edge++) {
+      network.push_back_neighbour_and_weight(dist_agent(gen), dist_agent(gen),
+                                             1.0);
+    }
+  }
+
+  SECTION("Random network with a giant SCC") {
+    for (size_t i_edge = 0; i_edge < 3 * n_agents; i_edge++) {
+      network.push_back_neighbour_and_weight(dist_agent(gen), dist_agent(gen),
+                                             1.0);
+    }
+  }
+
+  SECTION("Chain of small cycles") {
+    // ... 5 <-> 4 -> 3 <-> 2 -> 1 <-> 0, where the largest index reaches
+    // everything, so that colouring makes little progress
+    for (size_t i_agent = 0; i_agent + 1 < n_agents; i_agent++) {
+      network.push_back_neighbour_and_weight(i_agent + 1, i_agent, 1.0);
+      if (i_agent % 2 == 0) {
+        network.push_back_neighbour_and_weight(i_agent, i_agent + 1, 1.0);
+      }
+    }
+  }
+
+  const auto partition_required =
+      as_partition(network.strongly_connected_components());
+
+  for (size_t n_threads : {1, 2, 4}) {
+    auto scc = network.strongly_connected_components(n_threads);
+    REQUIRE(scc.size() == partition_required.size());
+    REQUIRE(as_partition(scc) == partition_required);
+
+    // Ordered by the smallest vertex, with sorted vertices
+    bool ordered = true;
+    for (size_t i_scc = 0; i_scc < scc.size(); i_scc++) {
+      ordered &= std::is_sorted(scc[i_scc].begin(), scc[i_scc].end());
+      if (i_scc > 0) {
+        ordered &= scc[i_scc - 1][0] < scc[i_scc][0];
+      }
+    }
+    REQUIRE(ordered);
+  }
+}
+
+TEST_CASE("Repeated multi-threaded runs agree with Tarjan's algorithm",
+          "[sccParallelStress]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // Many cycles, linked by random edges from lower to higher cycles: trimming
+  // and the forward-backward step leave most of them to the colour
+  // propagation, where many threads update the same vertices concurrently
+  const size_t n_cycles = 400;
+  const size_t cycle_length = 50;
+  const size_t n_agents = n_cycles * cycle_length;
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+
+  auto network = DirectedNetwork<WeightT, uint32_t>(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    const size_t next = i_agent % cycle_length + 1 == cycle_length
+                            ? i_agent + 1 - cycle_length
+                            : i_agent + 1;
+    network.push_back_neighbour_and_weight(i_agent, next, 1.0);
+  }
+  for (size_t i_edge = 0; i_edge < 2 * n_agents; i_edge++) {
+    const size_t i = dist_agent(gen);
+    const size_t j = dist_agent(gen);
+    network.push_back_neighbour_and_weight(std::min(i, j), std::max(i, j),
+                                           1.0);
+  }
+
+  const auto partition_required =
+      as_partition(network.strongly_connected_components());
+  REQUIRE(partition_required.size() == n_cycles);
+  for (size_t n_threads : {2, 4, 8}) {
+    for (size_t run = 0; run < 20; run++) {
+      REQUIRE(as_partition(network.strongly_connected_components(
+                  n_threads)) == partition_required);
+    }
+  }
+}
+
+TEST_CASE("Strongly connected components with 32-bit indices",
+          "[sccIndexType]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_agents = 2000;
+  auto network = DirectedNetwork<WeightT>(n_agents);
+  auto network_32 = DirectedNetwork<WeightT, uint32_t>(n_agents);
+
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  for (size_t i_edge = 0; i_edge < 2 * n_agents; i_edge++) {
+    const size_t i = dist_agent(gen);
+    const size_t j = dist_agent(gen);
+    network.push_back_neighbour_and_weight(i, j, 1.0);
+    network_32.push_back_neighbour_and_weight(i, j, 1.0);
+  }
+
+  const auto partition_required =
+      as_partition(network.strongly_connected_components());
+
+  // The index type is deduced from the network
+  auto tarjan_scc = TarjanConnectivityAlgo(network_32);
+  static_assert(
+      std::is_same_v<decltype(tarjan_scc), TarjanConnectivityAlgo<uint32_t>>);
+  REQUIRE(as_partition(tarjan_scc.scc_list.to_nested()) == partition_required);
+
+  auto parallel_scc = ParallelConnectivityAlgo(network_32, 2);
+  static_assert(std::is_same_v<decltype(parallel_scc),
+                               ParallelConnectivityAlgo<uint32_t>>);
+  REQUIRE(as_partition(parallel_scc.scc_list.to_nested()) ==
+          partition_required);
+
+  REQUIRE(as_partition(network_32.strongly_connected_components(2)) ==
+          partition_required);
+}
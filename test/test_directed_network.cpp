@@ -1,8 +1,15 @@
 #include "directed_network.hpp"
+#include "undirected_network.hpp"
+#include <algorithm>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_range_equals.hpp>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
 #include <set>
+#include <utility>
 #include <vector>
 
 TEST_CASE("Testing the directed network class") {
@@ -175,4 +182,239 @@ TEST_CASE("Testing the directed network class") {
                                 weights_no_double_counting[i_agent]));
     }
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Testing the parallel toggle_incoming_outgoing") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // Random network with repeated edges and self-loops
+  const size_t n_agents = 2000;
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  std::uniform_int_distribution<size_t> dist_degree(0, 20);
+  std::uniform_real_distribution<WeightT> dist_weight(0.0, 1.0);
+
+  std::vector<std::vector<size_t>> neighbour_list(n_agents);
+  std::vector<std::vector<WeightT>> weight_list(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    const size_t degree = dist_degree(gen);
+    for (size_t i_neighbour = 0; i_neighbour < degree; i_neighbour++) {
+      const size_t neighbour = dist_agent(gen);
+      neighbour_list[i_agent].push_back(neighbour);
+      weight_list[i_agent].push_back(dist_weight(gen));
+      if (i_neighbour % 5 == 0) {
+        neighbour_list[i_agent].push_back(neighbour);
+        weight_list[i_agent].push_back(dist_weight(gen));
+      }
+    }
+  }
+
+  // The transpose, as given by a sequential loop over the agents
+  std::vector<std::vector<size_t>> neighbour_list_transpose(n_agents);
+  std::vector<std::vector<WeightT>> weight_list_transpose(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    for (size_t i_neighbour = 0; i_neighbour < neighbour_list[i_agent].size();
+         i_neighbour++) {
+      const auto neighbour = neighbour_list[i_agent][i_neighbour];
+      neighbour_list_transpose[neighbour].push_back(i_agent);
+      weight_list_transpose[neighbour].push_back(
+          weight_list[i_agent][i_neighbour]);
+    }
+  }
+
+  for (size_t n_threads : {1, 2, 4}) {
+    auto network = DirectedNetwork<WeightT>(
+        std::vector<std::vector<size_t>>(neighbour_list),
+        std::vector<std::vector<WeightT>>(weight_list),
+        DirectedNetwork<WeightT>::EdgeDirection::Incoming);
+
+    SECTION("Order preserving") {
+      network.toggle_incoming_outgoing(n_threads);
+      REQUIRE(network.direction() ==
+              DirectedNetwork<WeightT>::EdgeDirection::Outgoing);
+      bool identical = true;
+      for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+        identical &= std::ranges::equal(network.get_neighbours(i_agent),
+                                        neighbour_list_transpose[i_agent]);
+        identical &= std::ranges::equal(network.get_weights(i_agent),
+                                        weight_list_transpose[i_agent]);
+      }
+      REQUIRE(identical);
+
+      // Transposing again gives the original network, with every row
+      // (stably) sorted by the neighbour index
+      network.transpose(n_threads);
+      REQUIRE(network.direction() ==
+              DirectedNetwork<WeightT>::EdgeDirection::Outgoing);
+      for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+        auto edges = std::vector<std::pair<size_t, WeightT>>{};
+        for (size_t i = 0; i < neighbour_list[i_agent].size(); i++) {
+          edges.push_back(
+              {neighbour_list[i_agent][i], weight_list[i_agent][i]});
+        }
+        std::ranges::stable_sort(edges, {}, &std::pair<size_t, WeightT>::first);
+        for (size_t i = 0; i < edges.size(); i++) {
+          identical &= network.get_neighbours(i_agent)[i] == edges[i].first;
+          identical &= network.get_weights(i_agent)[i] == edges[i].second;
+        }
+      }
+      REQUIRE(identical);
+    }
+
+    SECTION("Without preserving the order") {
+      network.toggle_incoming_outgoing(n_threads, false);
+      bool same_edges = true;
+      for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+        auto edges = std::multiset<std::pair<size_t, WeightT>>{};
+        auto edges_required = std::multiset<std::pair<size_t, WeightT>>{};
+        for (size_t i = 0; i < network.n_edges(i_agent); i++) {
+          edges.insert({network.get_neighbours(i_agent)[i],
+                        network.get_weights(i_agent)[i]});
+        }
+        for (size_t i = 0; i < neighbour_list_transpose[i_agent].size(); i++) {
+          edges_required.insert({neighbour_list_transpose[i_agent][i],
+                                 weight_list_transpose[i_agent][i]});
+        }
+        same_edges &= edges == edges_required;
+      }
+      REQUIRE(same_edges);
+    }
+  }
+}
+
+TEST_CASE("Testing the parallel remove_double_counting") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // Random edges, many of them repeated. The weights are integers, so that the
+  // sums do not depend on the order of summation
+  const size_t n_agents = 1000;
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  std::uniform_int_distribution<int> dist_weight(1, 10);
+
+  auto directed = DirectedNetwork<WeightT>(n_agents);
+  auto undirected = UndirectedNetwork<WeightT, uint32_t>(n_agents);
+  std::map<std::pair<size_t, size_t>, WeightT> directed_required{};
+  std::map<std::pair<size_t, size_t>, WeightT> undirected_required{};
+  for (size_t i_edge = 0; i_edge < 20 * n_agents; i_edge++) {
+    // Edges between few agents are repeated often
+    const size_t i = dist_agent(gen) % (i_edge % 2 == 0 ? n_agents : 50);
+    const size_t j = dist_agent(gen) % (i_edge % 2 == 0 ? n_agents : 50);
+    const WeightT w = dist_weight(gen);
+    directed.push_back_neighbour_and_weight(i, j, w);
+    undirected.push_back_neighbour_and_weight(i, j, w);
+    directed_required[{i, j}] += w;
+    undirected_required[{i, j}] += w;
+    undirected_required[{j, i}] += w;
+  }
+
+  auto matches = [&](const auto &network, const auto &edges_required) {
+    std::map<std::pair<size_t, size_t>, WeightT> edges{};
+    bool sorted = true;
+    for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+      const auto neighbours = network.get_neighbours(i_agent);
+      const auto weights = network.get_weights(i_agent);
+      sorted &= std::ranges::adjacent_find(neighbours, std::greater_equal{}) ==
+                neighbours.end();
+      for (size_t i = 0; i < neighbours.size(); i++) {
+        edges[{i_agent, neighbours[i]}] = weights[i];
+      }
+    }
+    return sorted && edges == edges_required;
+  };
+
+  for (size_t n_threads : {1, 2, 4}) {
+    auto directed_copy = directed;
+    auto undirected_copy = undirected;
+    directed_copy.remove_double_counting(n_threads);
+    undirected_copy.remove_double_counting(n_threads);
+    REQUIRE(matches(directed_copy, directed_required));
+    REQUIRE(matches(undirected_copy, undirected_required));
+  }
+}
+
+TEST_CASE("Testing the sorted adjacency mode and the hash index") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // A few hubs with many neighbours among agents with few neighbours
+  const size_t n_agents = 2000;
+  const size_t n_hubs = 5;
+  std::mt19937 gen(13);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  auto network = DirectedNetwork<WeightT, uint32_t>(n_agents);
+  std::set<std::pair<size_t, size_t>> edges{};
+  auto add_random_edges = [&](size_t n_edges) {
+    for (size_t i_edge = 0; i_edge < n_edges; i_edge++) {
+      const size_t i = i_edge % 2 == 0 ? dist_agent(gen) % n_hubs
+                                       : dist_agent(gen);
+      const size_t j = dist_agent(gen);
+      network.push_back_neighbour_and_weight(i, j, WeightT(j));
+      edges.insert({i, j});
+    }
+  };
+
+  auto lookups_correct = [&]() {
+    bool correct = true;
+    for (size_t i_query = 0; i_query < 20000; i_query++) {
+      const size_t i = i_query % 2 == 0 ? i_query % n_hubs : dist_agent(gen);
+      const size_t j = dist_agent(gen);
+      const bool exists = edges.contains({i, j});
+      correct &= network.connection_exists(i, j) == exists;
+      const auto position = network.find_neighbour(i, j);
+      correct &= position.has_value() == exists;
+      if (position.has_value()) {
+        correct &= network.get_neighbours(i)[position.value()] == j;
+        correct &= network.get_weights(i)[position.value()] == WeightT(j);
+      }
+    }
+    return correct;
+  };
+
+  add_random_edges(4 * n_agents);
+  REQUIRE(lookups_correct());
+
+  network.set_sorted_adjacency(true);
+  REQUIRE(network.has_sorted_adjacency());
+  add_random_edges(4 * n_agents);
+  bool sorted = true;
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    sorted &= std::ranges::is_sorted(network.get_neighbours(i_agent));
+  }
+  REQUIRE(sorted);
+  REQUIRE(lookups_correct());
+
+  // Only the hubs get a hash index; it is kept up to date by new edges, by
+  // changed rows and by the transpose
+  network.set_hash_index(100);
+  add_random_edges(4 * n_agents);
+  REQUIRE(lookups_correct());
+
+  const std::vector<uint32_t> new_neighbours = {7, 3, 5};
+  network.set_neighbours_and_weights(0, new_neighbours, 1.0);
+  std::erase_if(edges, [](const auto &edge) { return edge.first == 0; });
+  edges.insert({{0, 3}, {0, 5}, {0, 7}});
+  REQUIRE_THAT(network.get_neighbours(0),
+               Catch::Matchers::RangeEquals(std::vector<uint32_t>{3, 5, 7}));
+  REQUIRE(network.connection_exists(0, 5));
+  REQUIRE(!network.connection_exists(0, 4));
+
+  network.toggle_incoming_outgoing(2, false);
+  network.set_hash_index(10, 2);
+  std::set<std::pair<size_t, size_t>> edges_transpose{};
+  for (const auto &[i, j] : edges) {
+    edges_transpose.insert({j, i});
+  }
+  edges = edges_transpose;
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    sorted &= std::ranges::is_sorted(network.get_neighbours(i_agent));
+  }
+  REQUIRE(sorted);
+  bool correct = true;
+  for (const auto &[i, j] : edges) {
+    correct &= network.connection_exists(i, j);
+  }
+  REQUIRE(correct);
+}
@@ -0,0 +1,243 @@
+#include "compressed_network.hpp"
+#include "connectivity.hpp"
+#include "directed_network.hpp"
+#include "dynamic_network.hpp"
+#include "network_operations.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// The (neighbour, weight) pairs of a row, sorted by neighbour
+template <typename NetworkT>
+std::vector<std::pair<size_t, double>> sorted_row(const NetworkT &network,
+                                                  size_t i_agent) {
+  std::vector<std::pair<size_t, double>> row{};
+  const auto neighbours = network.get_neighbours(i_agent);
+  const auto weights = network.get_weights(i_agent);
+  auto weight = weights.begin();
+  for (size_t neighbour : neighbours) {
+    row.emplace_back(neighbour, *weight++);
+  }
+  std::sort(row.begin(), row.end());
+  return row;
+}
+
+TEST_CASE("Testing single changes of a DynamicNetwork") {
+  using namespace Graph;
+  using Network = DynamicNetwork<double, uint32_t>;
+
+  auto network = Network(
+      DirectedNetwork<double, uint32_t>(
+          std::vector<std::vector<uint32_t>>{{2, 1, 2}, {}, {0}, {}},
+          std::vector<std::vector<double>>{{0.5, 1.0, 0.25}, {}, {3.0}, {}},
+          DirectedNetwork<double, uint32_t>::EdgeDirection::Outgoing),
+      2);
+  // Repeated edges are merged into one, and the rows are sorted
+  network.set_compaction_threshold(100);
+  REQUIRE(network.n_edges() == 3);
+  REQUIRE_THAT(network.get_neighbours(0),
+               Catch::Matchers::RangeEquals(std::vector<uint32_t>{1, 2}));
+  REQUIRE_THAT(network.get_weights(0),
+               Catch::Matchers::RangeEquals(std::vector<double>{1.0, 0.75}));
+
+  // New edges go to the delta buffer and are seen right away
+  REQUIRE(network.insert_edge(0, 3, 2.0));
+  REQUIRE(network.insert_edge(1, 0, 4.0));
+  REQUIRE_THAT(network.get_neighbours(0),
+               Catch::Matchers::RangeEquals(std::vector<uint32_t>{1, 2, 3}));
+  REQUIRE(network.n_edges(1) == 1);
+  REQUIRE(network.n_pending_changes() == 2);
+
+  // Existing edges get a new weight
+  REQUIRE(!network.insert_edge(0, 2, 5.0));
+  REQUIRE(!network.insert_edge(0, 3, 6.0));
+  REQUIRE(network.find_edge_weight(0, 2) == 5.0);
+  REQUIRE(network.find_edge_weight(0, 3) == 6.0);
+  REQUIRE(network.n_pending_changes() == 2);
+
+  // Removed compacted edges are taken out of their row, which leaves a free
+  // slot
+  REQUIRE(network.remove_edge(0, 1));
+  REQUIRE(!network.remove_edge(0, 1));
+  REQUIRE(!network.remove_edge(3, 0));
+  REQUIRE_THAT(network.get_neighbours(0),
+               Catch::Matchers::RangeEquals(std::vector<uint32_t>{2, 3}));
+  REQUIRE_THAT(network.get_weights(0),
+               Catch::Matchers::RangeEquals(std::vector<double>{5.0, 6.0}));
+  REQUIRE(network.get_neighbours(0)[1] == 3);
+  REQUIRE(!network.connection_exists(0, 1));
+  REQUIRE(network.n_edges() == 4);
+  REQUIRE(network.n_pending_changes() == 3);
+
+  // Inserting it again fills the free slot; removing an inserted edge takes
+  // it out of the delta buffer
+  REQUIRE(network.insert_edge(0, 1, 7.0));
+  REQUIRE(network.remove_edge(1, 0));
+  REQUIRE(network.n_edges(1) == 0);
+  REQUIRE(network.n_pending_changes() == 1);
+
+  REQUIRE_THROWS_AS(network.insert_edge(0, 4, 1.0), std::runtime_error);
+  REQUIRE_THROWS_AS(network.remove_edge(4, 0), std::runtime_error);
+
+  // Compacting merges the changes into sorted rows
+  network.compact();
+  REQUIRE(network.n_pending_changes() == 0);
+  REQUIRE(network.n_edges() == 4);
+  REQUIRE_THAT(network.get_neighbours(0),
+               Catch::Matchers::RangeEquals(std::vector<uint32_t>{1, 2, 3}));
+  REQUIRE_THAT(network.get_weights(0), Catch::Matchers::RangeEquals(
+                                           std::vector<double>{7.0, 5.0, 6.0}));
+  const auto compressed = network.to_compressed_network();
+  REQUIRE(compressed.n_edges() == 4);
+  REQUIRE(compressed.get_neighbours(2)[0] == 0);
+}
+
+TEST_CASE("Testing batches of changes against a reference") {
+  using namespace Graph;
+  using Network = DynamicNetwork<double, uint32_t>;
+  using Edge = Network::Edge;
+
+  const size_t n_agents = 300;
+  for (double threshold : {0.0, 0.05, 1e9}) {
+    for (size_t n_threads : {1, 3}) {
+      auto network = Network(n_agents);
+      network.set_compaction_threshold(threshold);
+      std::vector<std::map<size_t, double>> reference(n_agents);
+      std::mt19937 gen(7);
+      std::uniform_int_distribution<uint32_t> dist_agent(0, n_agents - 1);
+      std::uniform_real_distribution<double> dist_weight(0.0, 1.0);
+
+      for (size_t step = 0; step < 40; step++) {
+        std::vector<Edge> inserted(200);
+        size_t n_new = 0;
+        for (auto &edge : inserted) {
+          edge = {dist_agent(gen), dist_agent(gen), dist_weight(gen)};
+          n_new += reference[edge.source].count(edge.target) == 0;
+          reference[edge.source][edge.target] = edge.weight;
+        }
+        // Removes half of the edges just inserted, and random other ones
+        std::vector<Edge> removed{};
+        for (size_t i = 0; i < 100; i++) {
+          removed.push_back(i % 2 == 0 ? inserted[i]
+                                       : Edge{dist_agent(gen),
+                                              dist_agent(gen), 0.0});
+        }
+
+        REQUIRE(network.insert_edges(inserted, n_threads) == n_new);
+        size_t n_removed = 0;
+        for (const auto &edge : removed) {
+          n_removed += reference[edge.source].erase(edge.target);
+        }
+        REQUIRE(network.remove_edges(removed, n_threads) == n_removed);
+
+        size_t n_edges = 0;
+        for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+          const auto row = sorted_row(network, i_agent);
+          REQUIRE(row == std::vector<std::pair<size_t, double>>(
+                             reference[i_agent].begin(),
+                             reference[i_agent].end()));
+          REQUIRE(network.n_edges(i_agent) == row.size());
+          n_edges += row.size();
+        }
+        REQUIRE(network.n_edges() == n_edges);
+        if (threshold == 0.0) {
+          REQUIRE(network.n_pending_changes() == 0);
+        }
+      }
+
+      // Compacting gives sorted rows
+      network.compact(n_threads);
+      for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+        const auto neighbours = network.get_neighbours(i_agent);
+        REQUIRE(std::is_sorted(neighbours.begin(), neighbours.end()));
+        REQUIRE(sorted_row(network, i_agent).size() ==
+                reference[i_agent].size());
+      }
+    }
+  }
+
+  SECTION("The last change of a repeated edge in a batch wins") {
+    auto network = Network(3);
+    const auto batch =
+        std::vector<Edge>{{0, 1, 1.0}, {2, 1, 2.0}, {0, 1, 3.0}, {0, 2, 4.0}};
+    REQUIRE(network.insert_edges(batch) == 3);
+    REQUIRE(network.find_edge_weight(0, 1) == 3.0);
+    REQUIRE_THROWS_AS(network.insert_edges(std::vector<Edge>{{0, 3, 1.0}}),
+                      std::runtime_error);
+  }
+}
+
+TEST_CASE("Testing algorithms on the rows of a DynamicNetwork") {
+  using namespace Graph;
+  using Network = DynamicNetwork<double, uint32_t>;
+
+  // A ring 0 -> 1 -> ... -> 9 -> 0, cut open and closed again elsewhere
+  auto network = Network(10);
+  network.set_compaction_threshold(100);
+  for (uint32_t i_agent = 0; i_agent < 10; i_agent++) {
+    network.insert_edge(i_agent, (i_agent + 1) % 10, 1.0);
+  }
+  network.compact();
+  network.remove_edge(4, 5);
+  network.insert_edge(4, 0, 1.0);
+  network.insert_edge(7, 5, 1.0);
+
+  auto components = TarjanConnectivityAlgo<uint32_t>(network).scc_list;
+  REQUIRE(components.size() == 4);
+
+  std::vector<std::vector<uint32_t>> parent(10);
+  std::vector<uint32_t> depth_level(10, invalid_index<uint32_t>);
+  bfs(network, parent, depth_level, 0, std::nullopt);
+  REQUIRE_THAT(depth_level, Catch::Matchers::RangeEquals(std::vector<uint32_t>{
+                                0, 1, 2, 3, 4, invalid_index<uint32_t>,
+                                invalid_index<uint32_t>,
+                                invalid_index<uint32_t>,
+                                invalid_index<uint32_t>,
+                                invalid_index<uint32_t>}));
+
+  const auto compressed = network.to_compressed_network();
+  REQUIRE(compressed.strongly_connected_components().size() == 4);
+
+  SECTION("A star with a removed edge and many inserted ones") {
+    // Tarjan's algorithm indexes the rows, which stays constant time with
+    // pending changes in the row of the hub
+    const uint32_t n_agents = 100000;
+    auto star = Network(n_agents);
+    std::vector<Network::Edge> edges{};
+    for (uint32_t i_agent = 1; i_agent < n_agents; i_agent++) {
+      edges.push_back({0, i_agent, 1.0});
+      edges.push_back({i_agent, 0, 1.0});
+    }
+    star.insert_edges(edges);
+    star.compact();
+    star.set_compaction_threshold(100);
+    REQUIRE(star.remove_edge(0, 1));
+    REQUIRE(star.remove_edge(0, 3));
+    REQUIRE(star.get_neighbours(0)[1] == 4);
+    REQUIRE(
+        TarjanConnectivityAlgo<uint32_t>(star).scc_list.size() == 3);
+
+    // A delta buffer of many entries in one row, inserted backwards
+    for (uint32_t i_agent = n_agents; i_agent-- > 2;) {
+      star.insert_edge(1, i_agent, 2.0);
+    }
+    REQUIRE(star.n_edges(1) == n_agents - 1);
+    REQUIRE(star.get_neighbours(1)[0] == 0);
+    const auto row = sorted_row(star, 1);
+    for (uint32_t i_agent = 2; i_agent < n_agents; i_agent++) {
+      REQUIRE(row[i_agent - 1] == std::pair<size_t, double>{i_agent, 2.0});
+    }
+    REQUIRE(star.remove_edge(1, 77));
+    REQUIRE(!star.connection_exists(1, 77));
+    REQUIRE(star.find_edge_weight(1, n_agents - 1) == 2.0);
+    REQUIRE(TarjanConnectivityAlgo<uint32_t>(star).scc_list.size() == 3);
+  }
+}
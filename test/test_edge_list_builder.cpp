@@ -0,0 +1,132 @@
+#include "compressed_network.hpp"
+#include "directed_network.hpp"
+#include "edge_list_builder.hpp"
+#include "undirected_network.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Checks that two networks store the same rows
+template <typename NetworkT1, typename NetworkT2>
+bool same_rows(const NetworkT1 &network_1, const NetworkT2 &network_2) {
+  bool same = network_1.n_agents() == network_2.n_agents();
+  for (size_t i_agent = 0; same && i_agent < network_1.n_agents(); i_agent++) {
+    same &= std::ranges::equal(network_1.get_neighbours(i_agent),
+                               network_2.get_neighbours(i_agent));
+    same &= std::ranges::equal(network_1.get_weights(i_agent),
+                               network_2.get_weights(i_agent));
+  }
+  return same;
+}
+
+TEST_CASE("Testing the weight merge policies of the edge list builder") {
+  using namespace Graph;
+  using WeightT = double;
+  using Edge = EdgeListBuilder<WeightT>::Edge;
+  using EdgeDirection = DirectedNetwork<WeightT>::EdgeDirection;
+
+  auto builder = EdgeListBuilder<WeightT>();
+  const std::vector<Edge> edges = {
+      {2, 0, 1.0}, {0, 1, 4.0}, {2, 0, 3.0}, {0, 1, 2.0}, {1, 1, 5.0}};
+  builder.add_edges(edges);
+  REQUIRE(builder.n_agents() == 3);
+  REQUIRE(builder.n_edges() == 5);
+
+  for (size_t n_threads : {1, 4}) {
+    auto sum = builder.build_directed(WeightMerge::Sum,
+                                      EdgeDirection::Outgoing, n_threads);
+    REQUIRE_THAT(sum.get_weights(0),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{6.0}));
+    REQUIRE_THAT(sum.get_weights(2),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{4.0}));
+
+    auto max = builder.build_directed(WeightMerge::Max,
+                                      EdgeDirection::Outgoing, n_threads);
+    REQUIRE_THAT(max.get_weights(0),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{4.0}));
+    REQUIRE_THAT(max.get_weights(2),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{3.0}));
+
+    auto last = builder.build_directed(WeightMerge::Last,
+                                       EdgeDirection::Incoming, n_threads);
+    REQUIRE(last.direction() == EdgeDirection::Incoming);
+    REQUIRE_THAT(last.get_neighbours(0),
+                 Catch::Matchers::RangeEquals(std::vector<size_t>{2}));
+    REQUIRE_THAT(last.get_weights(0),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{3.0}));
+    REQUIRE_THAT(last.get_neighbours(1),
+                 Catch::Matchers::RangeEquals(std::vector<size_t>{0, 1}));
+    REQUIRE_THAT(last.get_weights(1),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{2.0, 5.0}));
+  }
+
+  REQUIRE_THROWS_AS(builder.add_edges(std::vector<size_t>{0, 1},
+                                      std::vector<size_t>{1},
+                                      std::vector<WeightT>{1.0, 1.0}),
+                    std::runtime_error);
+}
+
+TEST_CASE("Edge list builder gives the same networks as push_back") {
+  using namespace Graph;
+  using WeightT = double;
+  using EdgeDirection = DirectedNetwork<WeightT, uint32_t>::EdgeDirection;
+
+  // Random edges with many repetitions and self-loops. The weights are
+  // integers, so that the sums do not depend on the order of summation
+  const size_t n_agents = 3000;
+  std::mt19937 gen(17);
+  std::uniform_int_distribution<uint32_t> dist_agent(0, n_agents - 1);
+  std::uniform_int_distribution<int> dist_weight(1, 10);
+
+  auto directed = DirectedNetwork<WeightT, uint32_t>(n_agents);
+  auto undirected = UndirectedNetwork<WeightT, uint32_t>(n_agents);
+  std::vector<uint32_t> sources{};
+  std::vector<uint32_t> targets{};
+  std::vector<WeightT> weights{};
+  for (size_t i_edge = 0; i_edge < 10 * n_agents; i_edge++) {
+    const uint32_t i = dist_agent(gen) % (i_edge % 2 == 0 ? n_agents : 100);
+    const uint32_t j = dist_agent(gen) % (i_edge % 2 == 0 ? n_agents : 100);
+    const WeightT w = dist_weight(gen);
+    sources.push_back(i);
+    targets.push_back(j);
+    weights.push_back(w);
+    directed.push_back_neighbour_and_weight(i, j, w);
+    undirected.push_back_neighbour_and_weight(i, j, w);
+  }
+  directed.remove_double_counting();
+  undirected.remove_double_counting();
+
+  auto builder = EdgeListBuilder<WeightT, uint32_t>(n_agents);
+  builder.add_edges(sources, targets, weights);
+
+  for (size_t n_threads : {1, 2, 4}) {
+    const auto built_directed =
+        builder.build_directed(WeightMerge::Sum, EdgeDirection::Outgoing,
+                               n_threads);
+    REQUIRE(same_rows(built_directed, directed));
+
+    const auto built_undirected =
+        builder.build_undirected(WeightMerge::Sum, n_threads);
+    REQUIRE(same_rows(built_undirected, undirected));
+
+    REQUIRE(same_rows(builder.build_compressed_directed(
+                          WeightMerge::Sum, EdgeDirection::Outgoing, n_threads),
+                      directed));
+    REQUIRE(same_rows(builder.build_compressed_undirected(WeightMerge::Sum,
+                                                          n_threads),
+                      undirected));
+
+    // The incoming edges are the transpose
+    auto transpose = directed;
+    transpose.toggle_incoming_outgoing();
+    REQUIRE(same_rows(builder.build_directed(WeightMerge::Sum,
+                                             EdgeDirection::Incoming,
+                                             n_threads),
+                      transpose));
+  }
+}
@@ -0,0 +1,182 @@
+#include "directed_network.hpp"
+#include "edge_list_builder.hpp"
+#include "edge_list_reader.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A file with the given text in the temporary directory, which is removed at
+// the end of the test
+struct TemporaryTextFile {
+  std::string path;
+
+  TemporaryTextFile(const std::string &name, const std::string &text)
+      : path((std::filesystem::temp_directory_path() / name).string()) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+  }
+
+  ~TemporaryTextFile() { std::filesystem::remove(path); }
+};
+
+// Checks that two networks store the same rows
+template <typename NetworkT1, typename NetworkT2>
+bool same_rows(const NetworkT1 &network_1, const NetworkT2 &network_2) {
+  bool same = network_1.n_agents() == network_2.n_agents();
+  for (size_t i_agent = 0; same && i_agent < network_1.n_agents(); i_agent++) {
+    same &= std::ranges::equal(network_1.get_neighbours(i_agent),
+                               network_2.get_neighbours(i_agent));
+    same &= std::ranges::equal(network_1.get_weights(i_agent),
+                               network_2.get_weights(i_agent));
+  }
+  return same;
+}
+
+TEST_CASE("Reading edge lists in different text formats") {
+  using namespace Graph;
+  using WeightT = double;
+  using EdgeDirection = DirectedNetwork<WeightT>::EdgeDirection;
+
+  // Whitespace, CSV, CRLF line ends, comments, missing weights, and no newline
+  // at the end of the file
+  const auto file = TemporaryTextFile(
+      "graph_lib_test_reader_formats.txt",
+      "source,target,weight\n"
+      "# a comment\n"
+      "0 1 0.5\n"
+      "\n"
+      "2,0,1.5e-1\r\n"
+      "  1\t2\n"
+      "% another comment\n"
+      "2;0;0.35\n"
+      "3 3 2");
+
+  auto builder = EdgeListBuilder<WeightT>();
+  builder.add_edge(0, 1, 0.5);
+  builder.add_edge(2, 0, 0.15);
+  builder.add_edge(1, 2, 4.0);
+  builder.add_edge(2, 0, 0.35);
+  builder.add_edge(3, 3, 2.0);
+
+  // Chunks of a few bytes split most of the lines
+  for (size_t chunk_bytes : {size_t(5), size_t(16), size_t(1) << 20}) {
+    for (size_t n_threads : {1, 3}) {
+      auto options = EdgeListReadOptions<WeightT>{};
+      options.default_weight = 4.0;
+      options.n_header_lines = 1;
+      options.chunk_bytes = chunk_bytes;
+      options.n_threads = n_threads;
+      auto reader = EdgeListReader<WeightT>(options);
+      reader.read(file.path);
+
+      REQUIRE(reader.builder().n_edges() == 5);
+      REQUIRE(same_rows(reader.build_directed(),
+                        builder.build_directed(WeightMerge::Sum,
+                                               EdgeDirection::Outgoing, 1)));
+      REQUIRE(same_rows(reader.build_directed(WeightMerge::Last,
+                                              EdgeDirection::Incoming),
+                        builder.build_directed(WeightMerge::Last,
+                                               EdgeDirection::Incoming, 1)));
+      REQUIRE(same_rows(reader.build_undirected(),
+                        builder.build_undirected(WeightMerge::Sum, 1)));
+    }
+  }
+}
+
+TEST_CASE("Reading a large edge list in parallel chunks") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // Integer weights, so that the sums do not depend on the order
+  const size_t n_agents = 5000;
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<uint32_t> dist_agent(0, n_agents - 1);
+  std::uniform_int_distribution<int> dist_weight(1, 10);
+  auto builder = EdgeListBuilder<WeightT, uint32_t>();
+  std::string text{};
+  for (size_t i_edge = 0; i_edge < 20 * n_agents; i_edge++) {
+    const uint32_t i = dist_agent(gen);
+    const uint32_t j = dist_agent(gen);
+    const int w = dist_weight(gen);
+    builder.add_edge(i, j, w);
+    text += std::to_string(i) + " " + std::to_string(j) + " " +
+            std::to_string(w) + "\n";
+  }
+  const auto file = TemporaryTextFile("graph_lib_test_reader_large.txt", text);
+  const auto expected = builder.build_compressed_directed();
+
+  for (size_t n_threads : {1, 2, 4}) {
+    auto options = EdgeListReadOptions<WeightT>{};
+    options.chunk_bytes = 100000;
+    options.n_threads = n_threads;
+    auto reader = EdgeListReader<WeightT, uint32_t>(options);
+    reader.read(file.path);
+    REQUIRE(reader.builder().n_edges() == builder.n_edges());
+    REQUIRE(same_rows(reader.build_compressed_directed(), expected));
+  }
+}
+
+TEST_CASE("Remapping node IDs while reading edge lists") {
+  using namespace Graph;
+  using WeightT = float;
+
+  const auto file_1 = TemporaryTextFile("graph_lib_test_reader_ids_1.txt",
+                                        "1000000000000 42\n"
+                                        "42 7\n");
+  const auto file_2 = TemporaryTextFile("graph_lib_test_reader_ids_2.txt",
+                                        "7 1000000000000 2.5\n");
+
+  auto options = EdgeListReadOptions<WeightT>{};
+  options.remap_ids = true;
+  auto reader = EdgeListReader<WeightT, uint32_t>(options);
+  reader.read(file_1.path);
+  reader.read(file_2.path);
+
+  REQUIRE_THAT(reader.node_ids(),
+               Catch::Matchers::RangeEquals(
+                   std::vector<std::uint64_t>{1000000000000, 42, 7}));
+  auto network = reader.build_directed();
+  REQUIRE(network.n_agents() == 3);
+  REQUIRE_THAT(network.get_neighbours(0),
+               Catch::Matchers::RangeEquals(std::vector<uint32_t>{1}));
+  REQUIRE_THAT(network.get_neighbours(1),
+               Catch::Matchers::RangeEquals(std::vector<uint32_t>{2}));
+  REQUIRE_THAT(network.get_neighbours(2),
+               Catch::Matchers::RangeEquals(std::vector<uint32_t>{0}));
+  REQUIRE_THAT(network.get_weights(2),
+               Catch::Matchers::RangeEquals(std::vector<WeightT>{2.5f}));
+
+  SECTION("Without remapping, large IDs do not fit into 32-bit indices") {
+    auto reader_no_remap = EdgeListReader<WeightT, uint32_t>();
+    REQUIRE_THROWS_AS(reader_no_remap.read(file_1.path), std::runtime_error);
+  }
+}
+
+TEST_CASE("Errors while reading edge lists give the line") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const auto file = TemporaryTextFile("graph_lib_test_reader_errors.txt",
+                                      "0 1\n1 2\n# ok\n2 x\n3 4\n");
+  for (size_t chunk_bytes : {size_t(4), size_t(1) << 20}) {
+    auto options = EdgeListReadOptions<WeightT>{};
+    options.chunk_bytes = chunk_bytes;
+    auto reader = EdgeListReader<WeightT>(options);
+    try {
+      reader.read(file.path);
+      FAIL("No exception");
+    } catch (const std::runtime_error &error) {
+      REQUIRE(std::string(error.what()).find("line 4") != std::string::npos);
+    }
+  }
+
+  auto reader = EdgeListReader<WeightT>();
+  REQUIRE_THROWS_AS(reader.read(file.path + ".missing"), std::runtime_error);
+}
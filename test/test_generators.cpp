@@ -0,0 +1,249 @@
+#include "generators.hpp"
+#include "network_generation.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Checks that every row is sorted, has no repeated neighbours and no
+// self-loops, and (if symmetric is set) that every edge is stored for both
+// of its agents
+template <typename NetworkT>
+bool is_simple(const NetworkT &network, bool symmetric) {
+  for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+    const auto neighbours = network.get_neighbours(i_agent);
+    if (std::adjacent_find(neighbours.begin(), neighbours.end(),
+                           [](auto a, auto b) { return a >= b; }) !=
+        neighbours.end()) {
+      return false;
+    }
+    for (size_t j_agent : neighbours) {
+      if (j_agent == i_agent ||
+          (symmetric && !std::ranges::binary_search(
+                            network.get_neighbours(j_agent), i_agent))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Checks that two networks have the same flat arrays
+template <typename NetworkT>
+bool same_network(const NetworkT &network_1, const NetworkT &network_2) {
+  return std::ranges::equal(network_1.get_offsets(),
+                            network_2.get_offsets()) &&
+         std::ranges::equal(network_1.get_all_neighbours(),
+                            network_2.get_all_neighbours()) &&
+         std::ranges::equal(network_1.get_all_weights(),
+                            network_2.get_all_weights());
+}
+
+TEST_CASE("Testing the counter-based random number generator") {
+  using namespace Graph;
+
+  auto rng_1 = CounterRng(7, 3);
+  auto rng_2 = CounterRng(7, 3);
+  auto rng_other_stream = CounterRng(7, 4);
+  auto rng_other_seed = CounterRng(8, 3);
+  size_t n_same_as_other = 0;
+  for (size_t i = 0; i < 1000; i++) {
+    const auto x = rng_1();
+    REQUIRE(x == rng_2());
+    n_same_as_other += (x == rng_other_stream()) + (x == rng_other_seed());
+  }
+  REQUIRE(n_same_as_other == 0);
+
+  // Uniform numbers in [0, 1) with the right mean, and integers in range
+  double sum = 0;
+  for (size_t i = 0; i < 100000; i++) {
+    const double u = rng_1.uniform();
+    REQUIRE((u >= 0 && u < 1));
+    sum += u;
+    REQUIRE(rng_1.below(13) < 13);
+  }
+  REQUIRE(std::abs(sum / 100000 - 0.5) < 0.01);
+}
+
+TEST_CASE("Testing the Erdos-Renyi generators") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_agents = 2000;
+  const double p = 0.01;
+  const auto directed =
+      generate_erdos_renyi_directed<WeightT>(n_agents, p, 5, 0.5, 1);
+  const auto undirected = generate_erdos_renyi_undirected<WeightT, uint32_t>(
+      n_agents, p, 5, 2.0, 1);
+
+  REQUIRE(directed.n_agents() == n_agents);
+  REQUIRE(is_simple(directed, false));
+  REQUIRE(is_simple(undirected, true));
+  REQUIRE(directed.get_all_weights()[0] == 0.5);
+
+  // The number of edges is within 5 standard deviations of the mean
+  const double n_pairs = double(n_agents) * (n_agents - 1);
+  REQUIRE(std::abs(directed.n_edges() - p * n_pairs) <
+          5 * std::sqrt(p * n_pairs));
+  REQUIRE(std::abs(undirected.n_edges() / 2.0 - p * n_pairs / 2) <
+          5 * std::sqrt(p * n_pairs / 2));
+
+  // The same seed gives the same network on any number of threads
+  for (size_t n_threads : {2, 4}) {
+    REQUIRE(same_network(
+        generate_erdos_renyi_directed<WeightT>(n_agents, p, 5, 0.5, n_threads),
+        directed));
+    REQUIRE(same_network(generate_erdos_renyi_undirected<WeightT, uint32_t>(
+                             n_agents, p, 5, 2.0, n_threads),
+                         undirected));
+  }
+  REQUIRE(!same_network(
+      generate_erdos_renyi_directed<WeightT>(n_agents, p, 6, 0.5), directed));
+
+  // p = 1 gives the complete network
+  const auto complete = generate_erdos_renyi_directed<WeightT>(50, 1.0);
+  REQUIRE(complete.n_edges() == 50 * 49);
+  REQUIRE(generate_erdos_renyi_undirected<WeightT>(50, 0.0).n_edges() == 0);
+}
+
+TEST_CASE("Testing the stochastic block model generator") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const std::vector<size_t> block_sizes = {30, 0, 20, 50};
+  const auto network = generate_stochastic_block_model<WeightT>(
+      block_sizes, {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0.1}, {0, 0, 0.1, 0}},
+      11);
+  REQUIRE(network.n_agents() == 100);
+  REQUIRE(is_simple(network, true));
+
+  // The first two non-empty blocks are cliques, the last one has no edges
+  // inside, and only the last two blocks are connected
+  for (size_t i_agent = 0; i_agent < 30; i_agent++) {
+    REQUIRE(network.n_edges(i_agent) == 29);
+  }
+  size_t n_between = 0;
+  for (size_t i_agent = 30; i_agent < 50; i_agent++) {
+    const auto neighbours = network.get_neighbours(i_agent);
+    REQUIRE(std::count_if(neighbours.begin(), neighbours.end(), [](auto j) {
+              return j >= 30 && j < 50;
+            }) == 19);
+    n_between += std::count_if(neighbours.begin(), neighbours.end(),
+                               [](auto j) { return j >= 50; });
+  }
+  REQUIRE(n_between > 0);
+  for (size_t i_agent = 50; i_agent < 100; i_agent++) {
+    for (auto j_agent : network.get_neighbours(i_agent)) {
+      REQUIRE((j_agent >= 30 && j_agent < 50));
+    }
+  }
+
+  REQUIRE(same_network(
+      generate_stochastic_block_model<WeightT>(
+          block_sizes,
+          {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0.1}, {0, 0, 0.1, 0}}, 11, 1,
+          3),
+      network));
+  REQUIRE_THROWS_AS(generate_stochastic_block_model<WeightT>(
+                        std::vector<size_t>{2, 2}, {{1, 0.5}, {0.1, 1}}),
+                    std::runtime_error);
+}
+
+TEST_CASE("Testing the Barabasi-Albert generator") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_agents = 20000;
+  const size_t n_links = 3;
+  const auto network =
+      generate_barabasi_albert<WeightT>(n_agents, n_links, 1, 1.0, 1);
+  REQUIRE(network.n_agents() == n_agents);
+  REQUIRE(is_simple(network, true));
+
+  // Every new agent has at least one edge, and at most n_links of its own
+  size_t max_degree = 0;
+  for (size_t i_agent = n_links; i_agent < n_agents; i_agent++) {
+    const auto neighbours = network.get_neighbours(i_agent);
+    const auto n_older = std::count_if(neighbours.begin(), neighbours.end(),
+                                       [&](auto j) { return j < i_agent; });
+    REQUIRE((n_older >= 1 && n_older <= long(n_links)));
+    max_degree = std::max(max_degree, neighbours.size());
+  }
+  // Almost no choices are repeated, and preferential attachment creates hubs
+  REQUIRE(network.n_edges() > 0.95 * 2 * n_links * (n_agents - n_links));
+  REQUIRE(max_degree > 100);
+
+  REQUIRE(same_network(
+      generate_barabasi_albert<WeightT>(n_agents, n_links, 1, 1.0, 4),
+      network));
+  REQUIRE_THROWS_AS(generate_barabasi_albert<WeightT>(3, 3),
+                    std::runtime_error);
+}
+
+TEST_CASE("Testing the Watts-Strogatz generator") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_agents = 1000;
+  const size_t n_neighbours = 6;
+
+  // Without rewiring, it is the ring lattice
+  const auto ring =
+      generate_watts_strogatz<WeightT>(n_agents, n_neighbours, 0.0, 2);
+  REQUIRE(is_simple(ring, true));
+  REQUIRE(ring.n_edges() == n_agents * n_neighbours);
+  REQUIRE_THAT(ring.get_neighbours(0),
+               Catch::Matchers::RangeEquals(
+                   std::vector<size_t>{1, 2, 3, 997, 998, 999}));
+
+  const auto rewired =
+      generate_watts_strogatz<WeightT>(n_agents, n_neighbours, 0.2, 2, 1.0, 1);
+  REQUIRE(is_simple(rewired, true));
+  REQUIRE(rewired.n_edges() > 0.99 * n_agents * n_neighbours);
+  size_t n_long_range = 0;
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    for (size_t j_agent : rewired.get_neighbours(i_agent)) {
+      const size_t distance =
+          std::min((j_agent + n_agents - i_agent) % n_agents,
+                   (i_agent + n_agents - j_agent) % n_agents);
+      n_long_range += distance > n_neighbours / 2;
+    }
+  }
+  // About 20% of the edges are rewired, each stored twice
+  REQUIRE(std::abs(n_long_range / 2.0 - 0.2 * n_agents * n_neighbours / 2) <
+          5 * std::sqrt(0.2 * 0.8 * n_agents * n_neighbours / 2));
+
+  REQUIRE(same_network(
+      generate_watts_strogatz<WeightT>(n_agents, n_neighbours, 0.2, 2, 1.0, 4),
+      rewired));
+  REQUIRE_THROWS_AS(generate_watts_strogatz<WeightT>(10, 3, 0.1),
+                    std::runtime_error);
+}
+
+TEST_CASE("Testing the periodic lattice generator") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_edge = 7;
+  const auto lattice = generate_periodic_lattice<WeightT>(n_edge, 0.5);
+  REQUIRE(is_simple(lattice, true));
+  REQUIRE(lattice.n_edges() == 4 * n_edge * n_edge);
+
+  // Same edges as the lattice of the test helpers
+  const auto expected =
+      UndirectedNetworkGeneration::generate_square_lattice<WeightT>(n_edge,
+                                                                    0.5);
+  for (size_t i_agent = 0; i_agent < lattice.n_agents(); i_agent++) {
+    auto neighbours_expected = std::vector<size_t>(
+        expected.get_neighbours(i_agent).begin(),
+        expected.get_neighbours(i_agent).end());
+    std::sort(neighbours_expected.begin(), neighbours_expected.end());
+    REQUIRE_THAT(lattice.get_neighbours(i_agent),
+                 Catch::Matchers::RangeEquals(neighbours_expected));
+  }
+  REQUIRE_THROWS_AS(generate_periodic_lattice<WeightT>(2), std::runtime_error);
+}
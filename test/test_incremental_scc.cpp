@@ -0,0 +1,210 @@
+#include "connectivity.hpp"
+#include "directed_network.hpp"
+#include "incremental_scc.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// The components as sorted lists of agents, sorted
+template <typename ComponentsT>
+std::vector<std::vector<uint32_t>> normalised(const ComponentsT &components) {
+  std::vector<std::vector<uint32_t>> result{};
+  for (const auto &component : components) {
+    result.emplace_back(component.begin(), component.end());
+    std::sort(result.back().begin(), result.back().end());
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+// Checks the components, the topological order and the condensation against
+// Tarjan's algorithm on the reference adjacency
+bool consistent(const Graph::IncrementalSCC<uint32_t> &scc,
+                const std::vector<std::vector<uint32_t>> &adjacency) {
+  const auto expected =
+      Graph::TarjanConnectivityAlgo<uint32_t>(adjacency).scc_list.to_nested();
+  const auto components = scc.strongly_connected_components();
+  if (normalised(components) != normalised(expected) ||
+      scc.n_components() != expected.size()) {
+    return false;
+  }
+
+  std::vector<size_t> position(adjacency.size());
+  const auto order = scc.topological_order();
+  for (size_t p = 0; p < order.size(); p++) {
+    position[order[p]] = p;
+  }
+  const auto condensation = scc.condensation();
+  for (size_t i_agent = 0; i_agent < adjacency.size(); i_agent++) {
+    const size_t label = scc.component(i_agent);
+    for (uint32_t j_agent : adjacency[i_agent]) {
+      const size_t j_label = scc.component(j_agent);
+      if (label == j_label) {
+        continue;
+      }
+      if (position[label] >= position[j_label] ||
+          !std::binary_search(condensation[label].begin(),
+                              condensation[label].end(), j_label)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+TEST_CASE("Testing single changes of the incremental SCCs") {
+  using namespace Graph;
+
+  // A path 0 -> 1 -> 2 -> 3 -> 4
+  auto scc = IncrementalSCC<uint32_t>(5);
+  for (uint32_t i_agent = 4; i_agent-- > 0;) {
+    REQUIRE(!scc.insert_edge(i_agent, i_agent + 1));
+  }
+  REQUIRE(scc.n_components() == 5);
+  REQUIRE_THAT(scc.topological_order(),
+               Catch::Matchers::RangeEquals(std::vector<uint32_t>{
+                   scc.component(0), scc.component(1), scc.component(2),
+                   scc.component(3), scc.component(4)}));
+
+  // Closing the cycle 1 -> 2 -> 3 -> 1 merges three components
+  REQUIRE(scc.insert_edge(3, 1));
+  REQUIRE(scc.n_components() == 3);
+  REQUIRE(scc.same_component(1, 3));
+  REQUIRE(!scc.same_component(0, 1));
+  REQUIRE(scc.component_members(scc.component(2)).size() == 3);
+  REQUIRE_THAT(scc.condensation_neighbours(scc.component(1)),
+               Catch::Matchers::RangeEquals(
+                   std::vector<uint32_t>{scc.component(4)}));
+  REQUIRE(!scc.insert_edge(2, 1));
+
+  // Removing an edge of a repeated pair keeps the cycle
+  REQUIRE(scc.remove_edge(2, 1));
+  REQUIRE(!scc.remove_edge(2, 1));
+  REQUIRE(scc.n_components() == 3);
+  // Removing 2 -> 3 splits it again, in the right order
+  REQUIRE(scc.remove_edge(2, 3));
+  REQUIRE(scc.n_components() == 5);
+  const auto order = scc.topological_order();
+  const auto position = [&](uint32_t i_agent) {
+    return std::find(order.begin(), order.end(), scc.component(i_agent)) -
+           order.begin();
+  };
+  REQUIRE(position(0) < position(1));
+  REQUIRE(position(3) < position(1));
+  REQUIRE(position(1) < position(2));
+
+  REQUIRE_THROWS_AS(scc.insert_edge(0, 5), std::runtime_error);
+  REQUIRE_THROWS_AS(scc.remove_edge(5, 0), std::runtime_error);
+}
+
+TEST_CASE("Testing batches of changes of the incremental SCCs") {
+  using namespace Graph;
+  using Edge = IncrementalSCC<uint32_t>::Edge;
+
+  const size_t n_agents = 200;
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<uint32_t> dist_agent(0, n_agents - 1);
+
+  // Starts from a sparse random network, whose components are found with
+  // Tarjan's algorithm
+  auto network = DirectedNetwork<double, uint32_t>(n_agents);
+  std::vector<std::vector<uint32_t>> adjacency(n_agents);
+  for (size_t i = 0; i < n_agents / 2; i++) {
+    const uint32_t source = dist_agent(gen);
+    const uint32_t target = dist_agent(gen);
+    network.push_back_neighbour_and_weight(source, target, 1.0);
+    adjacency[source].push_back(target);
+  }
+  auto scc = IncrementalSCC(network);
+  REQUIRE(consistent(scc, adjacency));
+
+  // The network gets denser and sparser again, so that components are both
+  // merged and split
+  for (size_t step = 0; step < 100; step++) {
+    const size_t n_inserted = step < 50 ? 10 : 2;
+    std::vector<Edge> inserted(n_inserted);
+    size_t n_merges = 0;
+    for (auto &edge : inserted) {
+      edge = {dist_agent(gen), dist_agent(gen)};
+      if (step % 2 == 0) {
+        adjacency[edge.source].push_back(edge.target);
+        n_merges += scc.insert_edge(edge.source, edge.target);
+        REQUIRE(consistent(scc, adjacency));
+      }
+    }
+    if (step % 2 == 1) {
+      const size_t n_before = scc.n_components();
+      n_merges = scc.insert_edges(inserted);
+      for (const auto &edge : inserted) {
+        adjacency[edge.source].push_back(edge.target);
+      }
+      REQUIRE(consistent(scc, adjacency));
+      REQUIRE((n_merges == 0) == (scc.n_components() == n_before));
+    }
+
+    // Removes random existing edges and edges which are not there
+    std::vector<Edge> removed{};
+    for (size_t i = 0; i < 6; i++) {
+      const uint32_t source = dist_agent(gen);
+      if (i % 3 != 0 && !adjacency[source].empty()) {
+        removed.push_back({source, adjacency[source][gen() % adjacency[source]
+                                                                 .size()]});
+      } else {
+        removed.push_back({source, dist_agent(gen)});
+      }
+    }
+    size_t n_removed = 0;
+    for (const auto &edge : removed) {
+      auto &row = adjacency[edge.source];
+      const auto it = std::find(row.begin(), row.end(), edge.target);
+      if (it != row.end()) {
+        row.erase(it);
+        n_removed++;
+      }
+    }
+    REQUIRE(scc.remove_edges(removed) == n_removed);
+    REQUIRE(consistent(scc, adjacency));
+  }
+
+  // Peeling the agents off a path with edges both ways, one at a time,
+  // puts every piece in the place of the rest, so that the keys there need
+  // to be spaced out again and again
+  const uint32_t n_path = 100;
+  auto path = IncrementalSCC<uint32_t>(n_path);
+  std::vector<std::vector<uint32_t>> path_adjacency(n_path);
+  for (uint32_t i_agent = 0; i_agent + 1 < n_path; i_agent++) {
+    path.insert_edge(i_agent, i_agent + 1);
+    path.insert_edge(i_agent + 1, i_agent);
+    path_adjacency[i_agent].push_back(i_agent + 1);
+    path_adjacency[i_agent + 1].push_back(i_agent);
+  }
+  REQUIRE(path.n_components() == 1);
+  for (uint32_t i_agent = 0; i_agent + 1 < n_path; i_agent++) {
+    REQUIRE(path.remove_edge(i_agent, i_agent + 1));
+    std::erase(path_adjacency[i_agent], i_agent + 1);
+    REQUIRE(path.n_components() == i_agent + 2);
+    REQUIRE(consistent(path, path_adjacency));
+  }
+
+  // A path built from its end, k -> k - 1: every agent moves in front of the
+  // previous one, into the same gap of keys, and the cycle which closes it
+  // merges everything
+  const uint32_t n_back = 2000;
+  auto back = IncrementalSCC<uint32_t>(n_back);
+  std::vector<std::vector<uint32_t>> back_adjacency(n_back);
+  for (uint32_t i_agent = 1; i_agent < n_back; i_agent++) {
+    REQUIRE(!back.insert_edge(i_agent, i_agent - 1));
+    back_adjacency[i_agent].push_back(i_agent - 1);
+    if (i_agent % 500 == 0) {
+      REQUIRE(consistent(back, back_adjacency));
+    }
+  }
+  REQUIRE(consistent(back, back_adjacency));
+  REQUIRE(back.insert_edge(0, n_back - 1));
+  REQUIRE(back.n_components() == 1);
+}
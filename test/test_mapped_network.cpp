@@ -0,0 +1,178 @@
+#include "bidirectional_network.hpp"
+#include "compressed_network.hpp"
+#include "directed_network.hpp"
+#include "mapped_network.hpp"
+#include "network_generation.hpp"
+#include "undirected_network.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A path in the temporary directory, which is removed at the end of the test
+struct TemporaryFile {
+  std::string path;
+
+  explicit TemporaryFile(const std::string &name)
+      : path((std::filesystem::temp_directory_path() / name).string()) {}
+
+  ~TemporaryFile() { std::filesystem::remove(path); }
+};
+
+// Checks that the mapped network stores the same rows as network
+template <typename MappedT, typename NetworkT>
+bool same_rows(const MappedT &mapped, const NetworkT &network) {
+  bool same = mapped.n_agents() == network.n_agents();
+  for (size_t i_agent = 0; same && i_agent < network.n_agents(); i_agent++) {
+    same &= std::ranges::equal(mapped.get_neighbours(i_agent),
+                               network.get_neighbours(i_agent));
+    same &= std::ranges::equal(mapped.get_weights(i_agent),
+                               network.get_weights(i_agent));
+  }
+  return same;
+}
+
+TEST_CASE("Writing and mapping a binary network file") {
+  using namespace Graph;
+  using WeightT = double;
+  using EdgeDirection = DirectedNetwork<WeightT>::EdgeDirection;
+  const auto file = TemporaryFile("graph_lib_test_mapped_network.bin");
+
+  auto network = DirectedNetwork<WeightT>(
+      std::vector<std::vector<size_t>>{{1, 2}, {1}, {0}, {}, {3, 0, 1}},
+      std::vector<std::vector<WeightT>>{
+          {0.5, 0.5}, {0.5}, {0.2}, {}, {0.1, 0.2, 0.3}},
+      EdgeDirection::Incoming);
+  write_binary_network(network, file.path);
+
+  auto mapped = MappedNetwork<WeightT>(file.path);
+  REQUIRE(mapped.direction() == StoredDirection::Incoming);
+  REQUIRE(mapped.n_agents() == network.n_agents());
+  REQUIRE(mapped.n_edges() == network.n_edges());
+  REQUIRE(same_rows(mapped, network));
+  REQUIRE_THAT(mapped.get_offsets(),
+               Catch::Matchers::RangeEquals(
+                   std::vector<std::uint64_t>{0, 2, 3, 4, 4, 7}));
+  REQUIRE(mapped.get_edge_weight(4, 2) == 0.3);
+  REQUIRE(mapped.connection_exists(4, 0));
+  REQUIRE(!mapped.connection_exists(3, 0));
+  REQUIRE_THAT(mapped.strongly_connected_components(),
+               Catch::Matchers::RangeEquals(
+                   network.strongly_connected_components()));
+
+  SECTION("The mapping moves with the network") {
+    auto moved = std::move(mapped);
+    REQUIRE(mapped.n_agents() == 0);
+    REQUIRE(same_rows(moved, network));
+  }
+
+  SECTION("Rewriting the file leaves existing mappings intact") {
+    network.toggle_incoming_outgoing();
+    write_binary_network(network, file.path);
+    auto remapped = MappedNetwork<WeightT>(file.path);
+    REQUIRE(remapped.direction() == StoredDirection::Outgoing);
+    REQUIRE(same_rows(remapped, network));
+    REQUIRE(mapped.get_edge_weight(4, 2) == 0.3);
+  }
+
+  SECTION("Mapping with other types or a damaged file throws") {
+    REQUIRE_THROWS_AS(MappedNetwork<float>(file.path), std::runtime_error);
+    REQUIRE_THROWS_AS((MappedNetwork<WeightT, std::uint32_t>(file.path)),
+                      std::runtime_error);
+    REQUIRE_THROWS_AS(MappedNetwork<WeightT>(file.path + ".missing"),
+                      std::runtime_error);
+
+    // Overwrites the value at position in a copy of the file
+    const auto copy = TemporaryFile("graph_lib_test_mapped_damaged.bin");
+    const auto damaged_copy = [&](std::uint64_t position, std::uint64_t value) {
+      std::filesystem::copy_file(
+          file.path, copy.path,
+          std::filesystem::copy_options::overwrite_existing);
+      std::fstream stream(copy.path,
+                          std::ios::in | std::ios::out | std::ios::binary);
+      stream.seekp(static_cast<std::streamoff>(position));
+      stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+    BinaryNetworkHeader header{};
+    std::ifstream(file.path, std::ios::binary)
+        .read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    // Sizes whose sections would overflow the layout arithmetic
+    damaged_copy(offsetof(BinaryNetworkHeader, n_agents),
+                 std::uint64_t(1) << 61);
+    REQUIRE_THROWS_AS(MappedNetwork<WeightT>(copy.path), std::runtime_error);
+    damaged_copy(offsetof(BinaryNetworkHeader, n_edges),
+                 std::uint64_t(1) << 62);
+    REQUIRE_THROWS_AS(MappedNetwork<WeightT>(copy.path), std::runtime_error);
+
+    // Offsets which decrease: {0, 2, 5, 4, 4, 7}. Without checking them, the
+    // file is trusted
+    damaged_copy(header.offsets_position + 2 * sizeof(std::uint64_t), 5);
+    REQUIRE_THROWS_AS(MappedNetwork<WeightT>(copy.path), std::runtime_error);
+    REQUIRE(MappedNetwork<WeightT>(copy.path, false).n_edges() == 7);
+
+    // A neighbour index past the last agent
+    damaged_copy(header.neighbours_position + 3 * sizeof(size_t), 5);
+    REQUIRE_THROWS_AS(MappedNetwork<WeightT>(copy.path), std::runtime_error);
+    REQUIRE(MappedNetwork<WeightT>(copy.path, false).get_neighbours(2)[0] ==
+            5);
+
+    // Cut off the last weight
+    const auto size = std::filesystem::file_size(file.path);
+    std::filesystem::resize_file(file.path, size - sizeof(WeightT));
+    REQUIRE_THROWS_AS(MappedNetwork<WeightT>(file.path), std::runtime_error);
+
+    // Not a network file at all
+    std::ofstream(file.path, std::ios::trunc) << "1 2 0.5\n2 3 0.5\n";
+    REQUIRE_THROWS_AS(MappedNetwork<WeightT>(file.path), std::runtime_error);
+  }
+}
+
+TEST_CASE("Binary network files of other network types") {
+  using namespace Graph;
+  using WeightT = float;
+  const auto file = TemporaryFile("graph_lib_test_mapped_types.bin");
+
+  SECTION("Undirected network with 32-bit indices") {
+    auto network = UndirectedNetwork<WeightT, std::uint32_t>(4);
+    network.push_back_neighbour_and_weight(0, 1, 1.0f);
+    network.push_back_neighbour_and_weight(1, 3, 2.0f);
+    network.push_back_neighbour_and_weight(2, 2, 3.0f);
+    write_binary_network(network, file.path);
+
+    auto mapped = MappedNetwork<WeightT, std::uint32_t>(file.path);
+    REQUIRE(mapped.direction() == StoredDirection::Undirected);
+    REQUIRE(same_rows(mapped, network));
+  }
+
+  SECTION("Bidirectional network, stored as its outgoing edges") {
+    auto network = BidirectionalNetwork<WeightT>(3);
+    network.push_back_neighbour_and_weight(0, 2, 1.0f);
+    network.push_back_neighbour_and_weight(2, 1, 2.0f);
+    write_binary_network(network, file.path);
+
+    auto mapped = MappedNetwork<WeightT>(file.path);
+    REQUIRE(mapped.direction() == StoredDirection::Outgoing);
+    REQUIRE(same_rows(mapped, network));
+  }
+
+  SECTION("Compressed network and a network without agents") {
+    auto lattice =
+        UndirectedNetworkGeneration::generate_square_lattice<WeightT>(5);
+    auto compressed = CompressedNetwork<WeightT>(lattice);
+    write_binary_network(compressed, file.path, StoredDirection::Undirected);
+    REQUIRE(same_rows(MappedNetwork<WeightT>(file.path), lattice));
+
+    write_binary_network(DirectedNetwork<WeightT>(), file.path);
+    auto empty = MappedNetwork<WeightT>(file.path);
+    REQUIRE(empty.n_agents() == 0);
+    REQUIRE(empty.n_edges() == 0);
+  }
+}
@@ -0,0 +1,227 @@
+#include "bidirectional_network.hpp"
+#include "compressed_network.hpp"
+#include "directed_network.hpp"
+#include "dynamic_network.hpp"
+#include "generators.hpp"
+#include "neighbour_aggregation.hpp"
+#include "network_generation.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Checks that two vectors agree up to rounding errors
+template <typename ValueT>
+bool approx_equal(const std::vector<ValueT> &a, const std::vector<ValueT> &b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (std::abs(a[i] - b[i]) > 1e-9 * (1 + std::abs(b[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The weighted neighbour sum written out as a loop over the rows of incoming
+// edges
+template <typename NetworkT>
+std::vector<double> sum_incoming(const NetworkT &network,
+                                 const std::vector<double> &x) {
+  std::vector<double> y(network.n_agents(), 0.0);
+  for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+    const auto neighbours = network.get_neighbours(i_agent);
+    const auto weights = network.get_weights(i_agent);
+    for (size_t k = 0; k < neighbours.size(); k++) {
+      y[i_agent] += weights[k] * x[neighbours[k]];
+    }
+  }
+  return y;
+}
+
+TEST_CASE("Testing the weighted neighbour sum on a small network") {
+  using namespace Graph;
+  using WeightT = double;
+
+  auto network = DirectedNetwork<WeightT>(
+      std::vector<std::vector<size_t>>{{1, 2}, {1}, {0}, {}, {3, 0, 1}},
+      std::vector<std::vector<WeightT>>{
+          {0.5, 0.5}, {0.5}, {0.2}, {}, {0.1, 0.2, 0.3}},
+      DirectedNetwork<WeightT>::EdgeDirection::Incoming);
+  const auto x = std::vector<double>{1.0, 2.0, 3.0, 4.0, 5.0};
+  const auto expected = std::vector<double>{2.5, 1.0, 0.2, 0.0, 1.2};
+
+  std::vector<double> y{};
+  aggregate_neighbours(network, x, y);
+  REQUIRE(approx_equal(y, expected));
+
+  // The outgoing edges give the same sums with the Scatter form
+  network.toggle_incoming_outgoing();
+  aggregate_neighbours(network, x, y);
+  REQUIRE(approx_equal(y, expected));
+  aggregate_neighbours(network, AggregationMode::Gather, x, y);
+  REQUIRE(approx_equal(y, std::vector<double>{1.6, 3.0, 0.5, 0.5, 0.0}));
+
+  SECTION("Both directions of a bidirectional network") {
+    auto bidirectional = BidirectionalNetwork<WeightT>(network);
+    aggregate_neighbours(bidirectional.in_view(), AggregationMode::Gather, x,
+                         y);
+    REQUIRE(approx_equal(y, expected));
+    aggregate_neighbours(bidirectional.out_view(), AggregationMode::Scatter,
+                         x, y);
+    REQUIRE(approx_equal(y, expected));
+  }
+
+  SECTION("Wrong sizes throw") {
+    REQUIRE_THROWS_AS(
+        aggregate_neighbours(network, std::vector<double>(4), y),
+        std::runtime_error);
+    auto x_copy = x;
+    REQUIRE_THROWS_AS(aggregate_neighbours(network, x_copy, x_copy),
+                      std::runtime_error);
+    REQUIRE_THROWS_AS(aggregate_neighbours_batch(network, x, y, 2),
+                      std::runtime_error);
+  }
+}
+
+TEST_CASE("Testing the weighted neighbour sum on larger networks") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // Random weights and values, and rows of all lengths (including the
+  // scale-free degrees of a Barabasi-Albert network)
+  const size_t n_agents = 20000;
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  auto x = std::vector<double>(n_agents);
+  for (auto &value : x) {
+    value = dist(gen);
+  }
+
+  auto compressed =
+      generate_barabasi_albert<WeightT, uint32_t>(n_agents, 5, 3, 1.0);
+  auto weights = std::vector<WeightT>(compressed.get_all_weights().begin(),
+                                      compressed.get_all_weights().end());
+  for (auto &weight : weights) {
+    weight = dist(gen);
+  }
+  compressed = CompressedNetwork<WeightT, uint32_t>(
+      std::vector<size_t>(compressed.get_offsets().begin(),
+                          compressed.get_offsets().end()),
+      std::vector<uint32_t>(compressed.get_all_neighbours().begin(),
+                            compressed.get_all_neighbours().end()),
+      std::move(weights));
+  const auto expected = sum_incoming(compressed, x);
+
+  // A DirectedNetwork with the same (incoming) rows, and its outgoing form
+  auto neighbour_list = std::vector<std::vector<size_t>>(n_agents);
+  auto weight_list = std::vector<std::vector<WeightT>>(n_agents);
+  for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+    neighbour_list[i_agent].assign(compressed.get_neighbours(i_agent).begin(),
+                                   compressed.get_neighbours(i_agent).end());
+    weight_list[i_agent].assign(compressed.get_weights(i_agent).begin(),
+                                compressed.get_weights(i_agent).end());
+  }
+  auto incoming = DirectedNetwork<WeightT>(
+      std::move(neighbour_list), std::move(weight_list),
+      DirectedNetwork<WeightT>::EdgeDirection::Incoming);
+  auto outgoing = incoming;
+  outgoing.toggle_incoming_outgoing();
+
+  std::vector<double> y{};
+  for (size_t n_threads : {1, 2, 3}) {
+    aggregate_neighbours(compressed, AggregationMode::Gather, x, y,
+                         n_threads);
+    REQUIRE(approx_equal(y, expected));
+    aggregate_neighbours(incoming, x, y, n_threads);
+    REQUIRE(approx_equal(y, expected));
+    aggregate_neighbours(outgoing, x, y, n_threads);
+    REQUIRE(approx_equal(y, expected));
+  }
+
+  SECTION("Several vectors at once") {
+    const size_t n_vectors = 3;
+    auto x_batch = std::vector<double>(n_agents * n_vectors);
+    auto expected_batch = x_batch;
+    for (size_t i_vector = 0; i_vector < n_vectors; i_vector++) {
+      auto x_single = std::vector<double>(n_agents);
+      for (auto &value : x_single) {
+        value = dist(gen);
+      }
+      const auto y_single = sum_incoming(compressed, x_single);
+      for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+        x_batch[i_agent * n_vectors + i_vector] = x_single[i_agent];
+        expected_batch[i_agent * n_vectors + i_vector] = y_single[i_agent];
+      }
+    }
+
+    std::vector<double> y_batch{};
+    for (size_t n_threads : {1, 4}) {
+      aggregate_neighbours_batch(compressed, AggregationMode::Gather, x_batch,
+                                 y_batch, n_vectors, n_threads);
+      REQUIRE(approx_equal(y_batch, expected_batch));
+      aggregate_neighbours_batch(incoming, x_batch, y_batch, n_vectors,
+                                 n_threads);
+      REQUIRE(approx_equal(y_batch, expected_batch));
+      aggregate_neighbours_batch(outgoing, x_batch, y_batch, n_vectors,
+                                 n_threads);
+      REQUIRE(approx_equal(y_batch, expected_batch));
+    }
+  }
+
+  SECTION("Rows of a dynamic network with pending changes") {
+    // Rows with tombstones and delta buffers are not contiguous
+    auto dynamic = DynamicNetwork<WeightT, uint32_t>(compressed);
+    dynamic.set_compaction_threshold(1.0);
+    std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+    for (size_t i = 0; i < 200; i++) {
+      const size_t i_agent = dist_agent(gen);
+      const auto neighbours = dynamic.get_neighbours(i_agent);
+      if (i % 2 == 0 && neighbours.size() > 0) {
+        dynamic.remove_edge(i_agent, *neighbours.begin());
+      } else {
+        dynamic.insert_edge(i_agent, dist_agent(gen), dist(gen));
+      }
+    }
+    REQUIRE(dynamic.n_pending_changes() > 0);
+    const auto expected_dynamic = sum_incoming(dynamic, x);
+
+    // The same vector three times, in the batch form
+    std::vector<double> x_batch{};
+    std::vector<double> expected_batch{};
+    for (size_t i_agent = 0; i_agent < n_agents; i_agent++) {
+      x_batch.insert(x_batch.end(), 3, x[i_agent]);
+      expected_batch.insert(expected_batch.end(), 3,
+                            expected_dynamic[i_agent]);
+    }
+
+    std::vector<double> y_batch{};
+    for (size_t n_threads : {1, 3}) {
+      aggregate_neighbours(dynamic, AggregationMode::Gather, x, y, n_threads);
+      REQUIRE(approx_equal(y, expected_dynamic));
+      aggregate_neighbours_batch(dynamic, AggregationMode::Gather, x_batch,
+                                 y_batch, 3, n_threads);
+      REQUIRE(approx_equal(y_batch, expected_batch));
+    }
+    aggregate_neighbours(dynamic.to_compressed_network(),
+                         AggregationMode::Gather, x, y);
+    REQUIRE(approx_equal(y, expected_dynamic));
+  }
+
+  SECTION("Float values on an undirected lattice") {
+    const auto lattice =
+        UndirectedNetworkGeneration::generate_square_lattice<float>(10, 0.25f);
+    auto x_float = std::vector<float>(lattice.n_agents(), 1.0f);
+    x_float[0] = 5.0f;
+    std::vector<float> y_float{};
+    aggregate_neighbours(lattice, AggregationMode::Gather, x_float, y_float);
+    REQUIRE(y_float[0] == 1.0f);
+    REQUIRE(y_float[1] == 2.0f);
+    REQUIRE(y_float[55] == 1.0f);
+  }
+}
@@ -1,17 +1,25 @@
 #include "catch2/catch_message.hpp"
 #include "catch2/matchers/catch_matchers.hpp"
 #include "fmt/ostream.h"
+#include "bfs_workspace.hpp"
+#include "bidirectional_network.hpp"
+#include "compressed_network.hpp"
+#include "network_generation.hpp"
 #include "network_operations.hpp"
 #include "undirected_network.hpp"
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_range_equals.hpp>
-#include <climits>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <fmt/format.h>
 #include <fmt/ranges.h>
+#include <map>
 #include <memory>
 #include <optional>
+#include <random>
 #include <set>
+#include <type_traits>
 #include <vector>
 
 TEST_CASE("Testing bog-standard BFS with unique shortest paths",
@@ -53,9 +61,11 @@ TEST_CASE("Testing bog-standard BFS with unique shortest paths",
 
   // When the source is set as 0, test that the depth at 5 is 3 when max_depth
   // is not set If max_depth is not set, then the whole graph will be traversed.
-  int depth_required = 3;
-  auto depth_level(std::vector<int>(network.n_agents(), INT_MAX));
-  auto parent = std::vector<std::vector<int>>{n_agents, std::vector<int>{}};
+  size_t depth_required = 3;
+  auto depth_level(
+      std::vector<size_t>(network.n_agents(), invalid_index<size_t>));
+  auto parent =
+      std::vector<std::vector<size_t>>{n_agents, std::vector<size_t>{}};
   // Perform the BFS from the source 0, and no max_depth
   bfs(network, parent, depth_level, 0, std::nullopt);
   REQUIRE(depth_level[5] == depth_required);
@@ -64,12 +74,12 @@ TEST_CASE("Testing bog-standard BFS with unique shortest paths",
   for (auto &p : parent)
     p.clear();
   depth_level.clear();
-  depth_level.resize(network.n_agents(), INT_MAX);
+  depth_level.resize(network.n_agents(), invalid_index<size_t>);
 
-  // Check that the BFS gives a depth level value of INT_MAX if the max_depth is
-  // set to 2
+  // Check that the BFS gives a depth level value of invalid_index if the
+  // max_depth is set to 2
   bfs(network, parent, depth_level, 0, 2);
-  REQUIRE(depth_level[5] == INT_MAX);
+  REQUIRE(depth_level[5] == invalid_index<size_t>);
 }
 
 TEST_CASE("Getting multiple shortest paths using BFS", "[multipleBFS]") {
@@ -123,17 +133,19 @@ TEST_CASE("Getting multiple shortest paths using BFS", "[multipleBFS]") {
   REQUIRE(network.n_edges(0) == 2);
 
   // Variables for the BFS from the source node 0
-  auto depth_level(std::vector<int>(network.n_agents(), INT_MAX));
-  auto parent = std::vector<std::vector<int>>{n_agents, std::vector<int>{}};
-  auto result_paths = std::vector<std::vector<int>>{};
-  int source = 0;
-  int destination = 5;
+  auto depth_level(
+      std::vector<size_t>(network.n_agents(), invalid_index<size_t>));
+  auto parent =
+      std::vector<std::vector<size_t>>{n_agents, std::vector<size_t>{}};
+  auto result_paths = std::vector<std::vector<size_t>>{};
+  size_t source = 0;
+  size_t destination = 5;
   auto path =
-      std::vector<int>{}; // Needed for recursive reconstruct_paths function
+      std::vector<size_t>{}; // Needed for recursive reconstruct_paths function
   // Parents along the shortest paths for each node, when 0 is the source
-  auto parent_required =
-      std::vector<std::vector<int>>{{-1}, {0}, {0}, {1}, {3, 6}, {4}, {1, 2}};
-  auto shortest_paths_required = std::vector<std::vector<int>>{
+  auto parent_required = std::vector<std::vector<size_t>>{
+      {invalid_index<size_t>}, {0}, {0}, {1}, {3, 6}, {4}, {1, 2}};
+  auto shortest_paths_required = std::vector<std::vector<size_t>>{
       {5, 4, 3, 1, 0}, {5, 4, 6, 1, 0}, {5, 4, 6, 2, 0}};
 
   // Perform the BFS over the entire graph
@@ -152,4 +164,347 @@ TEST_CASE("Getting multiple shortest paths using BFS", "[multipleBFS]") {
     REQUIRE_THAT(result_paths[i],
                  Catch::Matchers::RangeEquals(shortest_paths_required[i]));
   }
-}
\ No newline at end of file
+}
+
+// Checks that two parent lists contain the same parents for each node,
+// independently of their order
+bool same_parent_sets(const std::vector<std::vector<size_t>> &parent_1,
+                      const std::vector<std::vector<size_t>> &parent_2) {
+  bool same = parent_1.size() == parent_2.size();
+  for (size_t i = 0; same && i < parent_1.size(); i++) {
+    same &= std::multiset<size_t>(parent_1[i].begin(), parent_1[i].end()) ==
+            std::multiset<size_t>(parent_2[i].begin(), parent_2[i].end());
+  }
+  return same;
+}
+
+TEST_CASE("Direction-optimizing BFS gives the same result as BFS",
+          "[directionOptimizingBFS]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // Random networks with a low diameter, so that the frontier becomes large
+  const size_t n_agents = 3000;
+  const size_t n_edges = 15000;
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+
+  auto undirected = UndirectedNetwork<WeightT>(n_agents);
+  auto bidirectional = BidirectionalNetwork<WeightT>(n_agents);
+  for (size_t i_edge = 0; i_edge < n_edges; i_edge++) {
+    undirected.push_back_neighbour_and_weight(dist_agent(gen), dist_agent(gen),
+                                              1.0);
+    bidirectional.push_back_neighbour_and_weight(dist_agent(gen),
+                                                 dist_agent(gen), 1.0);
+  }
+
+  for (std::optional<size_t> max_depth :
+       {std::optional<size_t>{}, {0}, {2}, {3}}) {
+    auto depth_level = std::vector<size_t>(n_agents, invalid_index<size_t>);
+    auto parent = std::vector<std::vector<size_t>>(n_agents);
+    auto depth_level_do = depth_level;
+    auto parent_do = parent;
+    auto depth_level_no_parents = depth_level;
+
+    SECTION("Undirected network") {
+      bfs(undirected, parent, depth_level, 0, max_depth);
+      bfs_direction_optimizing(undirected, undirected, parent_do,
+                               depth_level_do, 0, max_depth);
+      bfs_direction_optimizing(undirected, undirected, depth_level_no_parents,
+                               0, max_depth);
+    }
+
+    SECTION("Directed network, with the incoming edges for bottom-up steps") {
+      bfs(bidirectional, parent, depth_level, 0, max_depth);
+      bfs_direction_optimizing(bidirectional.out_view(),
+                               bidirectional.in_view(), parent_do,
+                               depth_level_do, 0, max_depth);
+      bfs_direction_optimizing(bidirectional.out_view(),
+                               bidirectional.in_view(), depth_level_no_parents,
+                               0, max_depth);
+    }
+
+    REQUIRE_THAT(depth_level_do, Catch::Matchers::RangeEquals(depth_level));
+    REQUIRE_THAT(depth_level_no_parents,
+                 Catch::Matchers::RangeEquals(depth_level));
+    REQUIRE(same_parent_sets(parent_do, parent));
+  }
+}
+
+TEST_CASE("Parallel BFS gives the same result as BFS", "[parallelBFS]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_agents = 3000;
+  std::mt19937 gen(2);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+
+  auto network = DirectedNetwork<WeightT>(n_agents);
+
+  SECTION("Random network") {
+    for (size_t i_edge = 0; i_edge < 4 * n_agents; i_edge++) {
+      network.push_back_neighbour_and_weight(dist_agent(gen), dist_agent(gen),
+                                             1.0);
+    }
+  }
+
+  SECTION("Lattice, with many shortest paths and many levels") {
+    network = DirectedNetworkGeneration::generate_square_lattice<WeightT>(50);
+  }
+
+  for (size_t n_threads : {1, 2, 4}) {
+    for (std::optional<size_t> max_depth :
+         {std::optional<size_t>{}, {0}, {3}}) {
+      auto depth_level =
+          std::vector<size_t>(network.n_agents(), invalid_index<size_t>);
+      auto parent = std::vector<std::vector<size_t>>(network.n_agents());
+      auto depth_level_parallel = depth_level;
+      auto parent_parallel = parent;
+      auto depth_level_no_parents = depth_level;
+
+      bfs(network, parent, depth_level, 0, max_depth);
+      bfs_parallel(network, parent_parallel, depth_level_parallel, 0,
+                   max_depth, n_threads);
+      bfs_parallel(network, depth_level_no_parents, 0, max_depth, n_threads);
+
+      REQUIRE_THAT(depth_level_parallel,
+                   Catch::Matchers::RangeEquals(depth_level));
+      REQUIRE_THAT(depth_level_no_parents,
+                   Catch::Matchers::RangeEquals(depth_level));
+      REQUIRE(same_parent_sets(parent_parallel, parent));
+    }
+  }
+}
+
+TEST_CASE("Multi-source BFS gives the same depth levels as BFS",
+          "[multiSourceBFS]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_agents = 2000;
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+
+  auto network = DirectedNetwork<WeightT>(n_agents);
+  for (size_t i_edge = 0; i_edge < 3 * n_agents; i_edge++) {
+    network.push_back_neighbour_and_weight(dist_agent(gen), dist_agent(gen),
+                                           1.0);
+  }
+
+  // More sources than fit in one batch of 64, and a repeated source
+  std::vector<size_t> sources{};
+  for (size_t i_source = 0; i_source < 150; i_source++) {
+    sources.push_back(dist_agent(gen));
+  }
+  sources.push_back(sources.front());
+
+  for (std::optional<size_t> max_depth : {std::optional<size_t>{}, {0}, {2}}) {
+    std::vector<std::vector<size_t>> depth_level_bfs{};
+    for (size_t source : sources) {
+      auto depth_level = std::vector<size_t>(n_agents, invalid_index<size_t>);
+      auto parent = std::vector<std::vector<size_t>>(n_agents);
+      bfs(network, parent, depth_level, source, max_depth);
+      depth_level_bfs.push_back(depth_level);
+    }
+
+    auto depth_level_64 = bfs_multi_source(network, sources, max_depth);
+    auto depth_level_256 = bfs_multi_source<4>(network, sources, max_depth);
+    REQUIRE(depth_level_64 == depth_level_bfs);
+    REQUIRE(depth_level_256 == depth_level_bfs);
+
+    // Every reached (source, node) pair is visited exactly once
+    auto n_visits = std::vector<std::vector<size_t>>(
+        sources.size(), std::vector<size_t>(n_agents, 0));
+    bool depth_matches = true;
+    bfs_multi_source<2>(network, sources, max_depth,
+                        [&](size_t i_source, size_t v, size_t depth) {
+                          n_visits[i_source][v] += 1;
+                          depth_matches &=
+                              depth_level_bfs[i_source][v] == depth;
+                        });
+    REQUIRE(depth_matches);
+    bool visited_once = true;
+    for (size_t i_source = 0; i_source < sources.size(); i_source++) {
+      for (size_t v = 0; v < n_agents; v++) {
+        const size_t expected =
+            depth_level_bfs[i_source][v] == invalid_index<size_t> ? 0 : 1;
+        visited_once &= n_visits[i_source][v] == expected;
+      }
+    }
+    REQUIRE(visited_once);
+  }
+}
+
+TEST_CASE("BFS on a network with 32-bit indices", "[indexTypeBFS]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_agents = 2000;
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  auto network = DirectedNetwork<WeightT>(n_agents);
+  auto network_32 = DirectedNetwork<WeightT, uint32_t>(n_agents);
+  for (size_t i_edge = 0; i_edge < 3 * n_agents; i_edge++) {
+    const size_t i = dist_agent(gen);
+    const size_t j = dist_agent(gen);
+    network.push_back_neighbour_and_weight(i, j, 1.0);
+    network_32.push_back_neighbour_and_weight(i, j, 1.0);
+  }
+  static_assert(
+      std::is_same_v<network_index_t<decltype(network_32)>, uint32_t>);
+
+  auto depth_level = std::vector<size_t>(n_agents, invalid_index<size_t>);
+  auto parent = std::vector<std::vector<size_t>>(n_agents);
+  bfs(network, parent, depth_level, 0, std::nullopt);
+
+  // Unreached nodes are marked with the largest uint32_t instead
+  auto as_32 = [](const std::vector<size_t> &indices) {
+    auto result = std::vector<uint32_t>{};
+    for (size_t i : indices) {
+      result.push_back(i == invalid_index<size_t> ? invalid_index<uint32_t>
+                                                  : uint32_t(i));
+    }
+    return result;
+  };
+
+  auto compressed_32 = CompressedNetwork<WeightT, uint32_t>(network_32);
+  auto depth_level_32 =
+      std::vector<uint32_t>(n_agents, invalid_index<uint32_t>);
+  auto parent_32 = std::vector<std::vector<uint32_t>>(n_agents);
+  auto depth_level_compressed = depth_level_32;
+  auto parent_compressed = parent_32;
+  bfs(network_32, parent_32, depth_level_32, 0, std::nullopt);
+  bfs(compressed_32, parent_compressed, depth_level_compressed, 0,
+      std::nullopt);
+
+  bool same = true;
+  for (size_t v = 0; v < n_agents; v++) {
+    same &= parent_32[v] == as_32(parent[v]);
+    same &= parent_compressed[v] == parent_32[v];
+  }
+  REQUIRE(same);
+  REQUIRE(depth_level_32 == as_32(depth_level));
+  REQUIRE(depth_level_compressed == depth_level_32);
+
+  auto workspace = BfsWorkspace<uint32_t>(n_agents);
+  workspace.bfs(network_32, 0, std::nullopt);
+  for (size_t v = 0; v < n_agents; v++) {
+    same &= workspace.get_depth(v) == depth_level_32[v];
+  }
+  REQUIRE(same);
+}
+
+TEST_CASE("BFS workspace gives the same result as BFS over many queries",
+          "[bfsWorkspace]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  const size_t n_agents = 2000;
+  std::mt19937 gen(6);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  auto network = UndirectedNetwork<WeightT>(n_agents);
+  for (size_t i_edge = 0; i_edge < 2 * n_agents; i_edge++) {
+    network.push_back_neighbour_and_weight(dist_agent(gen), dist_agent(gen),
+                                           1.0);
+  }
+
+  // The same workspace is used for all queries, so that left-overs of a
+  // previous query would show up
+  auto workspace = BfsWorkspace(n_agents);
+  for (size_t i_query = 0; i_query < 20; i_query++) {
+    const size_t source = dist_agent(gen);
+    std::optional<size_t> max_depth{};
+    if (i_query % 3 != 0) {
+      max_depth = i_query % 4;
+    }
+
+    auto depth_level = std::vector<size_t>(n_agents, invalid_index<size_t>);
+    auto parent = std::vector<std::vector<size_t>>(n_agents);
+    bfs(network, parent, depth_level, source, max_depth);
+    workspace.bfs(network, source, max_depth);
+
+    bool same = true;
+    size_t n_reached = 0;
+    for (size_t v = 0; v < n_agents; v++) {
+      const auto parents = workspace.get_parents(v);
+      same &= workspace.get_depth(v) == depth_level[v];
+      same &= std::vector<size_t>(parents.begin(), parents.end()) == parent[v];
+      n_reached += depth_level[v] == invalid_index<size_t> ? 0 : 1;
+    }
+    REQUIRE(same);
+    REQUIRE(workspace.get_reached().size() == n_reached);
+
+    // Paths to the last reached node
+    const size_t destination = workspace.get_reached().back();
+    std::vector<std::vector<size_t>> paths{};
+    std::vector<size_t> path{};
+    reconstruct_paths(parent, paths, path, destination);
+    REQUIRE(workspace.get_paths(destination) == paths);
+  }
+}
+
+TEST_CASE("Counting, enumerating and sampling shortest paths",
+          "[pathCounting]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  // A periodic lattice has many shortest paths between distant nodes
+  auto network =
+      DirectedNetworkGeneration::generate_square_lattice<WeightT>(8);
+  const size_t n_agents = network.n_agents();
+  auto depth_level = std::vector<size_t>(n_agents, invalid_index<size_t>);
+  auto parent = std::vector<std::vector<size_t>>(n_agents);
+  bfs(network, parent, depth_level, 0, std::nullopt);
+
+  const auto n_paths = count_shortest_paths(parent, depth_level);
+  const auto n_paths_approx = count_shortest_paths<double>(parent, depth_level);
+  REQUIRE(n_paths[0] == 1);
+
+  bool same_paths = true;
+  for (size_t v = 0; v < n_agents; v++) {
+    std::vector<std::vector<size_t>> paths{};
+    std::vector<size_t> path{};
+    reconstruct_paths(parent, paths, path, v);
+    same_paths &= n_paths[v] == paths.size();
+    same_paths &= n_paths_approx[v] == double(paths.size());
+    same_paths &=
+        enumerate_shortest_paths(parent, v, paths.size() + 1) == paths;
+  }
+  REQUIRE(same_paths);
+
+  // The node opposite to the source has 70 paths through each of the four
+  // quadrants of the periodic lattice; stop after 10 of them
+  const size_t destination = 4 * 8 + 4;
+  std::vector<std::vector<size_t>> paths{};
+  std::vector<size_t> path{};
+  reconstruct_paths(parent, paths, path, destination);
+  REQUIRE(paths.size() == 280);
+  const auto first_paths = enumerate_shortest_paths(parent, destination, 10);
+  REQUIRE(first_paths ==
+          std::vector<std::vector<size_t>>(paths.begin(), paths.begin() + 10));
+
+  // Every path should be drawn about equally often
+  std::mt19937 gen(7);
+  std::map<std::vector<size_t>, size_t> n_draws{};
+  const size_t n_samples = 280 * 200;
+  for (size_t i_sample = 0; i_sample < n_samples; i_sample++) {
+    n_draws[sample_shortest_path(parent, n_paths, destination, gen)] += 1;
+  }
+  REQUIRE(n_draws.size() == 280);
+  for (const auto &[sampled_path, n] : n_draws) {
+    REQUIRE(std::find(paths.begin(), paths.end(), sampled_path) != paths.end());
+    REQUIRE(n > 100);
+    REQUIRE(n < 300);
+  }
+
+  // Unreached nodes have no paths
+  auto network_disconnected = DirectedNetwork<WeightT>(3);
+  network_disconnected.push_back_neighbour_and_weight(0, 1, 1.0);
+  depth_level = std::vector<size_t>(3, invalid_index<size_t>);
+  parent = std::vector<std::vector<size_t>>(3);
+  bfs(network_disconnected, parent, depth_level, 0, std::nullopt);
+  const auto n_paths_disconnected = count_shortest_paths(parent, depth_level);
+  REQUIRE(n_paths_disconnected[2] == 0);
+  REQUIRE(enumerate_shortest_paths(parent, 2, 10).empty());
+  REQUIRE(sample_shortest_path(parent, n_paths_disconnected, 2, gen).empty());
+}
@@ -0,0 +1,260 @@
+#include "bidirectional_network.hpp"
+#include "compressed_network.hpp"
+#include "directed_network.hpp"
+#include "generators.hpp"
+#include "network_generation.hpp"
+#include "reordering.hpp"
+#include "undirected_network.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Checks that the network after renumbering has exactly the edges of the
+// network before it, with the same weights and in the same order per row
+template <typename NetworkT1, typename NetworkT2>
+bool same_edges(const NetworkT1 &before, const NetworkT2 &after,
+                const Graph::Permutation &permutation) {
+  for (size_t i_agent = 0; i_agent < before.n_agents(); i_agent++) {
+    const size_t k = permutation.forward[i_agent];
+    const auto neighbours = before.get_neighbours(i_agent);
+    const auto weights = before.get_weights(i_agent);
+    if (after.get_neighbours(k).size() != neighbours.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < neighbours.size(); i++) {
+      if (after.get_neighbours(k)[i] != permutation.forward[neighbours[i]] ||
+          after.get_weights(k)[i] != weights[i]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// The largest distance between the indices of two neighbours
+template <typename NetworkT> size_t bandwidth(const NetworkT &network) {
+  size_t result = 0;
+  for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+    for (size_t j_agent : network.get_neighbours(i_agent)) {
+      result = std::max(result, i_agent > j_agent ? i_agent - j_agent
+                                                  : j_agent - i_agent);
+    }
+  }
+  return result;
+}
+
+// A random renumbering, which scatters the neighbours of every agent
+Graph::Permutation random_permutation(size_t n_agents, unsigned int seed) {
+  std::vector<size_t> order(n_agents);
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 gen(seed);
+  std::shuffle(order.begin(), order.end(), gen);
+  return Graph::permutation_from_order(std::move(order));
+}
+
+TEST_CASE("Testing permutations and per-agent values") {
+  using namespace Graph;
+
+  const auto permutation = permutation_from_order({2, 0, 3, 1});
+  REQUIRE_THAT(permutation.forward,
+               Catch::Matchers::RangeEquals(std::vector<size_t>{1, 3, 0, 2}));
+  REQUIRE_THAT(inverse_permutation(permutation).forward,
+               Catch::Matchers::RangeEquals(permutation.inverse));
+  REQUIRE_THROWS_AS(permutation_from_order({0, 2, 2}), std::runtime_error);
+  REQUIRE_THROWS_AS(permutation_from_order({0, 3, 1}), std::runtime_error);
+
+  const auto values = std::vector<double>{0.0, 0.1, 0.2, 0.3};
+  const auto permuted = permute_values(values, permutation, 2);
+  REQUIRE_THAT(permuted, Catch::Matchers::RangeEquals(
+                             std::vector<double>{0.2, 0.0, 0.3, 0.1}));
+  REQUIRE_THAT(unpermute_values(permuted, permutation),
+               Catch::Matchers::RangeEquals(values));
+  REQUIRE_THROWS_AS(permute_values(std::vector<double>(3), permutation),
+                    std::runtime_error);
+
+  auto sources = std::vector<uint32_t>{3, invalid_index<uint32_t>, 0};
+  permute_indices(sources, permutation);
+  REQUIRE_THAT(sources, Catch::Matchers::RangeEquals(std::vector<uint32_t>{
+                            2, invalid_index<uint32_t>, 1}));
+}
+
+TEST_CASE("Testing the orderings") {
+  using namespace Graph;
+
+  SECTION("Degree order") {
+    const auto network = generate_barabasi_albert<double, uint32_t>(500, 3, 1);
+    for (bool descending : {true, false}) {
+      const auto permutation = degree_order(network, descending, 3);
+      const auto reordered = permute_agents(network, permutation, 2);
+      REQUIRE(same_edges(network, reordered, permutation));
+      for (size_t k = 1; k < reordered.n_agents(); k++) {
+        if (descending) {
+          REQUIRE(reordered.n_edges(k - 1) >= reordered.n_edges(k));
+        } else {
+          REQUIRE(reordered.n_edges(k - 1) <= reordered.n_edges(k));
+        }
+      }
+    }
+  }
+
+  SECTION("Reverse Cuthill-McKee gives back the bandwidth of a lattice") {
+    // A path and a 20 x 20 lattice (without periodic boundaries, so that the
+    // bandwidth is 20), shuffled
+    auto path = UndirectedNetwork<double>(100);
+    for (size_t i_agent = 0; i_agent + 1 < 100; i_agent++) {
+      path.push_back_neighbour_and_weight(i_agent, i_agent + 1, 1.0);
+    }
+    path.permute_agents(random_permutation(100, 1));
+    REQUIRE(bandwidth(path) > 1);
+    path.permute_agents(reverse_cuthill_mckee_order(path));
+    REQUIRE(bandwidth(path) == 1);
+
+    auto lattice = UndirectedNetwork<double>(400);
+    for (size_t i_agent = 0; i_agent < 400; i_agent++) {
+      if (i_agent % 20 < 19) {
+        lattice.push_back_neighbour_and_weight(i_agent, i_agent + 1, 1.0);
+      }
+      if (i_agent + 20 < 400) {
+        lattice.push_back_neighbour_and_weight(i_agent, i_agent + 20, 1.0);
+      }
+    }
+    lattice.permute_agents(random_permutation(400, 2));
+    REQUIRE(bandwidth(lattice) > 200);
+    lattice.permute_agents(reverse_cuthill_mckee_order(lattice));
+    REQUIRE(bandwidth(lattice) <= 21);
+  }
+
+  SECTION("Every component is ordered, including isolated agents") {
+    auto network = UndirectedNetwork<double>(7);
+    network.push_back_neighbour_and_weight(5, 1, 1.0);
+    network.push_back_neighbour_and_weight(1, 3, 1.0);
+    network.push_back_neighbour_and_weight(0, 6, 1.0);
+    for (const auto &permutation :
+         {reverse_cuthill_mckee_order(network), community_order(network),
+          degree_order(network)}) {
+      REQUIRE(permutation.size() == 7);
+      auto reordered = network;
+      reordered.permute_agents(permutation);
+      REQUIRE(same_edges(network, reordered, permutation));
+    }
+  }
+
+  SECTION("Community order keeps the blocks of a shuffled network together") {
+    // Four dense blocks, sparsely connected to each other
+    const auto block_sizes = std::vector<size_t>{50, 80, 60, 70};
+    auto probabilities = std::vector<std::vector<double>>(
+        4, std::vector<double>(4, 0.002));
+    for (size_t block = 0; block < 4; block++) {
+      probabilities[block][block] = 0.5;
+    }
+    const auto sbm = generate_stochastic_block_model<double, uint32_t>(
+        block_sizes, probabilities, 3);
+    const auto shuffle = random_permutation(sbm.n_agents(), 4);
+    const auto shuffled = permute_agents(sbm, shuffle);
+
+    const auto permutation = community_order(shuffled);
+    const auto reordered = permute_agents(shuffled, permutation);
+    REQUIRE(same_edges(shuffled, reordered, permutation));
+
+    // The new indices of every block form a contiguous range
+    size_t first_agent = 0;
+    for (size_t block_size : block_sizes) {
+      std::vector<size_t> new_indices{};
+      for (size_t i = first_agent; i < first_agent + block_size; i++) {
+        new_indices.push_back(permutation.forward[shuffle.forward[i]]);
+      }
+      std::sort(new_indices.begin(), new_indices.end());
+      REQUIRE(new_indices.back() - new_indices.front() == block_size - 1);
+      first_agent += block_size;
+    }
+  }
+}
+
+TEST_CASE("Testing the renumbering of networks") {
+  using namespace Graph;
+  using WeightT = double;
+
+  std::mt19937 gen(0);
+  const auto network =
+      DirectedNetworkGeneration::generate_fully_connected<WeightT>(40, gen);
+  auto sparse = DirectedNetwork<WeightT>(40);
+  for (size_t i_agent = 0; i_agent < 40; i_agent++) {
+    for (size_t k = 0; k < network.n_edges(i_agent); k++) {
+      const size_t j_agent = network.get_neighbours(i_agent)[k];
+      if ((i_agent * 7 + j_agent * 3) % 5 == 0) {
+        sparse.push_back_neighbour_and_weight(
+            i_agent, j_agent, network.get_edge_weight(i_agent, k));
+      }
+    }
+  }
+  const auto permutation = random_permutation(40, 5);
+
+  SECTION("DirectedNetwork, with the components following along") {
+    auto reordered = sparse;
+    reordered.permute_agents(permutation, 3);
+    REQUIRE(same_edges(sparse, reordered, permutation));
+    REQUIRE(reordered.direction() == sparse.direction());
+
+    auto components = sparse.strongly_connected_components();
+    auto reordered_components = reordered.strongly_connected_components();
+    for (auto &component : components) {
+      permute_indices(component, permutation);
+      std::sort(component.begin(), component.end());
+    }
+    for (auto &component : reordered_components) {
+      std::sort(component.begin(), component.end());
+    }
+    std::sort(components.begin(), components.end());
+    std::sort(reordered_components.begin(), reordered_components.end());
+    REQUIRE(components == reordered_components);
+
+    REQUIRE_THROWS_AS(reordered.permute_agents(random_permutation(39, 0)),
+                      std::runtime_error);
+  }
+
+  SECTION("Sorted adjacency and the hash index are restored") {
+    auto reordered = sparse;
+    reordered.set_sorted_adjacency(true);
+    reordered.set_hash_index(2);
+    reordered.permute_agents(permutation);
+    for (size_t k = 0; k < reordered.n_agents(); k++) {
+      const auto neighbours = reordered.get_neighbours(k);
+      REQUIRE(std::is_sorted(neighbours.begin(), neighbours.end()));
+    }
+    for (size_t i_agent = 0; i_agent < 40; i_agent++) {
+      for (size_t j_agent = 0; j_agent < 40; j_agent++) {
+        REQUIRE(sparse.connection_exists(i_agent, j_agent) ==
+                reordered.connection_exists(permutation.forward[i_agent],
+                                            permutation.forward[j_agent]));
+      }
+    }
+  }
+
+  SECTION("The incoming side of a BidirectionalNetwork follows") {
+    auto bidirectional = BidirectionalNetwork<WeightT>(sparse);
+    const auto before = bidirectional;
+    bidirectional.permute_agents(permutation, 2);
+    REQUIRE(same_edges(before, bidirectional, permutation));
+    // The incoming rows are ordered by their source, like in the transpose
+    auto expected = bidirectional.to_directed_network(
+        DirectedNetwork<WeightT>::EdgeDirection::Outgoing);
+    expected.toggle_incoming_outgoing();
+    for (size_t k = 0; k < 40; k++) {
+      REQUIRE_THAT(bidirectional.get_in_neighbours(k),
+                   Catch::Matchers::RangeEquals(expected.get_neighbours(k)));
+      REQUIRE_THAT(bidirectional.get_in_weights(k),
+                   Catch::Matchers::RangeEquals(expected.get_weights(k)));
+      for (size_t i = 0; i < bidirectional.n_edges(k); i++) {
+        const size_t j = bidirectional.get_neighbours(k)[i];
+        REQUIRE(bidirectional.get_in_neighbours(
+                    j)[bidirectional.get_out_cross_index(k, i)] == k);
+      }
+    }
+  }
+}
@@ -0,0 +1,201 @@
+#include "compressed_network.hpp"
+#include "directed_network.hpp"
+#include "network_operations.hpp"
+#include "shortest_paths.hpp"
+#include "undirected_network.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+// Checks that two parent lists contain the same parents for each node,
+// independently of their order
+bool same_parent_sets(const std::vector<std::vector<size_t>> &parent_1,
+                      const std::vector<std::vector<size_t>> &parent_2) {
+  bool same = parent_1.size() == parent_2.size();
+  for (size_t i = 0; same && i < parent_1.size(); i++) {
+    same &= std::multiset<size_t>(parent_1[i].begin(), parent_1[i].end()) ==
+            std::multiset<size_t>(parent_2[i].begin(), parent_2[i].end());
+  }
+  return same;
+}
+
+TEST_CASE("Testing weighted shortest paths with equal-cost paths",
+          "[dijkstra]") {
+  using namespace Graph;
+  using WeightT = double;
+  const WeightT infinity = std::numeric_limits<WeightT>::max();
+
+  // 0 -> 1 -> 3 and 0 -> 2 -> 3 both have length 3, the direct edge 0 -> 3 is
+  // longer; 4 can only be reached through 3, and 5 is not connected
+  auto network = DirectedNetwork<WeightT>(
+      std::vector<std::vector<size_t>>{{1, 2, 3}, {3}, {3}, {4}, {}, {}},
+      std::vector<std::vector<WeightT>>{
+          {1.0, 2.0, 5.0}, {2.0}, {1.0}, {0.5}, {}, {}},
+      DirectedNetwork<WeightT>::EdgeDirection::Outgoing);
+
+  std::vector<std::vector<size_t>> parent(network.n_agents());
+  std::vector<WeightT> distance(network.n_agents(), infinity);
+  auto parent_delta = parent;
+  auto distance_delta = distance;
+  std::optional<WeightT> max_distance{};
+
+  SECTION("Without a bound") {
+    dijkstra(network, parent, distance, 0, max_distance);
+    REQUIRE_THAT(distance, Catch::Matchers::RangeEquals(std::vector<WeightT>{
+                               0.0, 1.0, 2.0, 3.0, 3.5, infinity}));
+  }
+
+  SECTION("With a distance bound") {
+    max_distance = 3.0;
+    dijkstra(network, parent, distance, 0, max_distance);
+    REQUIRE_THAT(distance, Catch::Matchers::RangeEquals(std::vector<WeightT>{
+                               0.0, 1.0, 2.0, 3.0, infinity, infinity}));
+  }
+
+  REQUIRE(same_parent_sets(
+      parent, {{invalid_index<size_t>}, {0}, {0}, {1, 2}, parent[4], {}}));
+  std::vector<std::vector<size_t>> paths{};
+  std::vector<size_t> path{};
+  reconstruct_paths(parent, paths, path, 3);
+  REQUIRE(paths.size() == 2);
+
+  delta_stepping(network, parent_delta, distance_delta, 0, max_distance, 1.0,
+                 2);
+  REQUIRE_THAT(distance_delta, Catch::Matchers::RangeEquals(distance));
+  REQUIRE(same_parent_sets(parent_delta, parent));
+}
+
+TEST_CASE("Shortest paths with unit weights are the BFS paths", "[dijkstra]") {
+  using namespace Graph;
+  using WeightT = float;
+
+  const size_t n_agents = 1000;
+  std::mt19937 gen(4);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  auto network = UndirectedNetwork<WeightT>(n_agents);
+  for (size_t i_edge = 0; i_edge < 2 * n_agents; i_edge++) {
+    network.push_back_neighbour_and_weight(dist_agent(gen), dist_agent(gen),
+                                           1.0);
+  }
+
+  auto depth_level = std::vector<size_t>(n_agents, invalid_index<size_t>);
+  auto parent_bfs = std::vector<std::vector<size_t>>(n_agents);
+  bfs(network, parent_bfs, depth_level, 0, 4);
+
+  auto distance = std::vector<WeightT>(n_agents,
+                                       std::numeric_limits<WeightT>::max());
+  auto parent = std::vector<std::vector<size_t>>(n_agents);
+  dijkstra(network, parent, distance, 0, 4.0f);
+
+  bool same_distances = true;
+  for (size_t v = 0; v < n_agents; v++) {
+    same_distances &= depth_level[v] == invalid_index<size_t>
+                          ? distance[v] == std::numeric_limits<WeightT>::max()
+                          : distance[v] == WeightT(depth_level[v]);
+  }
+  REQUIRE(same_distances);
+  REQUIRE(same_parent_sets(parent, parent_bfs));
+}
+
+TEST_CASE("Delta-stepping gives the same result as Dijkstra",
+          "[deltaStepping]") {
+  using namespace Graph;
+  using WeightT = double;
+  const WeightT infinity = std::numeric_limits<WeightT>::max();
+
+  const size_t n_agents = 3000;
+  std::mt19937 gen(5);
+  std::uniform_int_distribution<size_t> dist_agent(0, n_agents - 1);
+  // Small integer weights, so that there are many equal-cost paths
+  std::uniform_int_distribution<int> dist_weight(0, 10);
+  auto network = DirectedNetwork<WeightT>(n_agents);
+  for (size_t i_edge = 0; i_edge < 4 * n_agents; i_edge++) {
+    network.push_back_neighbour_and_weight(dist_agent(gen), dist_agent(gen),
+                                           dist_weight(gen));
+  }
+  const auto compressed = CompressedNetwork<WeightT>(network);
+
+  for (std::optional<WeightT> max_distance :
+       {std::optional<WeightT>{}, {12.0}}) {
+    auto distance = std::vector<WeightT>(n_agents, infinity);
+    auto parent = std::vector<std::vector<size_t>>(n_agents);
+    dijkstra(network, parent, distance, 0, max_distance);
+
+    for (size_t n_threads : {1, 2, 4}) {
+      for (std::optional<WeightT> delta : {std::optional<WeightT>{}, {1.0}}) {
+        auto distance_delta = std::vector<WeightT>(n_agents, infinity);
+        auto parent_delta = std::vector<std::vector<size_t>>(n_agents);
+        auto distance_no_parents = distance_delta;
+        delta_stepping(compressed, parent_delta, distance_delta, 0,
+                       max_distance, delta, n_threads);
+        delta_stepping(network, distance_no_parents, 0, max_distance, delta,
+                       n_threads);
+
+        REQUIRE_THAT(distance_delta, Catch::Matchers::RangeEquals(distance));
+        REQUIRE_THAT(distance_no_parents,
+                     Catch::Matchers::RangeEquals(distance));
+        REQUIRE(same_parent_sets(parent_delta, parent));
+      }
+    }
+  }
+}
+
+TEST_CASE("Shortest paths keep the parents acyclic on zero-weight cycles",
+          "[dijkstra]") {
+  using namespace Graph;
+  using WeightT = double;
+  const WeightT infinity = std::numeric_limits<WeightT>::max();
+
+  // 1 and 2 are on a cycle of zero weight, both at distance 1, and 3 hangs
+  // off 2 with another edge of zero weight
+  auto network = DirectedNetwork<WeightT>(
+      std::vector<std::vector<size_t>>{{1}, {2}, {1, 3}, {}},
+      std::vector<std::vector<WeightT>>{{1.0}, {0.0}, {0.0, 0.0}, {}},
+      DirectedNetwork<WeightT>::EdgeDirection::Outgoing);
+  const std::vector<std::vector<size_t>> expected{
+      {invalid_index<size_t>}, {0}, {1}, {2}};
+
+  auto distance = std::vector<WeightT>(network.n_agents(), infinity);
+  auto parent = std::vector<std::vector<size_t>>(network.n_agents());
+  dijkstra(network, parent, distance, 0, std::nullopt);
+  REQUIRE_THAT(distance, Catch::Matchers::RangeEquals(
+                             std::vector<WeightT>{0.0, 1.0, 1.0, 1.0}));
+  REQUIRE(same_parent_sets(parent, expected));
+
+  for (size_t n_threads : {1, 2}) {
+    auto distance_delta = std::vector<WeightT>(network.n_agents(), infinity);
+    auto parent_delta = std::vector<std::vector<size_t>>(network.n_agents());
+    delta_stepping(network, parent_delta, distance_delta, 0, std::nullopt,
+                   std::nullopt, n_threads);
+    REQUIRE_THAT(distance_delta, Catch::Matchers::RangeEquals(distance));
+    REQUIRE(same_parent_sets(parent_delta, expected));
+  }
+
+  std::vector<std::vector<size_t>> paths{};
+  std::vector<size_t> path{};
+  reconstruct_paths(parent, paths, path, 3);
+  REQUIRE_THAT(paths, Catch::Matchers::RangeEquals(
+                          std::vector<std::vector<size_t>>{{3, 2, 1, 0}}));
+}
+
+TEST_CASE("Shortest paths reject negative weights", "[dijkstra]") {
+  using namespace Graph;
+  using WeightT = double;
+
+  auto network = DirectedNetwork<WeightT>(3);
+  network.push_back_neighbour_and_weight(0, 1, 1.0);
+  network.push_back_neighbour_and_weight(1, 2, -1.0);
+
+  auto distance = std::vector<WeightT>(3, std::numeric_limits<WeightT>::max());
+  auto parent = std::vector<std::vector<size_t>>(3);
+  REQUIRE_THROWS_AS(dijkstra(network, parent, distance, 0, std::nullopt),
+                    std::runtime_error);
+  REQUIRE_THROWS_AS(delta_stepping(network, distance, 0, std::nullopt),
+                    std::runtime_error);
+}
@@ -0,0 +1,125 @@
+#include "undirected_network.hpp"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cstddef>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// Checks that every edge is stored in both rows, with the same weight
+template <typename NetworkT> bool is_symmetric(const NetworkT &network) {
+  bool symmetric = true;
+  for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+    const auto neighbours = network.get_neighbours(i_agent);
+    for (size_t i = 0; i < neighbours.size(); i++) {
+      const auto reverse_neighbours = network.get_neighbours(neighbours[i]);
+      const auto it = std::ranges::find(reverse_neighbours, i_agent);
+      symmetric &= it != reverse_neighbours.end() &&
+                   network.get_weights(neighbours[i])[std::distance(
+                       reverse_neighbours.begin(), it)] ==
+                       network.get_weights(i_agent)[i];
+    }
+  }
+  return symmetric;
+}
+
+TEST_CASE("Testing set_edge_weight of the undirected network") {
+  using namespace Graph;
+  using WeightT = double;
+
+  auto network = UndirectedNetwork<WeightT>(4);
+  network.push_back_neighbour_and_weight(0, 3, 1.0);
+  network.push_back_neighbour_and_weight(1, 3, 1.0);
+  network.push_back_neighbour_and_weight(2, 3, 1.0);
+
+  // 2 is the third neighbour of 3, and 3 the first neighbour of 2
+  network.set_edge_weight(2, 0, 5.0);
+  REQUIRE_THAT(network.get_weights(3),
+               Catch::Matchers::RangeEquals(std::vector<WeightT>{1, 1, 5}));
+  network.set_edge_weight(3, 1, 2.0);
+  REQUIRE(network.get_weights(1)[0] == 2.0);
+  REQUIRE(is_symmetric(network));
+}
+
+TEST_CASE("Testing the sorted adjacency mode of the undirected network") {
+  using namespace Graph;
+  using WeightT = double;
+
+  auto network = UndirectedNetwork<WeightT>(5);
+  network.push_back_neighbour_and_weight(4, 0, 1.0);
+  network.push_back_neighbour_and_weight(4, 3, 2.0);
+  network.set_sorted_adjacency(true);
+  network.set_hash_index(2);
+  network.push_back_neighbour_and_weight(4, 1, 3.0);
+  network.push_back_neighbour_and_weight(2, 4, 4.0);
+
+  REQUIRE_THAT(network.get_neighbours(4),
+               Catch::Matchers::RangeEquals(std::vector<size_t>{0, 1, 2, 3}));
+  REQUIRE_THAT(network.get_weights(4),
+               Catch::Matchers::RangeEquals(std::vector<WeightT>{1, 3, 4, 2}));
+  REQUIRE(network.connection_exists(4, 2));
+  REQUIRE(network.connection_exists(2, 4));
+  REQUIRE(!network.connection_exists(4, 4));
+  REQUIRE(network.find_neighbour(4, 3) == 3);
+
+  network.set_edge_weight(4, 1, 5.0);
+  REQUIRE(network.get_weights(1)[0] == 5.0);
+  REQUIRE(is_symmetric(network));
+}
+
+TEST_CASE("Testing remove_double_counting of the undirected network") {
+  using namespace Graph;
+  using WeightT = double;
+
+  SECTION("Hub with many repeated edges") {
+    // Every agent is connected to the hub 0 several times, and to a few other
+    // agents. The integer weights make the sums exact
+    const size_t n_agents = 3000;
+    auto network = UndirectedNetwork<WeightT>(n_agents);
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<size_t> dist_agent(1, n_agents - 1);
+    std::vector<WeightT> hub_weights(n_agents, 0.0);
+    for (size_t i_repeat = 0; i_repeat < 3; i_repeat++) {
+      for (size_t i_agent = 1; i_agent < n_agents; i_agent++) {
+        network.push_back_neighbour_and_weight(i_agent, 0, WeightT(i_repeat));
+        hub_weights[i_agent] += WeightT(i_repeat);
+        network.push_back_neighbour_and_weight(i_agent, dist_agent(gen), 1.0);
+      }
+    }
+
+    for (size_t n_threads : {1, 4}) {
+      auto merged = network;
+      merged.remove_double_counting(n_threads);
+      REQUIRE(merged.n_edges(0) == n_agents - 1);
+      REQUIRE_THAT(merged.get_weights(0),
+                   Catch::Matchers::RangeEquals(std::vector<WeightT>(
+                       hub_weights.begin() + 1, hub_weights.end())));
+      REQUIRE(is_symmetric(merged));
+    }
+  }
+
+  SECTION("Half-edges with a missing or different reverse half") {
+    // 0 - 1 is stored twice in row 0 but once in row 1, 0 - 2 only in row 2
+    // and 1 - 2 only in row 1; 2 has a self-loop
+    auto network = UndirectedNetwork<WeightT>(
+        std::vector<std::vector<size_t>>{{1, 1}, {2, 0}, {0, 2}},
+        std::vector<std::vector<WeightT>>{{1, 2}, {4, 7}, {5, 6}});
+    network.remove_double_counting();
+
+    // The half of the smaller agent index wins
+    REQUIRE_THAT(network.get_neighbours(0),
+                 Catch::Matchers::RangeEquals(std::vector<size_t>{1, 2}));
+    REQUIRE_THAT(network.get_weights(0),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{3, 5}));
+    REQUIRE_THAT(network.get_neighbours(1),
+                 Catch::Matchers::RangeEquals(std::vector<size_t>{0, 2}));
+    REQUIRE_THAT(network.get_weights(1),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{3, 4}));
+    REQUIRE_THAT(network.get_neighbours(2),
+                 Catch::Matchers::RangeEquals(std::vector<size_t>{0, 1, 2}));
+    REQUIRE_THAT(network.get_weights(2),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{5, 4, 6}));
+    REQUIRE(is_symmetric(network));
+  }
+}
@@ -0,0 +1,160 @@
+#include "bidirectional_network.hpp"
+#include "directed_network.hpp"
+#include "network_generation.hpp"
+#include "undirected_network.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+// Checks that the weights of every agent sum to 1 (or have no weights)
+template <typename NetworkT> bool rows_sum_to_one(const NetworkT &network) {
+  for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+    double sum = 0;
+    for (auto w : network.get_weights(i_agent)) {
+      sum += w;
+    }
+    if (!network.get_weights(i_agent).empty() && std::abs(sum - 1) > 1e-12) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST_CASE("Normalizing the rows and columns of the weights") {
+  using namespace Graph;
+  using WeightT = double;
+  using EdgeDirection = DirectedNetwork<WeightT>::EdgeDirection;
+
+  auto network = DirectedNetwork<WeightT>(
+      std::vector<std::vector<size_t>>{{1, 2}, {1}, {0}, {}, {3, 0, 1}},
+      std::vector<std::vector<WeightT>>{
+          {1.0, 3.0}, {0.5}, {0.0}, {}, {0.1, 0.2, 0.3}},
+      EdgeDirection::Incoming);
+
+  SECTION("Rows") {
+    network.normalize_rows(2);
+    REQUIRE_THAT(network.get_weights(0), Catch::Matchers::RangeEquals(
+                                             std::vector<WeightT>{0.25, 0.75}));
+    REQUIRE_THAT(network.get_weights(1),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{1.0}));
+    // A row summing to 0 is left as it is
+    REQUIRE_THAT(network.get_weights(2),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{0.0}));
+    REQUIRE(std::abs(network.get_edge_weight(4, 2) - 0.5) < 1e-12);
+  }
+
+  SECTION("Columns, without transposing, as the rows of the transpose") {
+    // Toggling twice sorts the rows
+    network.set_sorted_adjacency(true);
+    auto expected = network;
+    expected.toggle_incoming_outgoing();
+    expected.normalize_rows();
+    expected.toggle_incoming_outgoing();
+
+    network.normalize_columns();
+    for (size_t i_agent = 0; i_agent < network.n_agents(); i_agent++) {
+      REQUIRE_THAT(network.get_neighbours(i_agent),
+                   Catch::Matchers::RangeEquals(
+                       expected.get_neighbours(i_agent)));
+      for (size_t k = 0; k < network.n_edges(i_agent); k++) {
+        REQUIRE(std::abs(network.get_edge_weight(i_agent, k) -
+                         expected.get_edge_weight(i_agent, k)) < 1e-12);
+      }
+    }
+  }
+
+  SECTION("Rows and columns of a large network on several threads") {
+    std::mt19937 gen(0);
+    auto large =
+        DirectedNetworkGeneration::generate_fully_connected<WeightT>(300, gen);
+    REQUIRE(rows_sum_to_one(large));
+
+    large.normalize_columns(4);
+    large.toggle_incoming_outgoing();
+    REQUIRE(rows_sum_to_one(large));
+  }
+}
+
+TEST_CASE("Scaling, thresholding and transforming the weights") {
+  using namespace Graph;
+  using WeightT = double;
+  using EdgeDirection = DirectedNetwork<WeightT>::EdgeDirection;
+
+  auto network = DirectedNetwork<WeightT>(
+      std::vector<std::vector<size_t>>{{1, 2}, {1}, {0}, {}, {3, 0, 1}},
+      std::vector<std::vector<WeightT>>{
+          {0.5, 0.5}, {0.5}, {0.2}, {}, {0.1, 0.2, 0.3}},
+      EdgeDirection::Incoming);
+
+  network.scale_weights(2.0);
+  REQUIRE_THAT(
+      network.get_weights(4),
+      Catch::Matchers::RangeEquals(std::vector<WeightT>{0.2, 0.4, 0.6}));
+
+  // Weights of the edges j -> i are multiplied by i + j
+  network.transform_weights(
+      [](size_t i_agent, size_t j_agent, WeightT w) {
+        return w * (i_agent + j_agent);
+      },
+      3);
+  REQUIRE_THAT(network.get_weights(4),
+               Catch::Matchers::RangeEquals(
+                   std::vector<WeightT>{0.2 * 7, 0.4 * 4, 0.6 * 5}));
+  network.transform_weights([](WeightT w) { return w / 2; });
+  REQUIRE(network.get_edge_weight(0, 1) == 1.0);
+
+  // With a hash index, removed edges are no longer found
+  network.set_hash_index(2);
+  REQUIRE(network.connection_exists(4, 0));
+  REQUIRE(network.threshold_weights(0.85) == 4);
+  REQUIRE(network.n_edges() == 3);
+  REQUIRE_THAT(network.get_neighbours(0),
+               Catch::Matchers::RangeEquals(std::vector<size_t>{2}));
+  REQUIRE_THAT(network.get_neighbours(4),
+               Catch::Matchers::RangeEquals(std::vector<size_t>{1}));
+  REQUIRE(!network.connection_exists(4, 0));
+  REQUIRE(network.connection_exists(4, 1));
+  REQUIRE(network.get_neighbours(2).empty());
+  REQUIRE(network.threshold_weights(0.85) == 0);
+}
+
+TEST_CASE("Weight operations on undirected and bidirectional networks") {
+  using namespace Graph;
+  using WeightT = double;
+
+  SECTION("Both halves of an undirected edge are thresholded together") {
+    auto network = UndirectedNetwork<WeightT>(4);
+    network.push_back_neighbour_and_weight(0, 1, 1.0);
+    network.push_back_neighbour_and_weight(1, 2, 0.1);
+    network.push_back_neighbour_and_weight(2, 3, 2.0);
+    REQUIRE(network.threshold_weights(0.5) == 2);
+    REQUIRE(network.n_edges() == 2);
+    REQUIRE(!network.connection_exists(1, 2));
+    REQUIRE(!network.connection_exists(2, 1));
+  }
+
+  SECTION("The incoming copies of a bidirectional network follow") {
+    auto network = BidirectionalNetwork<WeightT>(3);
+    network.push_back_neighbour_and_weight(0, 1, 1.0);
+    network.push_back_neighbour_and_weight(0, 2, 3.0);
+    network.push_back_neighbour_and_weight(2, 1, 0.1);
+
+    network.normalize_rows();
+    REQUIRE_THAT(network.get_in_weights(2),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{0.75}));
+    REQUIRE_THAT(network.get_in_weights(1),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{0.25, 1.0}));
+
+    network.scale_weights(0.5);
+    REQUIRE(network.threshold_weights(0.2) == 1);
+    REQUIRE_THAT(network.get_in_neighbours(1),
+                 Catch::Matchers::RangeEquals(std::vector<size_t>{2}));
+    REQUIRE_THAT(network.get_in_weights(1),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{0.5}));
+    REQUIRE_THAT(network.get_in_weights(2),
+                 Catch::Matchers::RangeEquals(std::vector<WeightT>{0.375}));
+  }
+}
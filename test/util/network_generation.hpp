@@ -64,7 +64,6 @@ DirectedNetwork<AgentType> generate_fully_connected(size_t n_agents,
       0.0, 1.0); // Values don't matter, will be normalized
   auto incoming_neighbour_weights = std::vector<WeightT>(
       n_agents); // Vector of weights of the j neighbours of i
-  WeightT outgoing_norm_weight = 0;
 
   // Create the incoming_neighbour_buffer once. This will contain all agents,
   // including itself
@@ -75,19 +74,9 @@ DirectedNetwork<AgentType> generate_fully_connected(size_t n_agents,
   // Loop through all the agents and create the neighbour_list and weight_list
   for (size_t i_agent = 0; i_agent < n_agents; ++i_agent) {
 
-    outgoing_norm_weight = 0.0;
-
     // Initialize the weights
     for (size_t j = 0; j < n_agents; ++j) {
       incoming_neighbour_weights[j] = dis(gen); // Draw the weight
-      outgoing_norm_weight += incoming_neighbour_weights[j];
-    }
-
-    // ---------
-    // Normalize the weights so that the row sums to 1
-    // Might be specific to the DeGroot model?
-    for (size_t j = 0; j < incoming_neighbour_buffer.size(); ++j) {
-      incoming_neighbour_weights[j] /= outgoing_norm_weight;
     }
 
     // Add the neighbour vector for i_agent to the neighbour list
@@ -97,8 +86,13 @@ DirectedNetwork<AgentType> generate_fully_connected(size_t n_agents,
 
   } // end of loop through n_agents
 
-  return DirectedNetworkT(std::move(neighbour_list), std::move(weight_list),
-                          DirectedNetworkT::EdgeDirection::Incoming);
+  auto network =
+      DirectedNetworkT(std::move(neighbour_list), std::move(weight_list),
+                       DirectedNetworkT::EdgeDirection::Incoming);
+  // Normalize the weights so that every row sums to 1
+  // Might be specific to the DeGroot model?
+  network.normalize_rows();
+  return network;
 }
 
 /* Constructs a new network on a square lattice of edge length n_edge (with